@@ -122,6 +122,7 @@ layout(push_constant) uniform PushConstants {
     mat4 view;                    // 16-byte aligned, 64 bytes (4x4 matrix)
     mat4 proj;                    // 16-byte aligned, 64 bytes (4x4 matrix)
     mat4 viewProj;
+    uint firstDrawCommand;        // the frame's slice of the draw commands
 } pushConstants;
 
 struct Polygon                    // Total: 12 bytes
@@ -238,7 +239,7 @@ vec4 getPosition(uint side, uint blockId)
 }
 
 void main() {
-    DrawCommand command = drawCommands[gl_DrawID];
+    DrawCommand command = drawCommands[pushConstants.firstDrawCommand + gl_DrawID];
     Indices indices = vertexBuffers[command.bufferId].indices[gl_InstanceIndex];
     
     //Always even amount of instances for cubes since each face is 2 instances
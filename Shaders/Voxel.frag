@@ -52,10 +52,10 @@ struct Chunk                       // Total: 48 bytes
     uint padding;                  // 4 bytes
 };
 
-struct Indices {
-    uint polygon;
-    uint coloring;
-    uint block;
+//two triangles of one face, see QuadRecord in MeshData.h
+struct QuadRecord {
+    uint polygonExtent;           // polygon 22 bits, extent 8 bits, bit 30 when both triangles are drawn
+    uint coloringBlock;           // coloring 20 bits, voxel index within the chunk 12 bits
 };
 
 struct DrawCommand {
@@ -65,6 +65,7 @@ struct DrawCommand {
     uint firstInstance;
 
     uint bufferId;
+    uint chunkIndex;
 };
 
 layout(set = 0, binding = 0, std430) readonly buffer Vertices {
@@ -111,7 +112,7 @@ layout(set = 1, binding = 2, std430) readonly buffer DrawCommands {
 };
 
 layout(set = 2, binding = 0, std430) readonly buffer VertexBuffers {
-    Indices indices[];
+    QuadRecord quads[];
 } vertexBuffers[];
 
 layout(set = 3, binding = 0) uniform Config {
@@ -131,6 +132,9 @@ vec4 adjustContrast(vec4 color, float contrast) {
 }
 
 void main() {
-    vec4 texColor = texture(textures[textureId], UV);
+    //Voxel.vert carries the uvs of merged quads past [0, 1], one unit per voxel, they are wrapped here
+    //so the sampler's address mode does not matter, the gradients of the unwrapped uvs keep the
+    //mip level steady across the seams
+    vec4 texColor = textureGrad(textures[textureId], fract(UV), dFdx(UV), dFdy(UV));
     outColor = adjustContrast(texColor, config.contrast);
 }
\ No newline at end of file
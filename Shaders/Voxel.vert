@@ -25,6 +25,7 @@ layout(push_constant) uniform PushConstants {
     mat4 view;                    // 16-byte aligned, 64 bytes (4x4 matrix)
     mat4 proj;                    // 16-byte aligned, 64 bytes (4x4 matrix)
     mat4 viewProj;
+    uint firstDrawCommand;        // the frame's slice of the draw commands
 } pushConstants;
 
 struct Polygon                    // Total: 12 bytes
@@ -82,10 +83,10 @@ layout(set = 0, binding = 6, std430) readonly buffer ColoringIndexCache {
     uint coloringIndices[];       // 4-byte stride per element
 };
 
-struct Indices {
-    uint polygon;
-    uint coloring;
-    uint block;
+//two triangles of one face, see QuadRecord in MeshData.h
+struct QuadRecord {
+    uint polygonExtent;           // polygon 22 bits, extent 8 bits, bit 30 when both triangles are drawn
+    uint coloringBlock;           // coloring 20 bits, voxel index within the chunk 12 bits
 };
 
 struct DrawCommand {
@@ -95,6 +96,7 @@ struct DrawCommand {
     uint firstInstance;
 
     uint bufferId;
+    uint chunkIndex;
 };
 
 //the pool
@@ -111,7 +113,7 @@ layout(set = 1, binding = 2, std430) readonly buffer DrawCommands {
 };
 
 layout(set = 2, binding = 0, std430) readonly buffer VertexBuffers {
-    Indices indices[];
+    QuadRecord quads[];
 } vertexBuffers[];
 
 layout(set = 3, binding = 0) uniform Config {
@@ -131,23 +133,77 @@ vec3 getBlockGlobalPosition(uint index, vec3 chunkCoordCorner)
     return chunkCoordCorner + pos; 
 }
 
-vec4 getPosition(uint polygonId, uint blockId, uint positionId)
+const uint polygonMask = (1u << 22) - 1;
+const uint extentShift = 22;
+const uint pairBit = 1u << 30;
+const uint coloringMask = (1u << 20) - 1;
+const uint blockShift = 20;
+
+//the axis the polygon faces along, greedy quads only come from axis aligned cube faces
+uint getPlaneAxis(vec3 normal)
 {
-    uint localBlockIndex = blockId % chunkSize;
-    uint chunkIndex = blockId / chunkSize;
-    vec4 vertexPos = vertices[polygons[polygonId].positions[positionId]];
-    vec3 blockPos = getBlockGlobalPosition(localBlockIndex, chunks[chunkIndex].coordCorner.xyz);
-    return vec4(vertexPos.xyz + blockPos, 1.0);
+    vec3 a = abs(normal);
+    if (a.x >= a.y && a.x >= a.z)
+        return 0;
+    return a.y >= a.z ? 1 : 2;
 }
 
 void main() {
-    DrawCommand command = drawCommands[gl_DrawID];
-    Indices indices = vertexBuffers[command.bufferId].indices[gl_InstanceIndex];
-    
-    vec4 finalPos = getPosition(indices.polygon, indices.block, gl_VertexIndex);
+    DrawCommand command = drawCommands[pushConstants.firstDrawCommand + gl_DrawID];
+    QuadRecord quad = vertexBuffers[command.bufferId].quads[gl_InstanceIndex];
+
+    //the second triangle of a record uses the next polygon and coloring, a record holding a lone
+    //triangle puts all three of its second triangle's vertices on one corner so nothing is rasterized
+    uint triangle = uint(gl_VertexIndex) / 3;
+    uint corner = uint(gl_VertexIndex) % 3;
+    if ((quad.polygonExtent & pairBit) == 0 && triangle == 1)
+    {
+        triangle = 0;
+        corner = 0;
+    }
+    uint polygonId = (quad.polygonExtent & polygonMask) + triangle;
+    uint coloringId = (quad.coloringBlock & coloringMask) + triangle;
+    uint extentBits = (quad.polygonExtent >> extentShift) & 0xFFu;
+
+    Polygon polygon = polygons[polygonId];
+    Coloring coloringData = colorings[coloringId];
+
+    vec3 vertexPos = vertices[polygon.positions[corner]].xyz;
+    UV = uvs[coloringData.uvs[corner]];
+
+    if (extentBits != 0)
+    {
+        //the two in-plane axes in increasing order, the mesher packs the extents in the same order
+        uint axis = getPlaneAxis(normals[polygon.normal].xyz);
+        uint axisU = axis == 0 ? 1 : 0;
+        uint axisV = axis == 2 ? 1 : 2;
+        vec2 extent = vec2(extentBits & 0xFu, (extentBits >> 4) & 0xFu);
+
+        vec2 planar[3];
+        vec2 uv[3];
+        for (uint i = 0; i < 3; ++i)
+        {
+            vec3 position = vertices[polygon.positions[i]].xyz;
+            planar[i] = vec2(position[axisU], position[axisV]);
+            uv[i] = uvs[coloringData.uvs[i]];
+        }
+
+        //vertices on the far side of the face move out to cover the whole quad
+        vec2 expanded = planar[corner] + vec2(
+            planar[corner].x > 0.0 ? extent.x : 0.0,
+            planar[corner].y > 0.0 ? extent.y : 0.0);
+        vertexPos[axisU] = expanded.x;
+        vertexPos[axisV] = expanded.y;
+
+        //uvs are affine over the triangle, extending that map past the face carries them past [0, 1]
+        //once per voxel, Voxel.frag wraps them back so the texture repeats with any sampler
+        mat2 toPlanar = mat2(planar[1] - planar[0], planar[2] - planar[0]);
+        mat2 toUv = mat2(uv[1] - uv[0], uv[2] - uv[0]);
+        UV = uv[0] + toUv * (inverse(toPlanar) * (expanded - planar[0]));
+    }
+
+    uint localBlockIndex = quad.coloringBlock >> blockShift;
+    vec4 finalPos = vec4(vertexPos + getBlockGlobalPosition(localBlockIndex, chunks[command.chunkIndex].coordCorner.xyz), 1.0);
     gl_Position = pushConstants.viewProj * finalPos;
-    
-    Coloring coloringData = colorings[indices.coloring];
-    UV = uvs[coloringData.uvs[gl_VertexIndex]];
     textureId = coloringData.textureId;
-}
\ No newline at end of file
+}
@@ -1,3 +1,4 @@
 "E:/Program Files (x86)/API/Vulkan/Bin/glslc.exe" Voxel.vert -o Voxel.vert.spv
 "E:/Program Files (x86)/API/Vulkan/Bin/glslc.exe" Voxel.frag -o Voxel.frag.spv
+"E:/Program Files (x86)/API/Vulkan/Bin/glslc.exe" Cube.vert -o Cube.vert.spv
 pause
\ No newline at end of file
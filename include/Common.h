@@ -2,6 +2,7 @@
 
 #include <stdexcept>
 #include <cstdint>
+#include <algorithm>
 #include <array>
 #include <set>
 #include <unordered_set>
@@ -11,14 +12,29 @@
 #include <vector>
 #include <filesystem>
 #include <utility>
+#include <atomic>
+#include <mutex>
 #include <shared_mutex>
 
+//headless builds (tools, benchmarks) get glm directly and no graphics or gui headers,
+//only code that does not touch the gpu may be compiled that way
+#ifdef VOXEL_ENGINE_HEADLESS
+#include <cassert>
+#include <limits>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/epsilon.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#else
 #include "imgui.h"
 #include "imgui_impl_vulkan.h"
 
 #include "Graphics/Graphics.h"
 
 namespace Gfx = Graphics;
+#endif
 
 template<typename E>
 inline constexpr std::underlying_type_t<E> enumCast(const E& enumObj) {
@@ -33,7 +49,7 @@ inline constexpr E enumCast(const T& obj) {
 template<typename T>
 requires std::is_arithmetic_v<T>
 inline std::pair<T, T> modDiv(T, T) {
-	static_assert(false, "This function is not implemented for this type");
+	static_assert(sizeof(T) == 0, "This function is not implemented for this type");
 }
 
 template<>
@@ -246,10 +262,12 @@ namespace Id
 		std::vector<std::string> m_names;
 		std::unordered_map<std::string, Id> m_nameToId;
 		mutable std::shared_mutex m_mutex;
+		std::atomic<bool> m_frozen = false;	//once set the cache never changes again and reads skip the lock
 
 	public:
 		Id add(T&& object, std::string_view nameView)
 		{
+			assert(!isFrozen() && "Named cache written after freeze");
 			std::unique_lock<std::shared_mutex> lock(m_mutex);
 			// Try to insert the name->id mapping first
 			auto [it, inserted] = m_nameToId.try_emplace(std::move(std::string(nameView)),
@@ -266,29 +284,31 @@ namespace Id
 		}
 
 		inline const T& get(Id id) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			assert(static_cast<Id::DataType>(id) < m_cache.size());
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline T& get(Id id) {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			assert(!isFrozen() && "Named cache written after freeze");
+			auto lock = readLock();
 			assert(static_cast<Id::DataType>(id) < m_cache.size());
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline const T& operator[](Id id) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline T& operator[](Id id) {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			assert(!isFrozen() && "Named cache written after freeze");
+			auto lock = readLock();
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline const T& operator[](const std::string& name) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			auto it = m_nameToId.find(name);
 			if (it == m_nameToId.end()) {
 				throw std::runtime_error("Asset not found: " + name);
@@ -297,7 +317,8 @@ namespace Id
 		}
 
 		inline T& operator[](const std::string& name) {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			assert(!isFrozen() && "Named cache written after freeze");
+			auto lock = readLock();
 			auto it = m_nameToId.find(name);
 			if (it == m_nameToId.end()) {
 				throw std::runtime_error("Asset not found: " + name);
@@ -306,7 +327,7 @@ namespace Id
 		}
 
 		inline Id getId(const std::string& name) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			auto it = m_nameToId.find(name);
 			if (it == m_nameToId.end()) {
 				throw std::runtime_error("Asset not found: " + name);
@@ -315,26 +336,46 @@ namespace Id
 		}
 
 		inline bool exists(const std::string& name) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_nameToId.contains(name);
 		}
 
 		inline size_t size() const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_cache.size();
 		}
 
 		inline const std::vector<T>& data() const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_cache;
 		}
 
 		inline void reserve(size_t size) {
+			assert(!isFrozen() && "Named cache written after freeze");
 			std::unique_lock<std::shared_mutex> lock(m_mutex);
 			m_cache.reserve(size);
 			m_names.reserve(size);
 			m_nameToId.reserve(size);
 		}
+
+		//makes the cache immutable, called once loading is done so concurrent readers stop
+		//contending on the lock, adding afterwards is a bug
+		void freeze() {
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_frozen.store(true, std::memory_order_release);
+		}
+
+		bool isFrozen() const { return m_frozen.load(std::memory_order_acquire); }
+
+	private:
+		//shared until frozen, after that readers take no lock at all, which is why the
+		//accessors handing out mutable references assert that the cache is not frozen yet
+		std::shared_lock<std::shared_mutex> readLock() const {
+			std::shared_lock<std::shared_mutex> lock(m_mutex, std::defer_lock);
+			if (!isFrozen())
+				lock.lock();
+			return lock;
+		}
 	};
 
 	template<typename T, typename Id, typename Comparator = std::equal_to<T>>
@@ -343,9 +384,11 @@ namespace Id
 	private:
 		std::vector<T> m_cache;
 		mutable std::shared_mutex m_mutex;
+		std::atomic<bool> m_frozen = false;	//once set the cache never changes again and reads skip the lock
 	public:
 		Id add(T&& object)
 		{
+			assert(!isFrozen() && "Cache written after freeze");
 			std::unique_lock<std::shared_mutex> lock(m_mutex);
 			auto it = std::find_if(m_cache.begin(), m_cache.end(),
 				[&object](const T& cached) {
@@ -360,6 +403,7 @@ namespace Id
 		}
 
 		Id add(const T& object) {
+			assert(!isFrozen() && "Cache written after freeze");
 			std::unique_lock<std::shared_mutex> lock(m_mutex);
 			auto it = std::find_if(m_cache.begin(), m_cache.end(),
 				[&object](const T& cached) {
@@ -373,41 +417,61 @@ namespace Id
 		}
 
 		inline const T& get(Id id) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			assert(static_cast<Id::DataType>(id) < m_cache.size());
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline T& get(Id id) {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			assert(!isFrozen() && "Cache written after freeze");
+			auto lock = readLock();
 			assert(static_cast<Id::DataType>(id) < m_cache.size());
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline const T& operator[](Id id) const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline T& operator[](Id id) {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			assert(!isFrozen() && "Cache written after freeze");
+			auto lock = readLock();
 			return m_cache[static_cast<Id::DataType>(id)];
 		}
 
 		inline size_t size() const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_cache.size();
 		}
 
 		inline const std::vector<T>& data() const {
-			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			auto lock = readLock();
 			return m_cache;
 		}
 
 		inline void reserve(size_t size) {
+			assert(!isFrozen() && "Cache written after freeze");
 			std::unique_lock<std::shared_mutex> lock(m_mutex);
 			m_cache.reserve(size);
 		}
+
+		//same as NamedCache::freeze
+		void freeze() {
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			m_frozen.store(true, std::memory_order_release);
+		}
+
+		bool isFrozen() const { return m_frozen.load(std::memory_order_acquire); }
+
+	private:
+		//same as NamedCache::readLock
+		std::shared_lock<std::shared_mutex> readLock() const {
+			std::shared_lock<std::shared_mutex> lock(m_mutex, std::defer_lock);
+			if (!isFrozen())
+				lock.lock();
+			return lock;
+		}
 	};
 
 	template<typename Metadata>
@@ -475,8 +539,13 @@ namespace Id
 		}
 
 		void reserveIndexData(size_t size) {
+			assert(!isFrozen() && "Index sequence cache written after freeze");
 			m_indices.reserve(size);
 		}
+
+		//the indices are read unlocked already, this freezes the entries
+		void freeze() { m_entries.freeze(); }
+		bool isFrozen() const { return m_entries.isFrozen(); }
 	};
 
 	template<typename Index, typename Comparator = std::equal_to<Index>, typename Metadata = void>
@@ -490,6 +559,7 @@ namespace Id
 	public:
 		EntryId add(const std::vector<Index>& sequence, Metadata metadata)
 		{
+			assert(!this->isFrozen() && "Index sequence cache written after freeze");
 			if (sequence.empty()) return this->m_entries.add(Entry{ 0, 0, metadata });
 			Entry entry;
 			entry.size = sequence.size();
@@ -530,6 +600,7 @@ namespace Id
 	public:
 		EntryId add(const std::vector<Index>& sequence)
 		{
+			assert(!this->isFrozen() && "Index sequence cache written after freeze");
 			if (sequence.empty()) return this->m_entries.add(Entry{ 0, 0 });
 			Entry entry;
 			entry.size = sequence.size();
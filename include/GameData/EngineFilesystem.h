@@ -17,20 +17,24 @@ public:
         Executable,
         Assets,
         Shaders,
+        Cache,
 
         Textures,
         Models,
         Voxels,
+        Generators,
 
         Count,
     };
 
 private:
     static inline const std::string s_defaultShaderDirectoryPath = "shaders";
+    static inline const std::string s_defaultCacheDirectoryPath = "cache";
     static inline const std::string s_defaultAssetDirectoryPath = "res/resourcePack";
     static inline const std::string s_defaultTextureDirectoryPath = "textures";
     static inline const std::string s_defaultModelDirectoryPath = "models";
     static inline const std::string s_defaultVoxelDirectoryPath = "voxels";
+    static inline const std::string s_defaultGeneratorDirectoryPath = "generators";
 
 
     std::array<std::filesystem::path, enumCast(Path::Count)> m_paths;
@@ -59,17 +63,21 @@ public:
         
         registerDirectory(Directory::Root, Directory::Assets, "assetDirectory", s_defaultAssetDirectoryPath, root);
         registerDirectory(Directory::Root, Directory::Shaders, "shaderDirectory", s_defaultShaderDirectoryPath, root);
+        registerDirectory(Directory::Root, Directory::Cache, "cacheDirectory", s_defaultCacheDirectoryPath, root);
         registerDirectory(Directory::Assets, Directory::Textures, "textureDirectory", s_defaultTextureDirectoryPath, root);
         registerDirectory(Directory::Assets, Directory::Models, "modelDirectory", s_defaultModelDirectoryPath, root);
         registerDirectory(Directory::Assets, Directory::Voxels, "voxelDirectory", s_defaultVoxelDirectoryPath, root);
+        registerDirectory(Directory::Assets, Directory::Generators, "generatorDirectory", s_defaultGeneratorDirectoryPath, root);
     }
 
     const auto& getRootDirectory() const { return m_directories[enumCast(Directory::Root)]; }    
     const auto& getShaderDirectory() const { return m_directories[enumCast(Directory::Shaders)]; }
+    const auto& getCacheDirectory() const { return m_directories[enumCast(Directory::Cache)]; }
     const auto& getAssetDirectory() const { return m_directories[enumCast(Directory::Assets)]; }
     const auto& getTextureDirectory() const { return m_directories[enumCast(Directory::Textures)]; }
     const auto& getModelDirectory() const { return m_directories[enumCast(Directory::Models)]; }
     const auto& getVoxelDirectory() const { return m_directories[enumCast(Directory::Voxels)]; }
+    const auto& getGeneratorDirectory() const { return m_directories[enumCast(Directory::Generators)]; }
 
     void printDirectories() {
         std::cout << "Engine directories: " << std::endl;
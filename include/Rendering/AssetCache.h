@@ -9,6 +9,7 @@
 
 #include "Rendering/StorageCache.h"
 #include "Rendering/VoxelCullingCache.h"
+#include "MultiThreading/ThreadPool.h"
 
 #include "GameData/EngineFilesystem.h"
 
@@ -77,6 +78,18 @@ public:
 
 	void registerAssets(const EngineFilesystem& engineFiles);
 
+	//makes every cache read only, reads from meshing threads stop taking locks afterwards
+	void freeze();
+
+	//clips the whole culling table on the pool instead of pair by pair while meshing, blocks until done
+	void buildCullingTable(MT::ThreadPool& pool);
+
+	//reuses the culling table saved for the same geometry, false if it has to be clipped again
+	bool loadCullingTable(const std::filesystem::path& path);
+
+	//only writes when pairs were clipped since the table was loaded or last saved
+	void saveCullingTable(const std::filesystem::path& path) const;
+
 	void registerVoxelModel(std::string_view path);
 
 	void registerTexture(std::string_view texturePath, std::string_view textureName);
@@ -116,6 +129,10 @@ public:
 		return m_polygonCache;
 	}
 
+	const auto& getNormalCache() const {
+		return m_normalCache;
+	}
+
 	const auto& getColoringCache() const {
 		return m_coloringCache;
 	}
@@ -158,6 +175,10 @@ public:
 		return m_polygonCache;
 	}
 
+	auto& getNormalCache() {
+		return m_normalCache;
+	}
+
 	auto& getColoringCache() {
 		return m_coloringCache;
 	}
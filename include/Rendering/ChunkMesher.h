@@ -0,0 +1,186 @@
+#pragma once
+#include "Common.h"
+#include "Rendering/Shape.h"
+#include "Rendering/MeshData.h"
+#include "Rendering/VoxelCullingCache.h"
+#include "GameData/Voxel.h"
+#include "WorldManagement/WorldGrid.h"
+
+#include <array>
+#include <vector>
+
+//everything meshing needs to know about a voxel state, flattened out of the asset caches once
+//so the hot loop reads a single entry and takes none of their locks
+struct alignas(32) StateRenderInfo
+{
+	Shape::GeometryId geometry = 0;
+	uint32_t geometryStart = 0;
+	uint32_t geometrySize = 0;
+	uint32_t appearanceStart = 0;
+	bool isFullCube = false;	//uses the standard cube geometry, culls and is culled by other full cubes per face
+	bool isEmpty = true;
+};
+
+static_assert(64 % sizeof(StateRenderInfo) == 0, "A state render info must never straddle a cache line");
+
+//turns the voxels of one chunk into polygon instances, has no graphics dependencies so it can be
+//built and benchmarked headless, the renderer only uploads what it produces
+class ChunkMesher
+{
+public:
+	//the caches meshing reads from, they must outlive the mesher and stay unchanged while meshing
+	struct Sources
+	{
+		const Id::NamedCache<Voxel::State, Id::VoxelState>* voxelStates = nullptr;
+		const Id::NamedCache<Shape::Model, Id::Model>* models = nullptr;
+		const Shape::PolygonIndexBuffer* geometries = nullptr;
+		const Shape::ColoringIndexBuffer* appearances = nullptr;
+		const VoxelCullingCache* culling = nullptr;
+		const Shape::PolygonCache* polygons = nullptr;
+		const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>* normals = nullptr;
+	};
+
+	//packed records are grouped by the side their face points to, indexed like Shape::Side,
+	//faces that are not axis aligned go into the last bucket which is always drawn
+	static inline const size_t s_directionBuckets = enumCast(Shape::Side::Count) + 1;
+	static inline const size_t s_unalignedBucket = enumCast(Shape::Side::Count);
+
+	//first record of every bucket, the last entry is the record count
+	using DirectionRanges = std::array<uint32_t, s_directionBuckets + 1>;
+
+	//key picks the mesh cache entry, check is a second independent hash a hit has to match too
+	struct InputHash
+	{
+		uint64_t key = 0;
+		uint64_t check = 0;
+	};
+
+	//bit per Shape::Side set when the chunk's boundary layer on that side holds full cubes only,
+	//s_solidInterior when every voxel of the chunk is a full cube
+	using Solidity = uint8_t;
+	static inline const Solidity s_solidFaces = (1 << enumCast(Shape::Side::Count)) - 1;
+	static inline const Solidity s_solidInterior = 1 << enumCast(Shape::Side::Count);
+
+	//bit per pair of sides joined by a path through the chunk that only crosses voxels which are not
+	//full cubes, so whether a view entering through one side can leave through the other
+	using Connectivity = uint16_t;
+	static inline const Connectivity s_fullyConnected = (1 << 15) - 1;
+
+	enum class Mode : uint8_t
+	{
+		PerFace,	//one instance per visible polygon
+		Greedy,		//coplanar full cube faces with the same appearance are merged into quads
+	};
+
+private:
+	//one row of voxels along x, bit x + 1 is the voxel at x, bits 0 and 17 are the neighbouring chunks
+	using Row = uint32_t;
+
+	static inline const size_t s_rowsPerAxis = Constants::chunkWidth + 2;
+	static inline const Row s_innerRowMask = ((Row(1) << Constants::chunkWidth) - 1) << 1;
+
+	static_assert(Constants::chunkWidth + 2 <= sizeof(Row) * 8, "A row with its apron must fit into Row");
+	static_assert(Constants::chunkSize <= (size_t(1) << (32 - QuadRecord::s_blockShift)),
+		"A voxel index within the chunk must fit into a quad record");
+	static_assert(Constants::chunkWidth == Constants::chunkHeight && Constants::chunkWidth == Constants::chunkDepth,
+		"Occupancy rows assume cubic chunks");
+
+	//rows indexed by (y + 1) * s_rowsPerAxis + z + 1, the outer rows hold the neighbouring chunks
+	struct Occupancy
+	{
+		std::array<Row, s_rowsPerAxis * s_rowsPerAxis> cube;
+		std::array<Row, s_rowsPerAxis * s_rowsPerAxis> other;
+	};
+
+	//visible full cube faces of one side, indexed by layer * chunkWidth + v with bit u set,
+	//the layer runs along the side's axis and u, v along the other two in increasing axis order
+	using FaceLayers = std::array<Row, Constants::chunkWidth * Constants::chunkWidth>;
+
+	static inline const StateRenderInfo s_unknownState = {};
+
+	Sources m_sources;
+	Mode m_mode = Mode::PerFace;
+
+	//indexed by state id, anything that is neither empty nor a full cube goes through the culling table
+	std::vector<StateRenderInfo> m_stateInfos;
+
+	//direction bucket of every polygon, indexed by polygon id
+	std::vector<uint8_t> m_polygonBuckets;
+
+	//standard cube polygons hidden by a full cube neighbour on each side, read from the culling table
+	std::array<VoxelCullingCache::BitMask, enumCast(Shape::Side::Count)> m_cubeCulledBy = {};
+	size_t m_cubePolygonCount = 0;
+	size_t m_cubeGeometryStart = 0;
+
+	//every standard cube polygon is hidden by exactly one side, so a side's polygons form its face
+	bool m_canMergeCubeFaces = false;
+
+public:
+	ChunkMesher() = default;
+
+	//flattens the registered voxel states, states added afterwards are not meshed until init runs again
+	void init(const Sources& sources);
+
+	bool isInitialized() const { return m_sources.culling != nullptr; }
+
+	void setMode(Mode mode) { m_mode = mode; }
+	Mode getMode() const { return m_mode; }
+	const auto& getStateInfos() const { return m_stateInfos; }
+
+	//appends the visible polygons of a chunk to out, safe to call concurrently for different outputs,
+	//full cube faces are culled with bit operations on occupancy rows, the rest uses the culling table
+	void mesh(const WorldGrid& grid, size_t chunkPoolIndex, IndexBuffer& out) const;
+
+	//culls every voxel through the culling table, produces the same output as mesh in per face mode,
+	//kept as the reference the fast path is checked against
+	void meshReference(const WorldGrid& grid, size_t chunkPoolIndex, IndexBuffer& out) const;
+
+	//pairs consecutive triangles of the same voxel into quad records, a triangle whose partner was
+	//culled or is not the next registered polygon gets a record of its own, the records are
+	//grouped by direction bucket and keep their meshing order within a bucket
+	void packQuads(const IndexBuffer& polygons, QuadBuffer& out, DirectionRanges& ranges) const;
+
+	//identifies everything a mesh depends on, the chunk's voxels, the touching layers of its
+	//neighbours and the mode, chunks with equal hashes get the same packed records
+	InputHash hashInput(const WorldGrid& grid, size_t chunkPoolIndex) const;
+
+	Solidity summarizeSolidity(const WorldGrid& grid, size_t chunkPoolIndex) const;
+
+	//flood fills the voxels that are not full cubes, a fully solid chunk connects nothing
+	Connectivity computeConnectivity(const WorldGrid& grid, size_t chunkPoolIndex) const;
+	static bool connects(Connectivity connectivity, Shape::Side from, Shape::Side to) {
+		return from == to || (connectivity & getConnectionBit(from, to)) != 0;
+	}
+	static Connectivity getConnectionBit(Shape::Side a, Shape::Side b);
+
+	//a solid chunk meshes to nothing once each neighbour shows it a solid face, neighbours are
+	//indexed by Shape::Side, a missing one should be passed as 0 since the border stays visible
+	static bool isEnclosed(Solidity chunk, const std::array<Solidity, enumCast(Shape::Side::Count)>& neighbours);
+
+	//false when every face of the bucket in the chunk points away from the camera, faces pointing
+	//along an axis lie on planes within the chunk bounds so only the nearest plane matters
+	static bool canFaceCamera(size_t bucket, glm::vec3 chunkCorner, glm::vec3 camera);
+
+private:
+	const StateRenderInfo& getStateInfo(Id::VoxelState state) const {
+		return static_cast<size_t>(state) < m_stateInfos.size() ? m_stateInfos[state] : s_unknownState;
+	}
+
+	static size_t rowIndex(size_t y, size_t z) { return y * s_rowsPerAxis + z; }
+
+	void setOccupied(Occupancy& occupancy, size_t row, size_t bit, Id::VoxelState state) const;
+	void buildOccupancy(const WorldGrid& grid, const WorldGrid::Chunk& chunk, Occupancy& occupancy) const;
+	//voxel within the neighbour on a side that touches the chunk, a and b run along the side's
+	//plane, y then z for left and right, y then x for front and back, z then x for top and bottom
+	static size_t getApronOffset(Shape::Side side, size_t a, size_t b);
+
+	//culls a single voxel through the culling table, the same output as VoxelCullingCache::populateBuffer
+	void meshVoxel(const WorldGrid& grid, const WorldGrid::Chunk& chunk, size_t block,
+		size_t x, size_t y, size_t z, IndexBuffer& out) const;
+	static Id::VoxelState getNeighbourState(const WorldGrid& grid, const WorldGrid::Chunk& chunk, size_t block,
+		size_t x, size_t y, size_t z, Shape::Side side);
+
+	static size_t getSideAxis(Shape::Side side);
+	void mergeFaces(const WorldGrid& grid, const WorldGrid::Chunk& chunk, Shape::Side side,
+		FaceLayers& faces, IndexBuffer& out) const;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include "Common.h"
+
+#include <array>
+
+//the six planes of a view projection with normals pointing inside, an empty frustum lets everything through
+struct Frustum
+{
+	std::array<glm::vec4, 6> planes = {};
+
+	//clip space depth is [0, 1] in vulkan, so the near plane is the third row alone
+	static Frustum fromViewProj(const glm::mat4& viewProj)
+	{
+		auto row = [&](int index) {
+			return glm::vec4(viewProj[0][index], viewProj[1][index], viewProj[2][index], viewProj[3][index]);
+			};
+
+		Frustum frustum;
+		frustum.planes = {
+			row(3) + row(0),
+			row(3) - row(0),
+			row(3) + row(1),
+			row(3) - row(1),
+			row(2),
+			row(3) - row(2),
+		};
+		for (auto& plane : frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+		return frustum;
+	}
+
+	//tests the sphere around the chunk, so a chunk near a corner of the frustum may pass while outside
+	bool containsChunk(glm::vec3 chunkCenter) const
+	{
+		static const float chunkRadius = glm::length(glm::vec3(Constants::chunkDimensions)) * 0.5f;
+		for (const auto& plane : planes)
+			if (glm::dot(glm::vec3(plane), chunkCenter) + plane.w < -chunkRadius)
+				return false;
+		return true;
+	}
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include "Rendering/ChunkMesher.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//packed meshes of recently meshed chunk contents keyed by ChunkMesher::hashInput, quad records only
+//hold voxels within the chunk so a mesh can be reused by every chunk with the same padded contents,
+//such as solid underground chunks or flat plains, the least recently used entries are evicted
+//once the memory budget is exceeded, an entry is only reused when the check hash matches as well
+//so a wrong mesh needs both 64 bit hashes to collide, thread safe
+class MeshCache
+{
+public:
+	struct Stats
+	{
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+		size_t collisions = 0;	//lookups whose key matched an entry of different contents
+		size_t entries = 0;
+		size_t memory = 0;		//in bytes, records and bookkeeping
+
+		float hitRate() const { return hits + misses == 0 ? 0.0f : static_cast<float>(hits) / (hits + misses); }
+	};
+
+private:
+	struct Entry
+	{
+		uint64_t key = 0;
+		uint64_t check = 0;
+		std::vector<QuadRecord> records;
+		ChunkMesher::DirectionRanges ranges = {};
+	};
+
+	//the list node and the map node around every entry
+	static inline const size_t s_entryOverhead = sizeof(Entry) + 2 * sizeof(void*) +
+		sizeof(std::pair<const uint64_t, std::list<Entry>::iterator>) + 2 * sizeof(void*);
+
+	size_t m_budget = 0;
+
+	//front is the most recently used
+	std::list<Entry> m_entries;
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> m_keyToEntry;
+	size_t m_memory = 0;
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+	size_t m_evictions = 0;
+	size_t m_collisions = 0;
+	mutable std::mutex m_lock;
+
+public:
+	explicit MeshCache(size_t budget = 0) : m_budget(budget) {}
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+	//evicts right away if the cache holds more than the new budget, 0 disables caching
+	void setBudget(size_t budget);
+	size_t getBudget() const;
+
+	//appends the cached records to out, counts a hit or a miss
+	bool find(const ChunkMesher::InputHash& hash, QuadBuffer& out, ChunkMesher::DirectionRanges& ranges);
+	//a mesh larger than the whole budget is not stored, neither is one whose key is taken
+	void store(const ChunkMesher::InputHash& hash, const QuadBuffer& records, const ChunkMesher::DirectionRanges& ranges);
+
+	void clear();
+	Stats getStats() const;
+
+private:
+	//expects m_lock to be held
+	void evict(size_t budget);
+	static size_t getEntryMemory(const Entry& entry) { return s_entryOverhead + entry.records.size() * sizeof(QuadRecord); }
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+#include "Utility/ScratchArena.h"
+
+//per polygon instance data produced by meshing, has no graphics dependencies so it
+//can be produced by headless code
+struct Indices {
+    uint32_t polygon;
+    uint32_t coloring;
+    uint32_t block;
+    //greedy quads, (width - 1) | (height - 1) << 4 along the two in-plane axes in increasing axis order,
+    //block is then the voxel at the smallest corner, 0 is a single face
+    uint32_t extent = 0;
+};
+
+//what is uploaded and drawn, one instance per face, the second triangle uses the polygon and coloring
+//ids right after the first one's, which is how faces are registered, the chunk comes from the draw command
+struct QuadRecord {
+    static constexpr uint32_t s_polygonBits = 22;
+    static constexpr uint32_t s_extentShift = 22;
+    static constexpr uint32_t s_pairBit = 1u << 30;
+    static constexpr uint32_t s_coloringBits = 20;
+    static constexpr uint32_t s_blockShift = 20;
+
+    uint32_t polygonExtent;     //polygon 22 bits, extent 8 bits, bit 30 when both triangles are drawn
+    uint32_t coloringBlock;     //coloring 20 bits, voxel index within the chunk 12 bits
+};
+
+static_assert(sizeof(QuadRecord) == 8, "A quad record must stay 8 bytes");
+
+//meshing output, the renderer backs it with a per thread arena, default constructed it uses the heap
+using IndexBuffer = ScratchVector<Indices>;
+using QuadBuffer = ScratchVector<QuadRecord>;
@@ -0,0 +1,106 @@
+#pragma once
+#include "Common.h"
+#include "Rendering/Frustum.h"
+
+#include "Utility/PriorityJobQueue.h"
+
+#include "MultiThreading/ThreadPool.h"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+//runs chunk meshing jobs on the thread pool, a chunk has at most one pending job and repeated
+//requests are folded into it, jobs are ordered by distance to the camera with chunks outside
+//the frustum behind all visible ones, jobs of chunks past the cancel distance are parked
+//and requeued once the camera comes back
+class MeshScheduler
+{
+public:
+	using Task = std::function<void(size_t threadId)>;
+	using Callback = std::function<void()>;
+	using Clock = std::chrono::steady_clock;
+
+	struct Settings
+	{
+		float cancelDistance = 12.0f;	//in chunks, pending jobs further away are parked
+	};
+
+	struct Stats
+	{
+		size_t pending = 0;
+		size_t running = 0;
+		size_t parked = 0;
+		size_t completed = 0;
+		size_t coalesced = 0;	//requests folded into a job that was already pending or running
+		size_t cancelled = 0;	//jobs parked because the camera moved away
+		float meanLatency = 0.0f;	//in milliseconds from the first request to the end of meshing,
+		float maxLatency = 0.0f;	//over the last s_latencyWindow jobs
+	};
+
+private:
+	struct Job
+	{
+		Task task;
+		std::vector<Callback> onDone;	//every request's callback, run after the task that picked them up
+		glm::vec3 center = glm::vec3(0.0f);
+		Clock::time_point requested;
+		bool pending = false;
+		bool running = false;
+		bool rerun = false;		//requested again while running, queued once the running job ends
+		bool parked = false;
+	};
+
+	static inline const float s_outsideFrustumPriority = 1e6f;
+	static inline const size_t s_latencyWindow = 256;
+
+	MT::ThreadPool* m_pool = nullptr;
+	Settings m_settings;
+
+	//indexed by chunk pool index, guarded by m_lock, the queue is only touched under it as well
+	//so a chunk cannot be popped twice while it is being meshed
+	std::vector<Job> m_jobs;
+	std::vector<size_t> m_parkedChunks;
+	PriorityJobQueue<size_t> m_queue;
+	mutable std::mutex m_lock;
+
+	Frustum m_frustum;
+	glm::vec3 m_cameraPosition = glm::vec3(0.0f);
+	bool m_hasView = false;
+
+	size_t m_running = 0;
+	size_t m_completed = 0;
+	size_t m_coalesced = 0;
+	size_t m_cancelled = 0;
+	std::array<float, s_latencyWindow> m_latencies = {};
+	size_t m_latencyCount = 0;
+
+public:
+	MeshScheduler() = default;
+	MeshScheduler(const MeshScheduler&) = delete;
+	MeshScheduler& operator=(const MeshScheduler&) = delete;
+
+	void init(MT::ThreadPool& pool, size_t chunkCount, const Settings& settings);
+	//takes effect with the next update
+	void setSettings(const Settings& settings);
+
+	//center is in world units, the latest task replaces the one of a job that has not started yet,
+	//onDone is kept across merged requests and runs on the worker once the chunk was meshed after it
+	void request(size_t chunkIndex, glm::vec3 center, Task task, Callback onDone = {});
+
+	//reorders the pending jobs for the new view and parks or requeues them by distance,
+	//called once per frame from the draw thread
+	void update(const glm::mat4& viewProj, glm::vec3 cameraPosition);
+
+	Stats getStats() const;
+
+private:
+	float priority(glm::vec3 center) const;
+	bool isFar(glm::vec3 center) const;
+	void pushTicket();
+	void runTicket(size_t threadId);
+	//expects m_lock to be held
+	void enqueue(size_t chunkIndex);
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include "Common.h"
+#include "Rendering/MeshData.h"
+#include "Utility/Histogram.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+//what meshing and uploading chunks cost, every thread records into a slot of its own without
+//locking and the slots are merged when read, shown in the overlay and dumped to json
+class MeshStats
+{
+public:
+	enum class Metric : uint8_t
+	{
+		MeshTime,		//microseconds from reading the chunk to holding its records, cache lookups included
+		AllocationTime,	//microseconds in the memory pool
+		UploadTime,		//microseconds of writing into the upload ring, waits for a full ring included
+		Triangles,		//per uploaded chunk
+		UploadBytes,	//per uploaded chunk, records and chunk header
+		Count,
+	};
+
+	enum class Counter : uint8_t
+	{
+		Uploaded,	//chunks that got records
+		Empty,		//chunks that meshed to nothing
+		Enclosed,	//chunks skipped for being solid behind solid neighbours
+		CacheHits,	//uploaded chunks whose records came from the mesh cache
+		Count,
+	};
+
+	struct Snapshot
+	{
+		std::array<Histogram, enumCast(Metric::Count)> histograms;
+		std::array<uint64_t, enumCast(Counter::Count)> counters = {};
+
+		const Histogram& get(Metric metric) const { return histograms[enumCast(metric)]; }
+		uint64_t get(Counter counter) const { return counters[enumCast(counter)]; }
+
+		//counters, then count, extremes, mean, percentiles and non empty buckets of every histogram
+		void writeJson(std::ostream& out) const;
+	};
+
+	static const char* getName(Metric metric);
+	static const char* getName(Counter counter);
+
+private:
+	struct Slot
+	{
+		std::array<AtomicHistogram, enumCast(Metric::Count)> histograms;
+		std::array<std::atomic<uint64_t>, enumCast(Counter::Count)> counters = {};
+	};
+
+	//slots are allocated apart so threads do not share cache lines
+	std::vector<std::unique_ptr<Slot>> m_slots;
+
+public:
+	MeshStats() = default;
+	MeshStats(const MeshStats&) = delete;
+	MeshStats& operator=(const MeshStats&) = delete;
+
+	//one slot per thread id, not safe while anything records
+	void init(size_t threadCount);
+
+	void record(size_t threadId, Metric metric, uint64_t value) {
+		m_slots[threadId]->histograms[enumCast(metric)].record(value);
+	}
+	void count(size_t threadId, Counter counter) {
+		m_slots[threadId]->counters[enumCast(counter)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Snapshot getSnapshot() const;
+	//samples recorded meanwhile may survive it in part
+	void reset();
+
+	//a record draws two triangles when it is a pair, one otherwise
+	static uint64_t countTriangles(const QuadBuffer& records);
+};
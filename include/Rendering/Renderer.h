@@ -4,6 +4,12 @@
 #include "Rendering/ShaderCache.h"
 #include "Rendering/StorageCache.h"
 #include "Rendering/ShaderLayoutDefinitions.h"
+#include "Rendering/ChunkMesher.h"
+#include "Rendering/MeshScheduler.h"
+#include "Rendering/MeshCache.h"
+#include "Rendering/MeshStats.h"
+#include "Rendering/StagingRing.h"
+#include "Rendering/VisibilityGraph.h"
 
 #include "GameData/ResourceCache.h"
 #include "GameData/EngineFilesystem.h"
@@ -44,6 +50,7 @@ private:
 		glm::mat4 view;
 		glm::mat4 proj;
 		glm::mat4 viewProj;
+		uint32_t firstDrawCommand;		//of the frame's slice of the draw commands buffer
 	};
 
 	struct RangeStarts
@@ -58,11 +65,46 @@ private:
 		Gfx::Semaphore imageAvailableSemaphore;
 		Gfx::Semaphore renderFinishedSemaphore;
 		Gfx::Fence inFlightFence;
+		//chunk uploads of the frame, submitted ahead of its draw
+		Gfx::CommandBuffer uploadCommandBuffer;
+		Gfx::Fence uploadFence;
+		uint64_t uploadBatch = 0;		//0 when the frame submitted no uploads
+		//pool regions whose chunks moved or were removed by the frame's uploads, earlier frames may
+		//still draw from them and this frame's copies may still write them, so they go back to the
+		//pool only once the frame's fence is waited on the next time around
+		std::vector<Gfx::MemoryManagement::MemoryPool::Allocation> freedAllocations;
 	};
 
 	struct PoolDrawCommand {
 		Gfx::DrawCommand drawCommand;
 		uint32_t bufferId;
+		uint32_t chunkIndex;	//quad records only hold the voxel within the chunk
+	};
+
+	//where a meshed chunk's records live, draw commands are rebuilt from these every frame
+	struct ChunkDraw {
+		uint32_t bufferId = 0;
+		uint32_t firstInstance = 0;
+		ChunkMesher::DirectionRanges ranges = {};
+		glm::vec3 corner = glm::vec3(0.0f);
+	};
+
+	//a chunk's records and header written into the upload ring by a worker, or the removal of
+	//its draw, applied by the draw thread in request order once the copies are recorded
+	struct PendingUpload
+	{
+		size_t chunkIndex = 0;
+		bool isMeshed = false;
+		ChunkDraw draw;
+		uint64_t ringSequence = 0;
+		size_t ringOffset = 0;		//records first, the chunk header at headerOffset after them
+		size_t recordBytes = 0;
+		size_t headerOffset = 0;
+		size_t poolBufferIndex = 0;
+		size_t poolOffset = 0;
+		//the chunk's previous region, freed through the frame that applies the upload
+		Gfx::MemoryManagement::MemoryPool::Allocation previous =
+			Gfx::MemoryManagement::MemoryPool::Allocation::getEmptyAllocation();
 	};
 
 	PushConstants m_pushConstants;
@@ -72,8 +114,16 @@ private:
 	float m_deltaTime = 0.0f;
 
 	static inline const size_t s_stagingMemorySize = 1024 * 1024;
-
-	static inline const size_t s_framesInFlight = 1;
+	//grows past this on denser chunks, MesherBenchmark prints the peak of its test terrain
+	static inline const size_t s_meshScratchSize = 256 * 1024;
+	static inline const size_t s_meshCacheBudget = 32 * 1024 * 1024;
+	static inline const uint64_t s_solidityKnown = 1 << 7;
+	static inline const size_t s_uploadRingSize = 16 * 1024 * 1024;
+	static inline const size_t s_uploadAlignment = 16;
+
+	//the cpu records the next frame while the gpu draws the last one, every frame
+	//draws from its own slice of the draw commands buffer
+	static inline const size_t s_framesInFlight = 2;
 	std::array<PerFrameObjects, s_framesInFlight> m_perFrameInFlightObjects;
 
 	Gfx::Wrappers::Instance m_instance;
@@ -116,6 +166,17 @@ private:
 	Gfx::MemoryMapping m_stagingMapping;
 	size_t m_stagingMemorySize = 0;
 
+	//UploadRingBenchmark covers the ring's space accounting, UploadRingVulkanTest replays the copies,
+	//barriers and upload fences of recordUploads and drawFrame on a device under the validation layers
+	Gfx::Memory m_uploadRingMemory;
+	Gfx::Buffer m_uploadRingBuffer;
+	Gfx::MemoryMapping m_uploadRingMapping;
+	StagingRing m_uploadRing;
+	std::mutex m_uploadLock;
+	std::vector<PendingUpload> m_pendingUploads;	//guarded by m_uploadLock
+	std::vector<PendingUpload> m_recordedUploads;	//draw thread only, swapped with the pending ones
+	std::vector<uint64_t> m_recordedSequences;
+
 	Gfx::Sampler m_sampler;
 	Gfx::Surface m_surface;
 
@@ -154,13 +215,35 @@ private:
 
 	
 	std::vector<Gfx::MemoryManagement::MemoryPool::Allocation> m_indexAllocations;
-	std::vector<std::vector<Indices>> m_stagingBuffers;
+	//per worker, reset at the start of every meshing job
+	struct MeshScratch
+	{
+		ScratchArena arena = ScratchArena(s_meshScratchSize);
+		size_t polygonPeak = 0;		//most polygons and records a job on this worker produced
+		size_t recordPeak = 0;
+	};
+	std::vector<MeshScratch> m_meshScratch;
+	ChunkMesher m_chunkMesher;
+	MeshCache m_meshCache{ s_meshCacheBudget };
+	//per chunk summary from ChunkMesher::summarizeSolidity, packed with the chunk version it was
+	//taken at as version << 8 | s_solidityKnown | summary, so it is rescanned only after a change
+	std::unique_ptr<std::atomic<uint64_t>[]> m_chunkSolidity;
+	//whether the chunk's last mesh job skipped it as enclosed, such a chunk is queued again
+	//when a neighbour's solid faces change since nothing else would remesh it
+	std::unique_ptr<std::atomic<bool>[]> m_chunkEnclosed;
+	MeshStats m_meshStats;
+	std::filesystem::path m_meshStatsPath;
+	MeshScheduler m_meshScheduler;
+	VisibilityGraph m_visibilityGraph;
+	std::vector<bool> m_visibleChunks;
 
 	std::mutex m_drawCommandLock;
-	std::mutex m_stagingBufferLock;
-	std::unordered_map<size_t, size_t> m_drawIndexToPoolIndex;
-	std::vector<size_t> m_chunkDrawIndices;
+	std::vector<ChunkDraw> m_chunkDraws;
 	size_t m_drawCommandAmount;
+	size_t m_drawnRecords = 0;
+	size_t m_meshedRecords = 0;
+	size_t m_drawnChunks = 0;
+	size_t m_meshedChunkCount = 0;
 
 	DebugConsole m_debugConsole;
 
@@ -186,17 +269,42 @@ public:
 	//GridMapping getGridMapping();
 	//ChunkMapping getChunkMapping();
 
-	void updateChunk(const ResourceCache& resources, size_t chunkIndex, const WorldGrid& grid, size_t threadId);
-	void updateChunkAsync(const ResourceCache& resources, size_t chunkIndex, const WorldGrid& grid);
+	//queued on the mesh scheduler, repeated requests for a chunk that was not meshed yet are merged,
+	//onMeshed runs on the worker after the chunk was meshed
+	void updateChunkAsync(const ResourceCache& resources, size_t chunkIndex, const WorldGrid& grid,
+		MeshScheduler::Callback onMeshed = {});
+	void setMeshSchedulerSettings(const MeshScheduler::Settings& settings) { m_meshScheduler.setSettings(settings); }
 
 	void unmeshChunk(size_t chunkPoolIndex);
 
+	//fails the uploads of mesh workers blocked on a full upload ring, which the stopped draw loop
+	//would never release, called before the thread pool is terminated
+	void cancelUploads() { m_uploadRing.cancel(); }
+
 	void dumpHandles();
 private:
 	void createLayouts();
 	void configureMemory();
 	void drawGui(const Gfx::Utility::CameraPerspective& camera);
 	void drawMemoryPoolVisualization(size_t chunkIndex);
+	void drawMeshStats();
+	//meshes on the calling worker, only reached through updateChunkAsync
+	void updateChunk(const ResourceCache& resources, size_t chunkIndex, const WorldGrid& grid, size_t threadId);
+	//one command per direction bucket of every meshed chunk the visibility graph reaches that can face the camera,
+	//written into the slice starting at firstCommand, m_chunkDraws is the source of truth for every frame
+	void writeDrawCommands(const glm::mat4& viewProj, glm::vec3 cameraPosition, size_t firstCommand);
+	//commands in one frame's slice of the draw commands buffer
+	size_t getFrameDrawCommandCapacity() const { return m_chunkCount * ChunkMesher::s_directionBuckets; }
+	//records the copies of every pending upload into the frame's upload command buffer and swaps
+	//their draws in, false when there was nothing to upload, expects m_drawLock to be held
+	bool recordUploads(PerFrameObjects& frame);
+	//returns the regions the frame deferred to the pool, expects the frame's fences to be waited on
+	void releaseFreedAllocations(PerFrameObjects& frame);
+	//expects m_drawLock to be held, waits for the device to go idle
+	void recreateSwapChain(const Gfx::Extent2D& extent);
+	//the cached summary of the chunk, recomputed if the chunk changed since it was taken,
+	//a recomputation that changes the solid faces queues the enclosed neighbours again
+	ChunkMesher::Solidity getSolidity(const ResourceCache& resources, const WorldGrid& grid, size_t chunkPoolIndex);
 
 	void onPoolBufferAlloc(Gfx::MemoryRef memory, Gfx::BufferRef buffer, size_t bufferIndex);
 };
@@ -2,6 +2,9 @@
 #include "Common.h"
 #include "GameData/EngineFilesystem.h"
 
+#include <filesystem>
+#include <stdexcept>
+
 class ShaderCache
 {
 public:
@@ -40,6 +43,7 @@ public:
         for (size_t i = 0; i < m_shaderFileNames.size(); ++i)
         {
             auto filePath = engineFiles.getFile(EngineFilesystem::Directory::Shaders, m_shaderFileNames[i]);
+            checkExists(filePath);
             m_shaderModuleData.shaderCodes[i] = Graphics::ShaderModule::parseShaderCodeSPIRV(filePath.string());
             m_shaderModuleData.shaderModuleCreateInfos[i].setShaderCode(m_shaderModuleData.shaderCodes[i]);
             m_shaderModuleData.shaderModules[i].create(device.getFunctionTable(), device, m_shaderModuleData.shaderModuleCreateInfos[i]);
@@ -85,5 +89,13 @@ public:
     {
         return Gfx::Utility::createShaderStageInfos(m_shaderModuleData);
     }
+
+private:
+    //the spir-v is a build output, the Shaders target rebuilds it whenever its glsl changes
+    static void checkExists(const std::filesystem::path& binaryPath)
+    {
+        if (!std::filesystem::exists(binaryPath))
+            throw std::runtime_error("Shader binary " + binaryPath.string() + " is missing, build the Shaders target");
+    }
 };
 
@@ -1,12 +1,7 @@
 #pragma once
 #include "Common.h"
 #include "Graphics/Graphics.h"
-
-struct Indices {
-    uint32_t polygon;
-    uint32_t coloring;
-    uint32_t block;
-};
+#include "Rendering/MeshData.h"
 
 struct VertexDefinitionPositionId : public Gfx::Utility::VertexDefinitionBase<VertexDefinitionPositionId> {
 public:
@@ -35,9 +30,9 @@ public:
 
 struct VertexDefinitionIndices : public Gfx::Utility::VertexDefinitionBase<VertexDefinitionIndices> {
 public:
-    using Type = Indices;
+    using Type = QuadRecord;
     static constexpr size_t s_bindingCount = 1;
-    static constexpr size_t s_attributeCount = 3;
+    static constexpr size_t s_attributeCount = 2;
     static constexpr size_t s_dataSize = sizeof(Type);
 
     static constexpr Gfx::VertexInputBindingDescription s_bindings[] = {
@@ -52,7 +47,7 @@ public:
         {
             1,                                      // location
             1,                                      // binding
-            Gfx::PixelFormat::R32Uint,                   // format
+            Gfx::PixelFormat::R32Uint,              // format
             0                                       // offset
         },
         {
@@ -61,12 +56,6 @@ public:
             Gfx::PixelFormat::R32Uint,              // format
             sizeof(uint32_t)                        // offset
         },
-        {
-            3,                                      // location
-            1,                                      // binding
-            Gfx::PixelFormat::R32Uint,              // format
-            sizeof(uint32_t) * 2                    // offset
-        },
     };
 };
 
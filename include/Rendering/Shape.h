@@ -26,6 +26,7 @@ public:
 		};
 	};
 
+#ifndef VOXEL_ENGINE_HEADLESS
 	template<size_t binding, size_t location>
 	struct PositionVertex : public Gfx::Utility::VertexDefinitionBase<PositionVertex<binding, location>> {
 	public:
@@ -97,6 +98,7 @@ public:
 			},
 		};
 	};
+#endif
 
 	enum class Side : uint8_t
 	{
@@ -390,6 +392,44 @@ public:
 		}
 	}
 
+	//the full unit cube, two polygons per side in side order, used by the culling fast paths
+	static GeometryId registerStandardCube(
+		Id::Cache<glm::vec4, Id::Vertex, VecEpsilonEqualComparator<glm::vec4>>& vertexCache,
+		Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>& normalCache,
+		Id::Cache<Shape::Polygon, Id::Polygon>& polygonCache,
+		PolygonIndexBuffer& geometryCache) {
+		std::vector<Id::Polygon> geometry;
+		std::vector<Id::Vertex> verticesInd;
+		Polygon polygon;
+
+		for (size_t i = 0; i < 6; i++) {
+			for (size_t j = 0; j < 6; j++)
+				verticesInd.push_back(vertexCache.add(s_conversionMatrices[i] * glm::vec4(
+					s_frontFacePositions[indices[j]].x,
+					s_frontFacePositions[indices[j]].y,
+					s_frontFacePositions[indices[j]].z,
+					1)));
+			polygon.position[0] = verticesInd[verticesInd.size() - 6];
+			polygon.position[1] = verticesInd[verticesInd.size() - 5];
+			polygon.position[2] = verticesInd[verticesInd.size() - 4];
+			polygon.normal = normalCache.add(glm::vec4(
+				Constants::directionsFloat3D[enumCast(static_cast<Directions3D>(i))], 0));
+
+			geometry.push_back(polygonCache.add(polygon));
+
+			polygon.position[0] = verticesInd[verticesInd.size() - 3];
+			polygon.position[1] = verticesInd[verticesInd.size() - 2];
+			polygon.position[2] = verticesInd[verticesInd.size() - 1];
+			polygon.normal = normalCache.add(glm::vec4(
+				Constants::directionsFloat3D[enumCast(static_cast<Directions3D>(i))], 0));
+
+			geometry.push_back(polygonCache.add(polygon));
+		}
+
+		return geometryCache.add(geometry, { GeometryType::Cube });
+	}
+
+#ifndef VOXEL_ENGINE_HEADLESS
 	static inline Gfx::Buffer indexBuffer;
 	static inline Gfx::Buffer positionBuffer;
 
@@ -398,6 +438,7 @@ public:
 
 	static inline const Gfx::Buffer& getIndexBuffer() { return indexBuffer; };
 	static inline const Gfx::Buffer& getPositionBuffer() { return positionBuffer; };
+#endif
 		
 	//rotates scales and transposes a front face vertex
 	static void transformFaceVertex(glm::vec4& vertex, glm::vec3 dimentions, glm::vec3 position, Side side)
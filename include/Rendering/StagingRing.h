@@ -0,0 +1,85 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+
+//hands out space of a persistently mapped staging buffer to any number of threads, the space goes
+//back in allocation order once the batch that copied out of it retired, so writers never wait
+//on the gpu unless the ring is full, has no graphics dependencies so it can be tested headless
+class StagingRing
+{
+public:
+	struct Region
+	{
+		size_t offset = 0;
+		std::byte* data = nullptr;
+		uint64_t sequence = 0;		//identifies the region when it is handed to closeBatch
+	};
+
+	struct Stats
+	{
+		size_t used = 0;		//in bytes, skipped ends and padding included
+		size_t capacity = 0;
+		size_t peak = 0;
+		size_t waits = 0;		//allocations that found the ring full
+		uint64_t batches = 0;
+	};
+
+private:
+	struct Span
+	{
+		size_t end = 0;
+		size_t charge = 0;		//bytes taken from the ring, the skipped end of a wrapped region included
+		uint64_t batch = 0;		//0 until the region was handed to a batch
+		bool isRetired = false;
+	};
+
+	std::byte* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_head = 0;
+	size_t m_tail = 0;
+	size_t m_used = 0;
+
+	//every region that was not given back yet in allocation order, the front one has m_frontSequence
+	std::deque<Span> m_spans;
+	uint64_t m_frontSequence = 0;
+	uint64_t m_nextBatch = 1;
+
+	size_t m_peak = 0;
+	size_t m_waits = 0;
+	bool m_isCancelled = false;
+	mutable std::mutex m_lock;
+	std::condition_variable m_released;
+
+public:
+	StagingRing() = default;
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+
+	//not safe while anything is allocated
+	void init(std::byte* data, size_t size);
+
+	//blocks while the ring is full, false once the ring was cancelled, alignment must be
+	//a power of two, throws if the size could never fit
+	bool allocate(size_t size, size_t alignment, Region& region);
+	//false instead of blocking
+	bool tryAllocate(size_t size, size_t alignment, Region& region);
+	//wakes every blocked allocation and fails it and every later one until the next init,
+	//so writers waiting on a gpu that stopped retiring batches can finish
+	void cancel();
+
+	//tags the regions whose copies are about to be submitted, returns the batch to retire
+	//once the gpu is done with them, regions not tagged yet stay allocated past it
+	uint64_t closeBatch(std::span<const uint64_t> sequences);
+	//gives back the space of every batch up to this one
+	void retire(uint64_t batch);
+
+	Stats getStats() const;
+
+private:
+	//expects m_lock to be held
+	bool place(size_t size, size_t alignment, Region& region);
+};
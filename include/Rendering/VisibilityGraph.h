@@ -0,0 +1,67 @@
+#pragma once
+#include "Common.h"
+#include "Rendering/ChunkMesher.h"
+#include "Rendering/Frustum.h"
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+//chunks linked through their faces with the connectivity of the air inside them, a walk from the
+//camera's chunk only crosses a chunk between faces its air joins and never turns back against a
+//direction it already took, so chunks behind solid terrain and caves out of sight are not reached,
+//indexed by chunk pool index, thread safe
+class VisibilityGraph
+{
+public:
+	static inline const uint32_t s_noChunk = WorldGrid::noChunkIndex;
+	using Neighbours = std::array<uint32_t, enumCast(Shape::Side::Count)>;
+
+private:
+	struct Node
+	{
+		Neighbours neighbours = makeUnlinked();
+		glm::vec3 corner = glm::vec3(0.0f);
+		//a chunk that was not set yet is passed through freely, its neighbours may already be drawn
+		ChunkMesher::Connectivity connectivity = ChunkMesher::s_fullyConnected;
+		bool isSet = false;
+	};
+
+	struct Step
+	{
+		uint32_t chunk = 0;
+		uint8_t entered = 0;		//the side of the chunk the walk came in through
+		uint8_t directions = 0;		//bit per Shape::Side the walk moved along so far
+		glm::vec3 center = glm::vec3(0.0f);
+	};
+
+	static inline const uint8_t s_noSide = enumCast(Shape::Side::Count);
+
+	std::vector<Node> m_nodes;
+	std::vector<Step> m_queue;
+	mutable std::mutex m_lock;
+
+public:
+	VisibilityGraph() = default;
+	VisibilityGraph(const VisibilityGraph&) = delete;
+	VisibilityGraph& operator=(const VisibilityGraph&) = delete;
+
+	void init(size_t chunkCount);
+
+	//neighbours are pool indices indexed by Shape::Side, s_noChunk for missing ones,
+	//the neighbours are linked back to the chunk as well
+	void setChunk(size_t chunkIndex, glm::vec3 corner, ChunkMesher::Connectivity connectivity, const Neighbours& neighbours);
+
+	//marks the chunks that may be seen from the camera within the frustum, returns false and
+	//leaves visible alone when the camera is not inside a chunk that was set
+	bool findVisible(const Frustum& frustum, glm::vec3 cameraPosition, std::vector<bool>& visible);
+
+private:
+	static Neighbours makeUnlinked() {
+		Neighbours neighbours;
+		neighbours.fill(s_noChunk);
+		return neighbours;
+	}
+	//expects m_lock to be held
+	size_t findCameraChunk(glm::vec3 cameraPosition) const;
+};
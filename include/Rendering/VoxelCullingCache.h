@@ -1,11 +1,17 @@
 #pragma once
 #include <vector>
+#include <functional>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
 
 #include "Shape.h"
 #include "GameData/Voxel.h"
 #include "WorldManagement/WorldGrid.h"
-#include "ShaderLayoutDefinitions.h"
+#include "MeshData.h"
 #include "Math/LinearAlgebra.h"
+#include "Utility/MappedFile.h"
 
 #include "clipper2/clipper.h"
 
@@ -15,11 +21,71 @@ class VoxelCullingCache
 {
 public:
 	using BitMask = uint32_t; //shows which polygons to remove
-	using CullingId = Id::IndexSequenceCache<BitMask>::EntryId;
+
+	//runs task(0) .. task(taskCount - 1) on any threads and returns once all of them finished
+	using TaskRunner = std::function<void(size_t taskCount, const std::function<void(size_t)>& task)>;
 
 private:
-	Id::IndexSequenceCache<BitMask> m_cullings;
-	std::vector<CullingId> m_cullingIds;
+	//mask words live in fixed size segments that never move, so published ids stay valid
+	//while other threads append new masks
+	static inline const size_t s_segmentBits = 16;
+	static inline const size_t s_segmentSize = size_t(1) << s_segmentBits;
+	static inline const size_t s_maxSegments = 4096;
+
+	//every pair starts out with the narrow table and moves to the wide one once a mask id no
+	//longer fits, the largest value of each width marks a pair that was not clipped yet
+	using NarrowId = uint16_t;
+	using WideId = uint32_t;
+	static inline const WideId s_unknownId = std::numeric_limits<WideId>::max();
+	static inline const NarrowId s_unknownNarrowId = std::numeric_limits<NarrowId>::max();
+
+	//bump whenever what a mask means changes, files written by older code are rebuilt
+	static inline const uint32_t s_fileMagic = 0x54435856;	//"VXCT"
+	static inline const uint32_t s_fileVersion = 2;
+
+	//followed by pairCount wide mask ids in table order and maskCount masks of maskStride words
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t contentHash;
+		uint64_t pairCount;
+		uint64_t maskCount;
+		uint64_t maskStride;
+	};
+
+	//the caches pairs are clipped from, they are frozen after loading so clipping takes no locks
+	const Shape::PolygonIndexBuffer* m_geometries = nullptr;
+	const Id::Cache<Shape::Polygon, Id::Polygon>* m_polygons = nullptr;
+	const Id::Cache<glm::vec4, Id::Vertex, VecEpsilonEqualComparator<glm::vec4>>* m_vertices = nullptr;
+	const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>* m_normals = nullptr;
+
+	//bounding box per geometry, pairs that cannot reach each other are skipped without clipping
+	std::vector<std::array<glm::vec3, 2>> m_geometryBounds;
+
+	//mask id per (side, main, adjacent) pair, every mask takes m_maskStride words so the id
+	//shifted by the stride is its first word, the wide table stays null until it is needed and
+	//the narrow one is kept until the next init since readers may still hold it
+	size_t m_pairCount = 0;
+	mutable std::unique_ptr<std::atomic<NarrowId>[]> m_narrowIds;
+	mutable std::unique_ptr<std::atomic<WideId>[]> m_wideIdStorage;
+	mutable std::atomic<std::atomic<WideId>*> m_wideIds = nullptr;
+
+	//segment views point either into m_segments or into the mapped file the table was loaded from
+	mutable std::array<std::unique_ptr<BitMask[]>, s_maxSegments> m_segments;
+	mutable std::array<const BitMask*, s_maxSegments> m_segmentViews = {};
+	MappedFile m_mapping;
+	mutable std::map<std::vector<BitMask>, WideId> m_maskIds;	//identical masks share one id
+	mutable size_t m_maskCount = 0;
+	size_t m_maskStrideBits = 0;
+	mutable std::mutex m_computeMutex;	//guards appending, reads never take it
+	mutable std::atomic<size_t> m_computedPairs = 0;
+	mutable size_t m_savedPairs = 0;
+	bool m_analyticFastPath = true;
+
+	//hash of everything the masks are clipped from, a saved table is only loaded if it matches
+	uint64_t m_contentHash = 0;
+
 	size_t m_geometryAmount;
 	size_t m_geometryAmountSquared;
 
@@ -27,9 +93,9 @@ private:
 
 	Shape::GeometryId m_standardBlockGeometryId;
 
-	CullingId m_noCullingId;
-	size_t m_noCullingIndex;
 public:
+	//only sizes the pair table, masks are clipped lazily the first time meshing meets a pair,
+	//the caches must outlive this one and not change afterwards
 	void init(const Shape::PolygonIndexBuffer& geometries,
 		const Id::Cache<Shape::Polygon, Id::Polygon>& polygons,
 		const Id::Cache<glm::vec4, Id::Vertex, VecEpsilonEqualComparator<glm::vec4>>& vertices,
@@ -40,13 +106,61 @@ public:
 		const Id::Cache<Shape::Polygon, Id::Polygon>& polygons,
 		const Id::Cache<glm::vec4, Id::Vertex, VecEpsilonEqualComparator<glm::vec4>>& vertices,
 		const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>& normals,
-		Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side);
+		Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side) const;
+
+	//clips every pair up front, call it right after init, the masks are stored in table order
+	//so their starts come out the same however the runner schedules the tasks
+	void buildAll(const TaskRunner& run);
+
+	//triangles facing a single triangle or a rectangle split in two are tested directly and only
+	//other overlaps go through Clipper2, turning it off is only useful to check the fast path
+	void setAnalyticFastPath(bool enabled) { m_analyticFastPath = enabled; }
 
-	const auto& getCullings() const { return m_cullings; };
+	//maps a table saved for the same caches and publishes its pairs, call it right after init,
+	//false if the file is missing, damaged or was saved for different assets
+	bool load(const std::filesystem::path& path);
+
+	//writes every pair clipped so far, pairs that were never needed stay unknown and are
+	//clipped lazily after the next load, safe to call while meshing
+	bool save(const std::filesystem::path& path) const;
+
+	bool hasUnsavedPairs() const { return getComputedPairCount() != m_savedPairs; }
+	uint64_t getContentHash() const { return m_contentHash; }
+
+	Shape::GeometryId getStandardBlockGeometryId() const { return m_standardBlockGeometryId; }
+
+	//index of the first mask word for the pair, clipped on first use and published lock free,
+	//safe to call from any number of meshing threads
+	size_t getCullingStart(Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side) const {
+		size_t cell = m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + geometryAdj;
+		WideId id = readId(cell, std::memory_order_acquire);
+		return id != s_unknownId ? size_t(id) << m_maskStrideBits : computeCulling(geometryMain, geometryAdj, side, cell);
+	}
+
+	//mask id 0 is the canonical all zero mask, every pair that hides nothing and every empty
+	//neighbour points at it
+	static size_t getNoCullingStart() { return 0; }
+
+	BitMask getMaskWord(size_t index) const { return m_segmentViews[index >> s_segmentBits][index & (s_segmentSize - 1)]; }
+
+	//bits of the main geometry polygons hidden by the adjacent geometry on the given side
+	BitMask getCullingMask(Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj,
+		Shape::Side side, size_t word = 0) const {
+		return getMaskWord(getCullingStart(geometryMain, geometryAdj, side) + word);
+	}
+
+	size_t getPairCount() const { return m_pairCount; }
+	size_t getComputedPairCount() const { return m_computedPairs.load(std::memory_order_relaxed); }
+	size_t getMaskCount() const;
+	size_t getMaskWordCount() const;
+	bool usesWideIds() const { return m_wideIds.load(std::memory_order_acquire) != nullptr; }
+
+	//the pair table and the mask words, the narrow table is not counted once it was replaced
+	size_t getMemoryUsage() const;
 
 	void populateBuffer(size_t block, size_t x, size_t y, size_t z,
 		const WorldGrid::Chunk& chunk,
-		const WorldGrid& grid, std::vector<Indices>& indices,
+		const WorldGrid& grid, IndexBuffer& indices,
 		const Id::NamedCache<Voxel::State, Id::VoxelState>& voxelStates,
 		const Id::NamedCache<Shape::Model, Id::Model>& modelCache,
 		const Shape::PolygonIndexBuffer::EntryCache& geometryEntries,
@@ -54,6 +168,21 @@ public:
 		const Shape::PolygonIndexBuffer& geometries, const Shape::ColoringIndexBuffer& appearances) const;
 
 private:
+	bool canTouch(Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side) const;
+	size_t computeCulling(Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj,
+		Shape::Side side, size_t cell) const;
+	WideId readId(size_t cell, std::memory_order order) const {
+		if (auto wide = m_wideIds.load(std::memory_order_acquire))
+			return wide[cell].load(order);
+		NarrowId id = m_narrowIds[cell].load(order);
+		return id != s_unknownNarrowId ? id : s_unknownId;
+	}
+
+	//both called under m_computeMutex or before any reader exists
+	void publishId(size_t cell, WideId id) const;
+	WideId storeMask(std::vector<BitMask> mask) const;
+	void resetStorage();
+	uint64_t computeContentHash() const;
 
 	inline void clipPolygon(size_t i, glm::vec3 adjOffset,
 		const Shape::PolygonIndexBuffer::Entry entryMain, const Shape::PolygonIndexBuffer::Entry& entryAdj,
@@ -63,17 +192,16 @@ private:
 		const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>& normals,
 		std::vector<BitMask>& result) const;
 
-	inline std::array<VoxelCullingCache::CullingId, enumCast(Shape::Side::Count)> getCullingIndices(
+	inline std::array<size_t, enumCast(Shape::Side::Count)> getCullingIndices(
 		size_t block, size_t x, size_t y, size_t z, Shape::GeometryId geometryMain,
 		const WorldGrid::Chunk& chunk, const WorldGrid& grid,
 		const Id::NamedCache<Voxel::State, Id::VoxelState>& voxelStates,
 		const Id::NamedCache<Shape::Model, Id::Model>& modelCache) const;
 
 	template <Shape::Side side>
-	inline VoxelCullingCache::CullingId getCullingIndex(
+	inline size_t getCullingIndex(
 		size_t block, size_t x, size_t y, size_t z, Shape::GeometryId geometryMain,
 		const WorldGrid::Chunk& chunk, const WorldGrid& grid,
-		const Id::IndexSequenceCache<BitMask>::EntryCache& cullingEntries,
 		const Id::NamedCache<Voxel::State, Id::VoxelState>& voxelStates,
 		const Id::NamedCache<Shape::Model, Id::Model>& modelCache) const
 	{
@@ -85,8 +213,7 @@ private:
 			{
 				auto adj = chunk.neighbourStarts[enumCast(Shape::Side::Front)];
 				if (adj == WorldGrid::noChunkIndex)
-					return m_noCullingId;
-					//return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + m_standardBlockGeometryId]].start;
+					return getNoCullingStart();
 				adjState = voxelGrid[adj + y * Constants::chunkLayerSize + 15 * Constants::chunkDepth + x];
 			}
 			else adjState = voxelGrid[block - Constants::chunkWidth];
@@ -97,8 +224,7 @@ private:
 			{
 				auto adj = chunk.neighbourStarts[enumCast(Shape::Side::Back)];
 				if (adj == WorldGrid::noChunkIndex)
-					return m_noCullingId;
-					//return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + m_standardBlockGeometryId]].start;
+					return getNoCullingStart();
 				adjState = voxelGrid[adj + y * Constants::chunkLayerSize + x];
 			}
 			else adjState = voxelGrid[block + Constants::chunkWidth];
@@ -109,8 +235,7 @@ private:
 			{
 				auto adj = chunk.neighbourStarts[enumCast(Shape::Side::Left)];
 				if (adj == WorldGrid::noChunkIndex)
-					return m_noCullingId;
-					//return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + m_standardBlockGeometryId]].start;
+					return getNoCullingStart();
 				adjState = voxelGrid[adj + y * Constants::chunkLayerSize + z * Constants::chunkDepth + 15];
 			}
 			else adjState = voxelGrid[block - 1];
@@ -121,8 +246,7 @@ private:
 			{
 				auto adj = chunk.neighbourStarts[enumCast(Shape::Side::Right)];
 				if (adj == WorldGrid::noChunkIndex)
-					return m_noCullingId;
-					//return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + m_standardBlockGeometryId]].start;
+					return getNoCullingStart();
 				adjState = voxelGrid[adj + y * Constants::chunkLayerSize + z * Constants::chunkDepth];
 			}
 			else adjState = voxelGrid[block + 1];
@@ -133,8 +257,7 @@ private:
 			{
 				auto adj = chunk.neighbourStarts[enumCast(Shape::Side::Bottom)];
 				if (adj == WorldGrid::noChunkIndex)
-					return m_noCullingId;
-					//return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + m_standardBlockGeometryId]].start;
+					return getNoCullingStart();
 				adjState = voxelGrid[adj + 15 * Constants::chunkLayerSize + z * Constants::chunkDepth + x];
 			}
 			else adjState = voxelGrid[block - Constants::chunkLayerSize];
@@ -145,8 +268,7 @@ private:
 			{
 				auto adj = chunk.neighbourStarts[enumCast(Shape::Side::Top)];
 				if (adj == WorldGrid::noChunkIndex)
-					return m_noCullingId;
-					//return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + m_standardBlockGeometryId]].start;
+					return getNoCullingStart();
 				adjState = voxelGrid[adj + z * Constants::chunkDepth + x];
 			}
 			else adjState = voxelGrid[block + Constants::chunkLayerSize];
@@ -154,9 +276,9 @@ private:
 		else static_assert(side >= Shape::Side::Count && "invalid side index");
 
 		if(adjState == Constants::emptyStateId)
-			return m_noCullingIndex;
+			return getNoCullingStart();
 		auto& geom = modelCache[voxelStates[adjState].m_model].geometry;
-		return cullingEntries[m_cullingIds[m_sideOffsets[enumCast(side)] + m_geometryAmount * geometryMain + geom]].start;
+		return getCullingStart(geometryMain, geom, side);
 	}
 
 //	const std::vector<SideData>& getVoxelData(Id::VoxelModel main, Id::VoxelModel adj, Shape::Side side) const;
@@ -0,0 +1,115 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+//incremental 64 bit FNV-1a, stable across runs and platforms with the same endianness,
+//used for keys that are persisted to disk
+class Fnv1a
+{
+public:
+    static inline const uint64_t s_offsetBasis = 0xcbf29ce484222325ull;
+    static inline const uint64_t s_prime = 0x100000001b3ull;
+
+private:
+    uint64_t m_hash = s_offsetBasis;
+
+public:
+    Fnv1a() = default;
+
+    Fnv1a& addBytes(const void* data, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash ^= bytes[i];
+            m_hash *= s_prime;
+        }
+        return *this;
+    }
+
+    //only for types without padding, structs should be hashed field by field
+    template<typename T>
+    Fnv1a& add(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be hashed");
+        return addBytes(&value, sizeof(T));
+    }
+
+    Fnv1a& add(std::string_view value) {
+        add<uint64_t>(value.size());
+        return addBytes(value.data(), value.size());
+    }
+
+    Fnv1a& add(const char* value) { return add(std::string_view(value)); }
+
+    uint64_t get() const { return m_hash; }
+};
+
+//hashes whole 64 bit words on four independent lanes, several times faster than Fnv1a on large
+//inputs such as chunk contents, words are read in native byte order so the result must not be persisted,
+//adding the same bytes in differently sized pieces gives different hashes
+class WordHash
+{
+public:
+    static inline const uint64_t s_wordMultiplier = 0x9e3779b97f4a7c15ull;
+    static inline const uint64_t s_laneMultiplier = 0xbf58476d1ce4e5b9ull;
+
+private:
+    uint64_t m_lanes[4] = { 0x243f6a8885a308d3ull, 0x13198a2e03707344ull, 0xa4093822299f31d0ull, 0x082efa98ec4e6c89ull };
+    uint64_t m_length = 0;
+
+public:
+    WordHash() = default;
+
+    WordHash& addBytes(const void* data, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        uint64_t words[4];
+        size_t i = 0;
+        for (; i + sizeof(words) <= size; i += sizeof(words)) {
+            std::memcpy(words, bytes + i, sizeof(words));
+            for (size_t lane = 0; lane < 4; ++lane)
+                mix(lane, words[lane]);
+        }
+        for (size_t lane = 0; i < size; i += sizeof(uint64_t), ++lane) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes + i, size - i < sizeof(word) ? size - i : sizeof(word));
+            mix(lane, word);
+        }
+        m_length += size;
+        return *this;
+    }
+
+    template<typename T>
+    WordHash& add(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be hashed");
+        return addBytes(&value, sizeof(T));
+    }
+
+    uint64_t get() const {
+        uint64_t hash = m_length * s_wordMultiplier;
+        for (auto lane : m_lanes)
+            hash = std::rotl(hash ^ lane, 27) * s_laneMultiplier;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    //folds the lanes in the opposite order with other constants, independent of get() unless the
+    //whole 256 bit state collides, for confirming a match of get() without comparing the input
+    uint64_t getCheck() const {
+        uint64_t hash = m_length * s_laneMultiplier;
+        for (size_t lane = 4; lane-- > 0;)
+            hash = std::rotl(hash ^ m_lanes[lane], 41) * s_wordMultiplier;
+        hash ^= hash >> 29;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    void mix(size_t lane, uint64_t word) {
+        m_lanes[lane] = std::rotl(m_lanes[lane] ^ (word * s_wordMultiplier), 29) * s_laneMultiplier;
+    }
+};
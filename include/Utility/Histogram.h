@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+//log linear buckets as in HdrHistogram, values below s_subBuckets get a bucket each and every
+//power of two above is split into s_subBuckets equal buckets, so a value is off by at most
+//1 / s_subBuckets of itself, values past s_maxValue land in the last bucket
+class HistogramLayout
+{
+public:
+    static inline const size_t s_subBucketBits = 5;
+    static inline const size_t s_subBuckets = size_t(1) << s_subBucketBits;
+    static inline const size_t s_maxValueBits = 40;
+    static inline const uint64_t s_maxValue = (uint64_t(1) << s_maxValueBits) - 1;
+    static inline const size_t s_bucketCount = s_subBuckets + (s_maxValueBits - s_subBucketBits) * s_subBuckets;
+
+    static size_t getBucket(uint64_t value) {
+        value = std::min(value, s_maxValue);
+        if (value < s_subBuckets)
+            return static_cast<size_t>(value);
+        size_t shift = std::bit_width(value) - 1 - s_subBucketBits;
+        return s_subBuckets + shift * s_subBuckets + static_cast<size_t>((value >> shift) - s_subBuckets);
+    }
+
+    //the smallest value that falls into the bucket
+    static uint64_t getLowerBound(size_t bucket) {
+        if (bucket < s_subBuckets)
+            return bucket;
+        size_t shift = (bucket - s_subBuckets) / s_subBuckets;
+        return (s_subBuckets + (bucket - s_subBuckets) % s_subBuckets) << shift;
+    }
+
+    static uint64_t getUpperBound(size_t bucket) {
+        return bucket + 1 < s_bucketCount ? getLowerBound(bucket + 1) - 1 : s_maxValue;
+    }
+};
+
+//a plain copy of an AtomicHistogram to query and merge, min and max are exact
+class Histogram
+{
+private:
+    std::array<uint64_t, HistogramLayout::s_bucketCount> m_counts = {};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    uint64_t m_max = 0;
+
+    friend class AtomicHistogram;
+
+public:
+    void record(uint64_t value) {
+        ++m_counts[HistogramLayout::getBucket(value)];
+        ++m_count;
+        m_sum += value;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < m_counts.size(); ++i)
+            m_counts[i] += other.m_counts[i];
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    uint64_t getCount() const { return m_count; }
+    uint64_t getSum() const { return m_sum; }
+    uint64_t getMin() const { return m_count == 0 ? 0 : m_min; }
+    uint64_t getMax() const { return m_max; }
+    double getMean() const { return m_count == 0 ? 0.0 : static_cast<double>(m_sum) / m_count; }
+    uint64_t getBucketCount(size_t bucket) const { return m_counts[bucket]; }
+
+    //the upper bound of the bucket holding the value at the quantile, clamped to the exact extremes
+    uint64_t getPercentile(double percentile) const {
+        if (m_count == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(m_count));
+        rank = std::clamp<uint64_t>(rank, 1, m_count);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); ++i) {
+            seen += m_counts[i];
+            if (seen >= rank)
+                return std::clamp(HistogramLayout::getUpperBound(i), m_min, m_max);
+        }
+        return m_max;
+    }
+};
+
+//records from any number of threads without locking, every field is a relaxed atomic
+//so a snapshot taken while recording may be off by the samples in flight
+class AtomicHistogram
+{
+private:
+    std::array<std::atomic<uint64_t>, HistogramLayout::s_bucketCount> m_counts = {};
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<uint64_t> m_sum = 0;
+    std::atomic<uint64_t> m_min = std::numeric_limits<uint64_t>::max();
+    std::atomic<uint64_t> m_max = 0;
+
+public:
+    AtomicHistogram() = default;
+    AtomicHistogram(const AtomicHistogram&) = delete;
+    AtomicHistogram& operator=(const AtomicHistogram&) = delete;
+
+    void record(uint64_t value) {
+        m_counts[HistogramLayout::getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t min = m_min.load(std::memory_order_relaxed);
+        while (value < min && !m_min.compare_exchange_weak(min, value, std::memory_order_relaxed));
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+    }
+
+    void addTo(Histogram& histogram) const {
+        Histogram copy;
+        for (size_t i = 0; i < m_counts.size(); ++i)
+            copy.m_counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        copy.m_count = m_count.load(std::memory_order_relaxed);
+        copy.m_sum = m_sum.load(std::memory_order_relaxed);
+        copy.m_min = m_min.load(std::memory_order_relaxed);
+        copy.m_max = m_max.load(std::memory_order_relaxed);
+        histogram.merge(copy);
+    }
+
+    void reset() {
+        for (auto& count : m_counts)
+            count.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <utility>
+
+//read only view of a whole file mapped into memory, the view stays valid until close or destruction,
+//the file may be renamed or replaced meanwhile, on windows only by moving it away first
+class MappedFile
+{
+private:
+    const void* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+            m_file = std::exchange(other.m_file, nullptr);
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+    //false if the file is missing, empty or cannot be mapped, a previous mapping is closed first
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const void* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+//a lock free multi producer queue, producers push single entries and a consumer
+//takes everything that is pending at once, entries are handed out in push order,
+//push, empty and drain are sequentially consistent so a caller that pushes and then reads
+//another flag can't miss a drainer that writes that flag and then drains, as in WorldGrid
+template<typename T>
+class PendingEditQueue
+{
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> m_head = nullptr;
+
+public:
+    PendingEditQueue() = default;
+    PendingEditQueue(const PendingEditQueue&) = delete;
+    PendingEditQueue& operator=(const PendingEditQueue&) = delete;
+
+    ~PendingEditQueue() { clear(); }
+
+    void push(T value) {
+        Node* node = new Node{ std::move(value), m_head.load(std::memory_order_relaxed) };
+        while (!m_head.compare_exchange_weak(node->next, node,
+            std::memory_order_seq_cst, std::memory_order_relaxed));
+    }
+
+    bool empty() const { return m_head.load(std::memory_order_seq_cst) == nullptr; }
+
+    //detaches every pending entry and calls func on each of them, returns the amount consumed,
+    //concurrent drains never see the same entry twice
+    template<typename Func>
+    size_t drain(Func&& func) {
+        Node* node = m_head.exchange(nullptr, std::memory_order_seq_cst);
+
+        //the stack is newest first, reversing it restores push order
+        Node* reversed = nullptr;
+        while (node != nullptr) {
+            Node* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (reversed != nullptr) {
+            Node* next = reversed->next;
+            func(reversed->value);
+            delete reversed;
+            reversed = next;
+            ++count;
+        }
+        return count;
+    }
+
+    void clear() { drain([](const T&) {}); }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <set>
+#include <mutex>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+
+//a thread safe priority queue that holds at most one pending job per key,
+//pushing an already pending key coalesces it and keeps the more urgent priority,
+//lower priority values are popped first, equal priorities are popped in push order
+template<typename Key, typename Priority = float, typename Hash = std::hash<Key>>
+class PriorityJobQueue
+{
+private:
+    std::set<std::pair<Priority, size_t>> m_ordered;
+    std::unordered_map<size_t, std::pair<Key, Priority>> m_entries;
+    std::unordered_map<Key, size_t, Hash> m_keyToEntry;
+    size_t m_nextEntry = 0;
+    mutable std::mutex m_mutex;
+
+public:
+    PriorityJobQueue() = default;
+    PriorityJobQueue(const PriorityJobQueue&) = delete;
+    PriorityJobQueue& operator=(const PriorityJobQueue&) = delete;
+
+    //returns true if the key was not pending before
+    bool push(const Key& key, Priority priority) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_keyToEntry.find(key);
+        if (it != m_keyToEntry.end()) {
+            auto& entry = m_entries.at(it->second);
+            if (!(priority < entry.second)) return false;
+            m_ordered.erase({ entry.second, it->second });
+            entry.second = priority;
+            m_ordered.insert({ priority, it->second });
+            return false;
+        }
+        size_t id = m_nextEntry++;
+        m_entries.insert({ id, { key, priority } });
+        m_keyToEntry.insert({ key, id });
+        m_ordered.insert({ priority, id });
+        return true;
+    }
+
+    //replaces the priority even if the new one is less urgent
+    void reprioritize(const Key& key, Priority priority) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_keyToEntry.find(key);
+        if (it == m_keyToEntry.end()) return;
+        auto& entry = m_entries.at(it->second);
+        m_ordered.erase({ entry.second, it->second });
+        entry.second = priority;
+        m_ordered.insert({ priority, it->second });
+    }
+
+    //cancels a pending job, jobs that were already popped are not affected
+    bool remove(const Key& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_keyToEntry.find(key);
+        if (it == m_keyToEntry.end()) return false;
+        auto entryIt = m_entries.find(it->second);
+        m_ordered.erase({ entryIt->second.second, it->second });
+        m_entries.erase(entryIt);
+        m_keyToEntry.erase(it);
+        return true;
+    }
+
+    bool tryPop(Key& key, Priority& priority) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ordered.empty()) return false;
+        auto first = m_ordered.begin();
+        auto entryIt = m_entries.find(first->second);
+        key = entryIt->second.first;
+        priority = entryIt->second.second;
+        m_keyToEntry.erase(key);
+        m_entries.erase(entryIt);
+        m_ordered.erase(first);
+        return true;
+    }
+
+    bool contains(const Key& key) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_keyToEntry.find(key) != m_keyToEntry.end();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_keyToEntry.size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ordered.clear();
+        m_entries.clear();
+        m_keyToEntry.clear();
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+//bump allocator for memory that lives for one job, frees are ignored and everything is released
+//at once by reset, an allocation that does not fit takes a new block from the heap, reset then
+//replaces the blocks with a single one as large as the most the arena ever held,
+//so after a few jobs a thread stops touching the heap, not thread safe
+class ScratchArena
+{
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    static inline const size_t s_blockGranularity = 64 * 1024;
+
+    std::vector<Block> m_blocks;
+    size_t m_offset = 0;        //into the last block
+    size_t m_used = 0;          //by blocks before the last one, they are not reused until reset
+    size_t m_highWaterMark = 0;
+    size_t m_growthCount = 0;
+
+public:
+    explicit ScratchArena(size_t initialSize = 0) {
+        if (initialSize > 0) addBlock(initialSize);
+    }
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+    ScratchArena(ScratchArena&&) = default;
+    ScratchArena& operator=(ScratchArena&&) = default;
+
+    //alignment is at most that of operator new, blocks come from it
+    void* allocate(size_t size, size_t alignment) {
+        if (!m_blocks.empty()) {
+            auto& block = m_blocks.back();
+            size_t start = (m_offset + alignment - 1) & ~(alignment - 1);
+            if (start + size <= block.size) {
+                m_offset = start + size;
+                return block.data.get() + start;
+            }
+        }
+
+        //the fallback path, the old block keeps what was handed out of it until reset
+        ++m_growthCount;
+        m_used += m_offset;
+        size_t lastSize = m_blocks.empty() ? 0 : m_blocks.back().size;
+        addBlock(std::max(lastSize * 2, size));
+        m_offset = size;
+        return m_blocks.back().data.get();
+    }
+
+    void reset() {
+        m_highWaterMark = std::max(m_highWaterMark, m_used + m_offset);
+        if (m_blocks.size() > 1) {
+            m_blocks.clear();
+            addBlock(m_highWaterMark);
+        }
+        m_offset = 0;
+        m_used = 0;
+    }
+
+    //bytes in use since the last reset, alignment padding included
+    size_t getUsed() const { return m_used + m_offset; }
+    size_t getHighWaterMark() const { return std::max(m_highWaterMark, getUsed()); }
+    size_t getCapacity() const {
+        size_t capacity = 0;
+        for (const auto& block : m_blocks) capacity += block.size;
+        return capacity;
+    }
+    //allocations that did not fit into the current block since the arena was created
+    size_t getGrowthCount() const { return m_growthCount; }
+
+private:
+    void addBlock(size_t size) {
+        size = (size + s_blockGranularity - 1) / s_blockGranularity * s_blockGranularity;
+        m_blocks.push_back(Block{ std::make_unique<std::byte[]>(size), size });
+    }
+};
+
+//hands out arena memory to standard containers, without an arena it falls back to the heap
+//so containers that are not on the hot path can share the same type
+template<typename T>
+class ArenaAllocator
+{
+private:
+    ScratchArena* m_arena = nullptr;
+
+    template<typename U>
+    friend class ArenaAllocator;
+
+public:
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    explicit ArenaAllocator(ScratchArena& arena) : m_arena(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena) {}
+
+    T* allocate(size_t count) {
+        if (m_arena == nullptr)
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        if (m_arena == nullptr)
+            ::operator delete(pointer, count * sizeof(T));
+    }
+
+    ScratchArena* getArena() const { return m_arena; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.m_arena; }
+};
+
+template<typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
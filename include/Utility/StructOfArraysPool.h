@@ -80,7 +80,7 @@ public:
         inline const auto& getIndex() const { return m_index; };
 
         template <size_t index>
-        inline auto getEntryOffset() const { return m_index * PoolType<index>::amount; };
+        inline auto getEntryOffset() const { return m_index * PoolType<index>::amount; }
 
         template <size_t index>
         inline std::conditional_t<(amount<index> == 1),
@@ -89,7 +89,7 @@ public:
             if constexpr (amount<index> == 1)
                 return *std::get<index>(m_data);
             else return std::span<Type<index>>(std::get<index>(m_data), amount<index>);
-        };
+        }
 
         template <size_t index>
         inline std::conditional_t<(amount<index> == 1),
@@ -98,7 +98,7 @@ public:
             if constexpr (amount<index> == 1)
                 return *std::get<index>(m_data);
             else return std::span<const Type<index>>(std::get<index>(m_data), amount<index>);
-        };
+        }
     };
 
 private:
@@ -132,21 +132,21 @@ public:
         static_assert(index < s_fieldAmount,
             "Index must be less than field amount");
         return std::get<index>(m_fields);
-    };
+    }
 
     template <size_t index>
     inline const auto& getField() const {
         static_assert(index < s_fieldAmount,
             "Index must be less than field amount");
         return std::get<index>(m_fields);
-    };
+    }
 
     template <size_t index>
     inline auto getData(Allocation& alloc) {
         static_assert(index < s_fieldAmount,
             "Index must be less than field amount");
         return std::span(std::get<index>(m_fields).data() + alloc.offsets[index], s_amounts[index]);
-    };
+    }
 
     size_t getPoolSize() const { return m_poolSize; }
 
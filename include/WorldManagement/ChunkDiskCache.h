@@ -0,0 +1,67 @@
+#pragma once
+#include "Common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+//stores generated chunk terrain on disk, entries live in a directory named after the seed and
+//the generator parameter hash, so changing either makes old entries unreachable
+class ChunkDiskCache
+{
+public:
+	using SeedType = uint64_t;
+
+	struct Stats
+	{
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t stores = 0;
+		size_t rejected = 0;	//entries that existed but failed validation
+	};
+
+private:
+	static inline const uint32_t s_magic = 0x43435856;	//"VXCC"
+	static inline const uint32_t s_version = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t seed;
+		uint64_t parametersHash;
+		int32_t coords[3];
+		uint32_t voxelCount;
+	};
+
+	std::filesystem::path m_directory;
+	SeedType m_seed = 0;
+	uint64_t m_parametersHash = 0;
+	bool m_enabled = false;
+
+	std::atomic<size_t> m_hits = 0;
+	std::atomic<size_t> m_misses = 0;
+	std::atomic<size_t> m_stores = 0;
+	std::atomic<size_t> m_rejected = 0;
+
+public:
+	ChunkDiskCache() = default;
+	ChunkDiskCache(const ChunkDiskCache&) = delete;
+	ChunkDiskCache& operator=(const ChunkDiskCache&) = delete;
+
+	//entries for the same seed under a different parameter hash are stale and get removed
+	void init(const std::filesystem::path& root, SeedType seed, uint64_t parametersHash);
+
+	//both are safe to call concurrently for different chunks
+	bool load(glm::ivec3 chunkCoords, std::span<Id::VoxelState> blocks);
+	void store(glm::ivec3 chunkCoords, std::span<const Id::VoxelState> blocks);
+
+	bool isEnabled() const { return m_enabled; }
+	const auto& getDirectory() const { return m_directory; }
+	Stats getStats() const;
+
+private:
+	std::filesystem::path getEntryPath(glm::ivec3 chunkCoords) const;
+	static std::string getKeyName(SeedType seed, uint64_t parametersHash);
+};
@@ -5,9 +5,8 @@
 #include "Common.h"
 
 #include "WorldManagement/WorldGrid.h"
-
-#include "Mathematics/PerlinNoise2d.h"
-#include "Mathematics/PerlinNoise3d.h"
+#include "WorldManagement/NoiseGraph.h"
+#include "WorldManagement/ChunkDiskCache.h"
 
 #include <random>
 
@@ -22,15 +21,37 @@ public:
 		Num,
 	};
 
+	//a multi voxel feature placed on the surface, offsets are relative to the voxel above the ground
+	struct StructureVoxel
+	{
+		glm::ivec3 offset;
+		BlockTypes type;
+		bool onlyIntoAir;
+	};
+
+	struct Structure
+	{
+		std::vector<StructureVoxel> voxels;
+		float chance;	//chance of placement per attempt
+	};
+
 private:
 	using SeedType = uint64_t;
-	Math::PerlinNoise2d m_perlinNoise2d;
-	Math::PerlinNoise3d m_perlinNoise3d1;
-	Math::PerlinNoise3d m_perlinNoise3d2;
+
+	//structure anchors are picked from the chunk's own columns, so the
+	//outcome does not depend on the order in which chunks are generated
+	static inline const size_t s_structureAttemptsPerChunk = 2;
+
+	//bump whenever terrain generation changes in a way the parameter hash cannot see
+	static inline const uint32_t s_terrainVersion = 1;
+
+	//the terrain program outputs a block type per position, loaded from a json noise graph
+	NoiseProgram m_terrain;
+	std::vector<Structure> m_structures;
+	ChunkDiskCache* m_cache = nullptr;
 
 	Id::VoxelState m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Num)];
 
-	static const int32_t m_groundLevel = 200;
 	SeedType m_seed;
 public:
 	Generator();
@@ -39,11 +60,34 @@ public:
 
 	void set(SeedType seed);
 
-	bool shouldBeCave(int32_t x, int32_t y, int32_t z);
+	void setTerrain(NoiseProgram terrain);
+
+	//compiles the file's noise graph into the terrain and replaces the structures with its
+	//"structures" list, a file without the list places none
+	void loadFromFile(std::string_view path);
+
+	//the cache holds terrain before structures are placed, structures are always placed again
+	//since they write into neighbouring chunks
+	void setCache(ChunkDiskCache* cache) { m_cache = cache; }
+
+	//covers everything the cached terrain depends on apart from the seed
+	uint64_t getTerrainHash() const;
+
+	void addStructure(Structure structure) { m_structures.push_back(std::move(structure)); }
+	void clearStructures() { m_structures.clear(); }
+	static Structure makeBoulder(int32_t radius, float chance);
+	//{ "type": "Boulder", "radius": 3, "chance": 0.3 }
+	static Structure parseStructure(const Json::Value& value);
 
 	void setChunkData(WorldGrid& grid, size_t allocIndex);
 
 	void fillChunk(WorldGrid& grid, size_t allocIndex, BlockTypes type);
+
+private:
+	void generateTerrain(WorldGrid& grid, size_t allocIndex);
+
+	//writes inside the chunk are applied directly, writes into neighbours go through the grid edit queues
+	void placeStructures(WorldGrid& grid, size_t allocIndex);
 };
 
 #endif
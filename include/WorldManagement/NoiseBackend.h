@@ -0,0 +1,78 @@
+#pragma once
+#include "Common.h"
+
+#include "Mathematics/PerlinNoise2d.h"
+#include "Mathematics/PerlinNoise3d.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+//a source of fractal noise evaluated over batches of positions, results lie roughly in [-1, 1]
+class NoiseBackend
+{
+public:
+	using SeedType = uint64_t;
+
+	enum class Type : uint8_t
+	{
+		Perlin,
+		Value,
+		Num,
+	};
+
+	virtual ~NoiseBackend() = default;
+
+	virtual std::unique_ptr<NoiseBackend> clone() const = 0;
+	virtual Type getType() const = 0;
+
+	virtual void setSeed(SeedType seed) = 0;
+
+	virtual void fbm2d(const float* x, const float* z, float* out, size_t count,
+		uint32_t octaves, float frequency) = 0;
+	virtual void fbm3d(const float* x, const float* y, const float* z, float* out, size_t count,
+		uint32_t octaves, float frequency) = 0;
+
+	static std::unique_ptr<NoiseBackend> create(Type type);
+
+	static std::string_view typeToString(Type type);
+	static Type typeFromString(std::string_view name);
+};
+
+//the external perlin implementation, evaluated one sample at a time
+class PerlinNoiseBackend : public NoiseBackend
+{
+private:
+	Math::PerlinNoise2d m_noise2d;
+	Math::PerlinNoise3d m_noise3d;
+
+public:
+	std::unique_ptr<NoiseBackend> clone() const override { return std::make_unique<PerlinNoiseBackend>(*this); }
+	Type getType() const override { return Type::Perlin; }
+
+	void setSeed(SeedType seed) override;
+
+	void fbm2d(const float* x, const float* z, float* out, size_t count,
+		uint32_t octaves, float frequency) override;
+	void fbm3d(const float* x, const float* y, const float* z, float* out, size_t count,
+		uint32_t octaves, float frequency) override;
+};
+
+//hashed lattice value noise with quintic interpolation, the inner loops are branchless
+//and work on whole batches so the compiler can vectorize them
+class ValueNoiseBackend : public NoiseBackend
+{
+private:
+	uint32_t m_seed = 0;
+
+public:
+	std::unique_ptr<NoiseBackend> clone() const override { return std::make_unique<ValueNoiseBackend>(*this); }
+	Type getType() const override { return Type::Value; }
+
+	void setSeed(SeedType seed) override { m_seed = static_cast<uint32_t>(seed ^ (seed >> 32)); }
+
+	void fbm2d(const float* x, const float* z, float* out, size_t count,
+		uint32_t octaves, float frequency) override;
+	void fbm3d(const float* x, const float* y, const float* z, float* out, size_t count,
+		uint32_t octaves, float frequency) override;
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include "JsonParser/Value.h"
+#include "Common.h"
+
+#include "WorldManagement/NoiseBackend.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <string_view>
+#include <stdexcept>
+
+//a terrain recipe compiled from a json noise graph into a flat register based program,
+//every instruction works on a whole batch of positions at once
+class NoiseProgram
+{
+	friend class NoiseGraph;
+public:
+	using SeedType = NoiseBackend::SeedType;
+
+	//one batch is one chunk layer, columns are evaluated together
+	static inline const size_t s_batchSize = 256;
+
+	enum class OpCode : uint8_t
+	{
+		Constant,
+		CoordinateX,
+		CoordinateY,
+		CoordinateZ,
+		Noise2d,
+		Noise3d,
+		Fbm2d,
+		Fbm3d,
+		Add,
+		Sub,
+		Mul,
+		Min,
+		Max,
+		Clamp,
+		Threshold,
+		Select,
+		Num,
+	};
+
+	//instructions that do not depend on Y are hoisted and evaluated once per column batch
+	enum class Section : uint8_t
+	{
+		Invariant,
+		Varying,
+		Num,
+	};
+
+	struct Instruction
+	{
+		OpCode op;
+		uint16_t destination;
+		uint16_t sources[3];
+		uint16_t noise;		//index into the noise backends for noise and fbm opcodes
+		uint16_t octaves;
+		float value;		//constant value, threshold or noise frequency
+	};
+
+	//per thread scratch memory, one batch of floats per register
+	class Workspace
+	{
+		friend class NoiseProgram;
+	private:
+		std::vector<float> m_registers;
+
+	public:
+		float* getRegister(uint16_t reg) { return m_registers.data() + reg * s_batchSize; }
+		const float* getRegister(uint16_t reg) const { return m_registers.data() + reg * s_batchSize; }
+	};
+
+private:
+	struct NoiseSource
+	{
+		SeedType salt;
+		bool is3d;
+	};
+
+	std::vector<Instruction> m_instructions;
+	size_t m_sectionStarts[enumCast(Section::Num) + 1] = {};
+	std::vector<NoiseSource> m_noiseSources;
+	std::vector<std::unique_ptr<NoiseBackend>> m_noise;	//one backend instance per noise source
+	NoiseBackend::Type m_backendType = NoiseBackend::Type::Perlin;
+	SeedType m_seed = 0;
+	uint16_t m_registerCount = 0;
+	uint16_t m_output = 0;
+
+public:
+	NoiseProgram() = default;
+	NoiseProgram(const NoiseProgram& other);
+	NoiseProgram& operator=(const NoiseProgram& other);
+	NoiseProgram(NoiseProgram&& other) = default;
+	NoiseProgram& operator=(NoiseProgram&& other) = default;
+
+	void setSeed(SeedType seed);
+
+	//recreates every noise source with the given backend, the seed is kept
+	void setBackend(NoiseBackend::Type type);
+	NoiseBackend::Type getBackend() const { return m_backendType; }
+
+	void prepare(Workspace& workspace) const {
+		workspace.m_registers.resize(static_cast<size_t>(m_registerCount) * s_batchSize);
+	}
+
+	//runs one section of the program over count positions, count must not exceed the batch size
+	void run(Section section, const float* x, const float* y, const float* z,
+		size_t count, Workspace& workspace);
+
+	const float* getOutput(const Workspace& workspace) const { return workspace.getRegister(m_output); }
+
+	//identifies everything that affects the output apart from the seed
+	uint64_t getHash() const;
+
+	bool empty() const { return m_instructions.empty(); }
+	size_t getInstructionCount() const { return m_instructions.size(); }
+	size_t getRegisterCount() const { return m_registerCount; }
+	const std::vector<Instruction>& getInstructions() const { return m_instructions; }
+
+private:
+	template <typename Operation>
+	static inline void binary(const float* a, const float* b, float* out, size_t count, Operation&& operation)
+	{
+		for (size_t i = 0; i < count; ++i)
+			out[i] = operation(a[i], b[i]);
+	}
+};
+
+//parses a json noise graph, nodes reference each other by name, numbers and inline objects
+//are accepted wherever a node input is expected
+class NoiseGraph
+{
+public:
+	static NoiseProgram compile(const Json::Value& graph);
+	static NoiseProgram compileFromFile(std::string_view path);
+
+private:
+	struct Node
+	{
+		NoiseProgram::OpCode op;
+		std::vector<size_t> inputs;
+		float value = 0.0f;
+		uint16_t octaves = 1;
+		uint64_t salt = 0;
+		bool varying = false;
+	};
+
+	struct Builder
+	{
+		std::vector<Node> nodes;
+		std::unordered_map<std::string, size_t> namedNodes;
+		std::unordered_map<std::string, const Json::Value*> definitions;
+		std::unordered_map<std::string, bool> visiting;
+		std::unordered_map<uint32_t, size_t> constants;
+	};
+
+	static size_t parseInput(Builder& builder, const Json::Value& input);
+	static size_t parseNamed(Builder& builder, const std::string& name);
+	static size_t parseNode(Builder& builder, const Json::Value& node);
+	static size_t addConstant(Builder& builder, float value);
+	static NoiseProgram emit(const Builder& builder, size_t output, NoiseBackend::Type backend);
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include "Common.h"
+
+#include "WorldManagement/WorldGrid.h"
+#include "WorldManagement/Generator.h"
+#include "Rendering/Renderer.h"
+#include "GameData/ResourceCache.h"
+#include "Utility/PriorityJobQueue.h"
+
+#include "MultiThreading/ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//drives chunk generation on the thread pool and hands chunks whose neighbours are generated to
+//the renderer's mesh scheduler, chunks around the camera are requested with their distance as
+//priority, chunks in a cone along the camera velocity are requested at background priority
+//so they are ready before the camera reaches them
+class PregenerationScheduler
+{
+public:
+	struct Settings
+	{
+		float viewRadius = 8.0f;			//in chunks, chunks inside it are visible
+		float lookaheadTime = 2.0f;			//in seconds, how far ahead the camera motion is extrapolated
+		float maxLookahead = 8.0f;			//in chunks, caps the cone length at high speeds
+		float coneHalfAngle = 0.5f;			//in radians
+		float velocitySmoothingTime = 0.25f;	//in seconds
+		size_t maxBackgroundJobs = 4;		//background generation never occupies more workers than this
+	};
+
+	struct Stats
+	{
+		size_t hits = 0;			//chunks that were already meshed when they first became visible
+		size_t misses = 0;
+		size_t generated = 0;
+		size_t meshed = 0;
+		size_t pregenerated = 0;	//chunks meshed by background jobs
+		size_t pending = 0;			//chunks waiting for generation
+
+		float hitRate() const { return hits + misses == 0 ? 0.0f : static_cast<float>(hits) / (hits + misses); }
+	};
+
+private:
+	enum class ChunkState : uint8_t
+	{
+		Empty,
+		Generating,
+		Generated,
+		Meshing,
+		Meshed,
+	};
+
+	static inline const float s_backgroundPriority = 1e6f;
+	static inline const float s_notRequested = std::numeric_limits<float>::infinity();
+
+	WorldGrid* m_grid = nullptr;
+	Generator* m_generator = nullptr;
+	Renderer* m_renderer = nullptr;
+	const ResourceCache* m_resources = nullptr;
+	MT::ThreadPool* m_pool = nullptr;
+	Settings m_settings;
+
+	//indexed by allocation index, shared with the workers
+	std::unique_ptr<std::atomic<ChunkState>[]> m_states;
+	std::unique_ptr<std::atomic<float>[]> m_priorities;
+	PriorityJobQueue<size_t> m_queue;
+
+	std::atomic<size_t> m_runningBackground = 0;
+	std::atomic<size_t> m_deferredTickets = 0;
+	std::atomic<size_t> m_generatedCount = 0;
+	std::atomic<size_t> m_meshedCount = 0;
+	std::atomic<size_t> m_pregeneratedCount = 0;
+
+	//main thread only
+	std::vector<bool> m_seen;
+	std::vector<bool> m_inCone;
+	std::vector<size_t> m_coneChunks;
+	glm::vec3 m_velocity = glm::vec3(0.0f);
+	glm::vec3 m_coneDirection = glm::vec3(0.0f);
+	glm::ivec3 m_cameraChunk = glm::ivec3(0);
+	bool m_hasCameraChunk = false;
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+
+public:
+	PregenerationScheduler() = default;
+	PregenerationScheduler(const PregenerationScheduler&) = delete;
+	PregenerationScheduler& operator=(const PregenerationScheduler&) = delete;
+
+	void init(WorldGrid& grid, Generator& generator, Renderer& renderer,
+		const ResourceCache& resources, MT::ThreadPool& pool, const Settings& settings);
+
+	//velocity is in world units per second, called once per frame from the main thread
+	void update(glm::vec3 cameraPosition, glm::vec3 velocity, float deltaTime);
+
+	Stats getStats() const;
+
+private:
+	void requestVisible();
+	void requestCone();
+	void request(size_t allocIndex, float priority);
+
+	void pushTicket();
+	void runTicket();
+	void generate(size_t allocIndex);
+	void onGenerated(size_t allocIndex);
+	//passes the chunk to the mesh scheduler once, expects it to be requested and meshable
+	void requestMesh(size_t allocIndex);
+
+	bool isRequested(size_t allocIndex) const { return m_priorities[allocIndex].load() < s_notRequested; }
+	bool isMeshable(size_t allocIndex) const;
+	size_t findChunk(glm::ivec3 chunkCoords) const;
+};
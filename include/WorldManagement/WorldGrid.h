@@ -2,9 +2,13 @@
 #include "Common.h"
 #include "Rendering/Shape.h"
 #include "Utility/StructOfArraysPool.h"
+#include "Utility/PendingEditQueue.h"
 
 #include <vector>
 #include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <span>
 
 class WorldGrid
 {
@@ -27,11 +31,40 @@ public:
 	using GridPool = StructOfArraysPool<GridPoolDescriptor, ChunksPoolDescriptor>;
 
 	static inline const uint32_t noChunkIndex = std::numeric_limits<uint32_t>::max();
+
+	//a write into a chunk that is generated by another thread, applied once the chunk finishes its own pass
+	struct VoxelEdit
+	{
+		uint16_t index;				//voxel index inside the target chunk
+		Id::VoxelState state;
+		Id::VoxelState replaces;	//the edit only applies over this state, anyState applies unconditionally
+	};
+
+	static inline const Id::VoxelState anyState = Id::VoxelState(std::numeric_limits<uint32_t>::max());
+
+	enum class GenerationState : uint8_t
+	{
+		Pending,
+		Generating,
+		Done,
+	};
+
 private:
+	struct ChunkEdits
+	{
+		PendingEditQueue<VoxelEdit> queue;
+		std::atomic<GenerationState> state = GenerationState::Pending;
+		std::atomic<bool> draining = false;
+		std::atomic<uint32_t> version = 0;
+	};
+
 	GridPool m_pool;
 	std::vector<GridPool::Allocation> m_allocations;
 	CoordToChunk m_coordToAllocation;
 
+	//indexed by pool index so sorting and removing allocations does not move them
+	std::unique_ptr<ChunkEdits[]> m_chunkEdits;
+
 public:
 	WorldGrid() = default;
 
@@ -76,6 +109,33 @@ public:
 		return m_pool.getField<0>()[index];
 	}
 
+	//generation passes are bracketed by these, finishing applies every edit queued for the chunk
+	void beginGeneration(size_t allocIndex);
+	void finishGeneration(size_t allocIndex);
+	GenerationState getGenerationState(size_t allocIndex) const {
+		return m_chunkEdits[m_allocations[allocIndex].getIndex()].state;
+	}
+
+	//changes whenever generation or an edit wrote to the chunk, indexed by pool index so it can key
+	//data derived from the voxels, code writing blocks directly has to call markChanged afterwards
+	uint32_t getChunkVersion(size_t poolIndex) const {
+		return m_chunkEdits[poolIndex].version.load(std::memory_order_acquire);
+	}
+	void markChanged(size_t poolIndex) {
+		m_chunkEdits[poolIndex].version.fetch_add(1, std::memory_order_release);
+	}
+
+	//safe to call from any thread while chunks are being generated, edits into chunks
+	//that are not in the grid are dropped, returns false in that case
+	bool pushEdit(glm::ivec3 chunkCoords, const VoxelEdit& edit);
+
+	static inline void applyEdit(std::span<Id::VoxelState> blocks, const VoxelEdit& edit)
+	{
+		auto& block = blocks[edit.index];
+		if (edit.replaces == anyState || block == edit.replaces)
+			block = edit.state;
+	}
+
 	void addChunk(glm::ivec3 chunkCoords)
 	{
 		if (m_coordToAllocation.find(chunkCoords) != m_coordToAllocation.end())
@@ -86,6 +146,8 @@ public:
 		chunk.coord = glm::ivec4(chunkCoords, 1);
 		chunk.coordCorner = chunk.coord * glm::ivec4(Constants::chunkDimensions, 1);
 		chunk.start = alloc.getEntryOffset<0>();
+		m_chunkEdits[alloc.getIndex()].queue.clear();
+		m_chunkEdits[alloc.getIndex()].state = GenerationState::Pending;
 		m_coordToAllocation.insert({ chunkCoords, m_allocations.size() - 1 });
 		for (size_t j = 0; j < 6; ++j)
 		{
@@ -107,6 +169,7 @@ public:
 		if (it == m_coordToAllocation.end())
 			return;
 		auto& alloc = m_allocations[it->second];
+		m_chunkEdits[alloc.getIndex()].queue.clear();
 		m_pool.free(alloc);
 		m_coordToAllocation.find(m_allocations.back().getField<1>().coord)->second = it->second;
 		m_allocations[it->second] = m_allocations.back();
@@ -114,6 +177,9 @@ public:
 	}
 
 private:
+	void resetChunkEdits() { m_chunkEdits = std::make_unique<ChunkEdits[]>(m_pool.getPoolSize()); }
+	void drainEdits(size_t poolIndex);
+
 	size_t coordsToIndex(glm::ivec3 coords) const
 	{
 		glm::ivec3 chunkCoords = { coords.x / Constants::chunkWidth,
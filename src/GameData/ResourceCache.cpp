@@ -23,6 +23,11 @@ void ResourceCache::registerResources(const EngineFilesystem& engineFiles)
             registerVoxel(entry.path().string());
         }
     }
+
+    //nothing is registered after loading, the caches are only read from here on
+    m_assetCache.freeze();
+    m_voxels.freeze();
+    m_voxelStates.freeze();
 }
 
 void ResourceCache::registerVoxel(std::string_view path)
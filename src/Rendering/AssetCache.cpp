@@ -1,5 +1,7 @@
 #include "Rendering/AssetCache.h"
 
+#include <latch>
+
 void AssetCache::init(const EngineFilesystem& engineFiles)
 {
     registerAssets(engineFiles);
@@ -22,37 +24,8 @@ void AssetCache::registerAssets(const EngineFilesystem& engineFiles)
     }
 
     //ensures standard block geometry is at index 0
-    {
-        std::vector<Id::Polygon> geometry;
-        std::vector<Id::Vertex> verticesInd;
-        Shape::Polygon polygon;
-
-        for (size_t i = 0; i < 6; i++) {
-            for (size_t j = 0; j < 6; j++)
-                verticesInd.push_back(m_vertexCache.add(Shape::s_conversionMatrices[i] * glm::vec4(
-                    Shape::s_frontFacePositions[Shape::indices[j]].x,
-                    Shape::s_frontFacePositions[Shape::indices[j]].y,
-                    Shape::s_frontFacePositions[Shape::indices[j]].z,
-                    1)));
-            polygon.position[0] = verticesInd[verticesInd.size() - 6];
-            polygon.position[1] = verticesInd[verticesInd.size() - 5];
-            polygon.position[2] = verticesInd[verticesInd.size() - 4];
-            polygon.normal = m_normalCache.add(glm::vec4(
-                Constants::directionsFloat3D[enumCast(static_cast<Directions3D>(i))], 0));
-
-            geometry.push_back(m_polygonCache.add(polygon));
-
-            polygon.position[0] = verticesInd[verticesInd.size() - 3];
-            polygon.position[1] = verticesInd[verticesInd.size() - 2];
-            polygon.position[2] = verticesInd[verticesInd.size() - 1];
-            polygon.normal = m_normalCache.add(glm::vec4(
-                Constants::directionsFloat3D[enumCast(static_cast<Directions3D>(i))], 0));
-
-            geometry.push_back(m_polygonCache.add(polygon));
-        }
-
-        m_standartBlockGeometryId = m_geometryCache.add(geometry, { Shape::GeometryType::Cube });
-    }
+    m_standartBlockGeometryId = Shape::registerStandardCube(m_vertexCache, m_normalCache,
+        m_polygonCache, m_geometryCache);
 
     const auto& modelDir = engineFiles.getModelDirectory();
     for (const auto& entry : std::filesystem::directory_iterator(modelDir)) {
@@ -63,6 +36,51 @@ void AssetCache::registerAssets(const EngineFilesystem& engineFiles)
     m_voxelCullingCache.init(m_geometryCache, m_polygonCache, m_vertexCache, m_normalCache, m_standartBlockGeometryId);
 }
 
+void AssetCache::freeze()
+{
+    m_textureCache.freeze();
+    m_vertexCache.freeze();
+    m_uvCache.freeze();
+    m_normalCache.freeze();
+    m_polygonCache.freeze();
+    m_coloringCache.freeze();
+    m_geometryCache.freeze();
+    m_appearanceCache.freeze();
+    m_modelCache.freeze();
+}
+
+void AssetCache::buildCullingTable(MT::ThreadPool& pool)
+{
+    m_voxelCullingCache.buildAll([&pool](size_t taskCount, const std::function<void(size_t)>& task) {
+        std::latch done(static_cast<std::ptrdiff_t>(taskCount));
+        for (size_t i = 0; i < taskCount; ++i)
+            pool.pushTask([&task, &done, i](size_t) {
+                task(i);
+                done.count_down();
+                });
+        done.wait();
+        });
+}
+
+bool AssetCache::loadCullingTable(const std::filesystem::path& path)
+{
+    if (!m_voxelCullingCache.load(path)) {
+        std::cout << "Culling table at " << path.string() << " is missing or stale, clipping it again" << std::endl;
+        return false;
+    }
+    std::cout << "Loaded culling table with " << m_voxelCullingCache.getComputedPairCount() << " of "
+        << m_voxelCullingCache.getPairCount() << " pairs clipped" << std::endl;
+    return true;
+}
+
+void AssetCache::saveCullingTable(const std::filesystem::path& path) const
+{
+    if (!m_voxelCullingCache.hasUnsavedPairs())
+        return;
+    if (!m_voxelCullingCache.save(path))
+        std::cerr << "Failed to save the culling table to " << path.string() << std::endl;
+}
+
 void AssetCache::moveAssetsToGpuStorage(const Gfx::Wrappers::Device& device,
     const Gfx::PhysicalDeviceMemoryProperties& physicalDeviceMemoryProperties,
     Gfx::Queue transferQueue, Gfx::CommandPoolRef temporaryPool,
@@ -0,0 +1,652 @@
+#include "Rendering/ChunkMesher.h"
+#include "Utility/Hash.h"
+
+#include <bit>
+
+void ChunkMesher::init(const Sources& sources)
+{
+	if (sources.voxelStates == nullptr || sources.models == nullptr || sources.geometries == nullptr ||
+		sources.appearances == nullptr || sources.culling == nullptr || sources.polygons == nullptr ||
+		sources.normals == nullptr)
+		throw std::runtime_error("Chunk mesher sources are incomplete");
+	m_sources = sources;
+
+	const auto& geometryEntries = m_sources.geometries->entryCache();
+	auto standardId = m_sources.culling->getStandardBlockGeometryId();
+	const auto& standardEntry = geometryEntries[standardId];
+	const auto& states = m_sources.voxelStates->data();
+
+	m_cubePolygonCount = standardEntry.size;
+	if (m_cubePolygonCount > sizeof(VoxelCullingCache::BitMask) * 8)
+		throw std::runtime_error("Standard cube polygons do not fit into one culling mask");
+	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+		m_cubeCulledBy[side] = m_sources.culling->getCullingMask(standardId, standardId, static_cast<Shape::Side>(side));
+
+	m_cubeGeometryStart = standardEntry.start;
+
+	VoxelCullingCache::BitMask covered = 0;
+	m_canMergeCubeFaces = true;
+	for (auto sideMask : m_cubeCulledBy)
+	{
+		if (sideMask == 0 || (covered & sideMask) != 0)
+			m_canMergeCubeFaces = false;
+		covered |= sideMask;
+	}
+	auto allPolygons = m_cubePolygonCount == sizeof(VoxelCullingCache::BitMask) * 8 ? ~VoxelCullingCache::BitMask(0) :
+		(VoxelCullingCache::BitMask(1) << m_cubePolygonCount) - 1;
+	if (covered != allPolygons)
+		m_canMergeCubeFaces = false;
+
+	//quad records only have room for this many polygon and coloring ids
+	for (auto polygon : m_sources.geometries->indexData())
+		if (static_cast<uint32_t>(polygon) >= (uint32_t(1) << QuadRecord::s_polygonBits))
+			throw std::runtime_error("Too many polygons for quad records");
+	for (auto coloring : m_sources.appearances->indexData())
+		if (static_cast<uint32_t>(coloring) >= (uint32_t(1) << QuadRecord::s_coloringBits))
+			throw std::runtime_error("Too many colorings for quad records");
+
+	const auto& polygons = m_sources.polygons->data();
+	m_polygonBuckets.assign(polygons.size(), static_cast<uint8_t>(s_unalignedBucket));
+	for (size_t i = 0; i < polygons.size(); ++i)
+	{
+		glm::vec3 normal = (*m_sources.normals)[polygons[i].normal];
+		for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+			if (glm::length(normal - glm::vec3(Constants::directionsFloat3D[side])) < 1e-4f)
+				m_polygonBuckets[i] = static_cast<uint8_t>(side);
+	}
+
+	const auto& appearanceEntries = m_sources.appearances->entryCache();
+	m_stateInfos.assign(states.size(), StateRenderInfo{});
+	for (size_t i = 0; i < states.size(); ++i)
+	{
+		if (Id::VoxelState(static_cast<uint32_t>(i)) == Constants::emptyStateId)
+			continue;
+		const auto& model = (*m_sources.models)[states[i].m_model];
+		const auto& entry = geometryEntries[model.geometry];
+
+		auto& info = m_stateInfos[i];
+		info.geometry = model.geometry;
+		info.geometryStart = entry.start;
+		info.geometrySize = entry.size;
+		info.appearanceStart = appearanceEntries[model.appearence].start;
+		info.isEmpty = false;
+		//models registered as a default parallelogram share the standard cube polygons
+		info.isFullCube = entry.metadata.geometryType == Shape::GeometryType::Cube &&
+			entry.start == standardEntry.start && entry.size == standardEntry.size;
+	}
+}
+
+void ChunkMesher::packQuads(const IndexBuffer& polygons, QuadBuffer& out,
+	DirectionRanges& ranges) const
+{
+	auto getBucket = [this](const Indices& index) {
+		return index.polygon < m_polygonBuckets.size() ? m_polygonBuckets[index.polygon] : s_unalignedBucket;
+		};
+
+	//runs twice, once to size the buckets and once to fill them
+	auto forEachRecord = [&](auto&& emit) {
+		for (size_t i = 0; i < polygons.size(); ++i)
+		{
+			const auto& first = polygons[i];
+			size_t bucket = getBucket(first);
+			bool pair = i + 1 < polygons.size() &&
+				polygons[i + 1].polygon == first.polygon + 1 && polygons[i + 1].coloring == first.coloring + 1 &&
+				polygons[i + 1].block == first.block && polygons[i + 1].extent == first.extent &&
+				getBucket(polygons[i + 1]) == bucket;
+			emit(first, pair, bucket);
+			if (pair)
+				++i;
+		}
+		};
+
+	std::array<uint32_t, s_directionBuckets> counts = {};
+	forEachRecord([&](const Indices&, bool, size_t bucket) { ++counts[bucket]; });
+
+	size_t base = out.size();
+	ranges[0] = 0;
+	for (size_t bucket = 0; bucket < s_directionBuckets; ++bucket)
+		ranges[bucket + 1] = ranges[bucket] + counts[bucket];
+	out.resize(base + ranges[s_directionBuckets]);
+
+	auto next = ranges;
+	forEachRecord([&](const Indices& first, bool pair, size_t bucket) {
+		auto& record = out[base + next[bucket]++];
+		record.polygonExtent = first.polygon | first.extent << QuadRecord::s_extentShift |
+			(pair ? QuadRecord::s_pairBit : 0);
+		record.coloringBlock = first.coloring |
+			static_cast<uint32_t>(first.block % Constants::chunkSize) << QuadRecord::s_blockShift;
+		});
+}
+
+ChunkMesher::InputHash ChunkMesher::hashInput(const WorldGrid& grid, size_t chunkPoolIndex) const
+{
+	const auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+	const auto& voxelGrid = grid.getGrid();
+
+	WordHash hash;
+	hash.add(m_mode);
+	hash.addBytes(&voxelGrid[chunk.start], Constants::chunkSize * sizeof(Id::VoxelState));
+
+	//meshing reads nothing of the neighbours but their touching layers, a missing one counts as air
+	std::array<Id::VoxelState, Constants::chunkLayerSize> layer;
+	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+	{
+		auto start = chunk.neighbourStarts[side];
+		if (start == WorldGrid::noChunkIndex)
+		{
+			layer.fill(Constants::emptyStateId);
+			hash.addBytes(layer.data(), sizeof(layer));
+			continue;
+		}
+
+		//the layer is a plane of the neighbour, so it is walked with two fixed strides
+		auto sideId = static_cast<Shape::Side>(side);
+		const auto* base = &voxelGrid[start + getApronOffset(sideId, 0, 0)];
+		size_t strideA = getApronOffset(sideId, 1, 0) - getApronOffset(sideId, 0, 0);
+		size_t strideB = getApronOffset(sideId, 0, 1) - getApronOffset(sideId, 0, 0);
+		for (size_t a = 0; a < Constants::chunkWidth; ++a)
+			for (size_t b = 0; b < Constants::chunkWidth; ++b)
+				layer[a * Constants::chunkWidth + b] = base[a * strideA + b * strideB];
+		hash.addBytes(layer.data(), sizeof(layer));
+	}
+	return InputHash{ hash.get(), hash.getCheck() };
+}
+
+ChunkMesher::Solidity ChunkMesher::summarizeSolidity(const WorldGrid& grid, size_t chunkPoolIndex) const
+{
+	const auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+	const auto& voxelGrid = grid.getGrid();
+	auto isCube = [&](size_t index) { return getStateInfo(voxelGrid[chunk.start + index]).isFullCube; };
+
+	size_t first = 0;
+	while (first < Constants::chunkSize && isCube(first))
+		++first;
+	if (first == Constants::chunkSize)
+		return s_solidFaces | s_solidInterior;
+
+	//the chunk's own layer on a side is what the neighbour on the opposite side reads as its apron
+	Solidity solidity = 0;
+	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+	{
+		auto opposite = static_cast<Shape::Side>(enumCast(reverseDir3D(side)));
+		bool solid = true;
+		for (size_t a = 0; a < Constants::chunkWidth && solid; ++a)
+			for (size_t b = 0; b < Constants::chunkWidth && solid; ++b)
+				solid = isCube(getApronOffset(opposite, a, b));
+		if (solid)
+			solidity |= Solidity(1) << side;
+	}
+	return solidity;
+}
+
+ChunkMesher::Connectivity ChunkMesher::computeConnectivity(const WorldGrid& grid, size_t chunkPoolIndex) const
+{
+	const auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+	const auto& voxelGrid = grid.getGrid();
+
+	//voxels not reached by a fill yet, a bit per voxel
+	std::array<uint64_t, Constants::chunkSize / 64> open = {};
+	size_t openCount = 0;
+	for (size_t i = 0; i < Constants::chunkSize; ++i)
+		if (!getStateInfo(voxelGrid[chunk.start + i]).isFullCube)
+		{
+			open[i / 64] |= uint64_t(1) << (i % 64);
+			++openCount;
+		}
+	if (openCount == 0)
+		return 0;
+	if (openCount == Constants::chunkSize)
+		return s_fullyConnected;
+
+	const uint8_t allSides = (1 << enumCast(Shape::Side::Count)) - 1;
+	auto sideBit = [](Shape::Side side) { return static_cast<uint8_t>(1 << enumCast(side)); };
+
+	std::array<uint16_t, Constants::chunkSize> stack;
+	Connectivity connectivity = 0;
+	for (size_t word = 0; word < open.size(); ++word)
+		while (open[word] != 0)
+		{
+			size_t seed = word * 64 + std::countr_zero(open[word]);
+			open[word] &= open[word] - 1;
+			size_t stackSize = 0;
+			stack[stackSize++] = static_cast<uint16_t>(seed);
+
+			uint8_t sides = 0;
+			auto visit = [&](size_t index) {
+				uint64_t bit = uint64_t(1) << (index % 64);
+				if ((open[index / 64] & bit) == 0)
+					return;
+				open[index / 64] &= ~bit;
+				stack[stackSize++] = static_cast<uint16_t>(index);
+				};
+
+			while (stackSize > 0)
+			{
+				size_t index = stack[--stackSize];
+				size_t x = index % Constants::chunkWidth;
+				size_t z = index / Constants::chunkWidth % Constants::chunkDepth;
+				size_t y = index / Constants::chunkLayerSize;
+
+				if (x == 0) sides |= sideBit(Shape::Side::Left);
+				else visit(index - 1);
+				if (x == Constants::chunkWidth - 1) sides |= sideBit(Shape::Side::Right);
+				else visit(index + 1);
+				if (z == 0) sides |= sideBit(Shape::Side::Front);
+				else visit(index - Constants::chunkWidth);
+				if (z == Constants::chunkDepth - 1) sides |= sideBit(Shape::Side::Back);
+				else visit(index + Constants::chunkWidth);
+				if (y == 0) sides |= sideBit(Shape::Side::Bottom);
+				else visit(index - Constants::chunkLayerSize);
+				if (y == Constants::chunkHeight - 1) sides |= sideBit(Shape::Side::Top);
+				else visit(index + Constants::chunkLayerSize);
+			}
+
+			//a region touching every side joins all of them, nothing left to find
+			if (sides == allSides)
+				return s_fullyConnected;
+			for (size_t a = 0; a < enumCast(Shape::Side::Count); ++a)
+				for (size_t b = a + 1; b < enumCast(Shape::Side::Count); ++b)
+					if ((sides >> a & 1) != 0 && (sides >> b & 1) != 0)
+						connectivity |= getConnectionBit(static_cast<Shape::Side>(a), static_cast<Shape::Side>(b));
+		}
+	return connectivity;
+}
+
+ChunkMesher::Connectivity ChunkMesher::getConnectionBit(Shape::Side a, Shape::Side b)
+{
+	//pairs are numbered row by row of the upper triangle, 5 pairs start with side 0, 4 with side 1...
+	size_t first = std::min(enumCast(a), enumCast(b));
+	size_t second = std::max(enumCast(a), enumCast(b));
+	if (first == second)
+		return 0;
+	size_t row = first * (2 * enumCast(Shape::Side::Count) - 1 - first) / 2;
+	return static_cast<Connectivity>(1 << (row + second - first - 1));
+}
+
+bool ChunkMesher::isEnclosed(Solidity chunk, const std::array<Solidity, enumCast(Shape::Side::Count)>& neighbours)
+{
+	if ((chunk & s_solidInterior) == 0)
+		return false;
+	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+		if ((neighbours[side] & (Solidity(1) << enumCast(reverseDir3D(side)))) == 0)
+			return false;
+	return true;
+}
+
+bool ChunkMesher::canFaceCamera(size_t bucket, glm::vec3 chunkCorner, glm::vec3 camera)
+{
+	if (bucket >= enumCast(Shape::Side::Count))
+		return true;
+	glm::vec3 direction = Constants::directionsFloat3D[bucket];
+	int axis = direction.x != 0.0f ? 0 : (direction.y != 0.0f ? 1 : 2);
+	float chunkMin = chunkCorner[axis];
+	float chunkMax = chunkMin + static_cast<float>(Constants::chunkDimensions[axis]);
+	return direction[axis] > 0.0f ? camera[axis] > chunkMin : camera[axis] < chunkMax;
+}
+
+void ChunkMesher::mesh(const WorldGrid& grid, size_t chunkPoolIndex, IndexBuffer& out) const
+{
+	assert(isInitialized());
+	const auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+	const auto& voxelGrid = grid.getGrid();
+	const auto& geometries = *m_sources.geometries;
+	const auto& appearances = *m_sources.appearances;
+
+	Occupancy occupancy;
+	buildOccupancy(grid, chunk, occupancy);
+
+	//in greedy mode fast cubes only record their visible faces, the quads are emitted afterwards
+	bool greedy = m_mode == Mode::Greedy && m_canMergeCubeFaces;
+	std::array<FaceLayers, enumCast(Shape::Side::Count)> faces;
+	if (greedy)
+		for (auto& side : faces)
+			side.fill(0);
+
+	for (size_t y = 0; y < Constants::chunkHeight; ++y)
+		for (size_t z = 0; z < Constants::chunkDepth; ++z)
+		{
+			size_t row = rowIndex(y + 1, z + 1);
+			Row cube = occupancy.cube[row];
+			Row other = occupancy.other[row];
+			Row selfCube = cube & s_innerRowMask;
+			Row selfOther = other & s_innerRowMask;
+			if ((selfCube | selfOther) == 0)
+				continue;
+
+			//cubes with a full cube neighbour on a side, that neighbour hides the faces it touches
+			std::array<Row, enumCast(Shape::Side::Count)> hidden;
+			hidden[enumCast(Shape::Side::Front)] = selfCube & occupancy.cube[rowIndex(y + 1, z)];
+			hidden[enumCast(Shape::Side::Back)] = selfCube & occupancy.cube[rowIndex(y + 1, z + 2)];
+			hidden[enumCast(Shape::Side::Left)] = selfCube & (cube << 1);
+			hidden[enumCast(Shape::Side::Right)] = selfCube & (cube >> 1);
+			hidden[enumCast(Shape::Side::Bottom)] = selfCube & occupancy.cube[rowIndex(y, z + 1)];
+			hidden[enumCast(Shape::Side::Top)] = selfCube & occupancy.cube[rowIndex(y + 2, z + 1)];
+
+			//cubes touching other geometry need the culling table like the other geometry itself
+			Row otherNeighbours = (other << 1) | (other >> 1) |
+				occupancy.other[rowIndex(y + 1, z)] | occupancy.other[rowIndex(y + 1, z + 2)] |
+				occupancy.other[rowIndex(y, z + 1)] | occupancy.other[rowIndex(y + 2, z + 1)];
+			Row slow = selfOther | (selfCube & otherNeighbours);
+
+			Row pending = slow;
+			if (greedy)
+			{
+				Row fast = selfCube & ~slow;
+				for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+				{
+					Row visible = (fast & ~hidden[side]) >> 1;
+					auto& layers = faces[side];
+					switch (getSideAxis(static_cast<Shape::Side>(side)))
+					{
+					case 0:		//layer x, u = y, v = z
+						for (; visible != 0; visible &= visible - 1)
+							layers[static_cast<size_t>(std::countr_zero(visible)) * Constants::chunkWidth + z] |= Row(1) << y;
+						break;
+					case 1:		//layer y, u = x, v = z
+						layers[y * Constants::chunkWidth + z] |= visible;
+						break;
+					default:	//layer z, u = x, v = y
+						layers[z * Constants::chunkWidth + y] |= visible;
+						break;
+					}
+				}
+			}
+			else
+			{
+				Row enclosed = selfCube;
+				for (auto sideMask : hidden)
+					enclosed &= sideMask;
+				pending |= selfCube & ~enclosed;
+			}
+
+			while (pending != 0)
+			{
+				size_t bit = static_cast<size_t>(std::countr_zero(pending));
+				pending &= pending - 1;
+				size_t x = bit - 1;
+				size_t block = chunk.start + x + z * Constants::chunkWidth + y * Constants::chunkLayerSize;
+
+				if ((slow >> bit) & 1)
+				{
+					meshVoxel(grid, chunk, block, x, y, z, out);
+					continue;
+				}
+
+				VoxelCullingCache::BitMask culled = 0;
+				for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+					if ((hidden[side] >> bit) & 1)
+						culled |= m_cubeCulledBy[side];
+
+				size_t appearanceStart = getStateInfo(voxelGrid[block]).appearanceStart;
+				for (size_t polygon = 0; polygon < m_cubePolygonCount; ++polygon)
+				{
+					if ((culled >> polygon) & 1)
+						continue;
+					Indices index;
+					index.polygon = geometries[m_cubeGeometryStart + polygon];
+					index.coloring = appearances[appearanceStart + polygon];
+					index.block = static_cast<uint32_t>(block);
+					out.push_back(index);
+				}
+			}
+		}
+
+	if (greedy)
+		for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+			mergeFaces(grid, chunk, static_cast<Shape::Side>(side), faces[side], out);
+}
+
+void ChunkMesher::meshReference(const WorldGrid& grid, size_t chunkPoolIndex, IndexBuffer& out) const
+{
+	assert(isInitialized());
+	const auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+	const auto& geometryEntries = m_sources.geometries->entryCache();
+	const auto& appearanceEntries = m_sources.appearances->entryCache();
+
+	size_t chunkEnd = chunk.start + Constants::chunkSize;
+	for (size_t block = chunk.start; block < chunkEnd; ++block)
+	{
+		m_sources.culling->populateBuffer(block,
+			(block - chunk.start) % Constants::chunkWidth,
+			(block - chunk.start) / Constants::chunkLayerSize,
+			((block - chunk.start) % Constants::chunkLayerSize) / Constants::chunkWidth,
+			chunk, grid, out, *m_sources.voxelStates, *m_sources.models, geometryEntries,
+			appearanceEntries, *m_sources.geometries, *m_sources.appearances);
+	}
+}
+
+void ChunkMesher::meshVoxel(const WorldGrid& grid, const WorldGrid::Chunk& chunk, size_t block,
+	size_t x, size_t y, size_t z, IndexBuffer& out) const
+{
+	const auto& info = getStateInfo(grid.getBlock(block));
+	if (info.isEmpty)
+		return;
+	const auto& culling = *m_sources.culling;
+	const auto& geometries = *m_sources.geometries;
+	const auto& appearances = *m_sources.appearances;
+	const size_t bitsPerWord = sizeof(VoxelCullingCache::BitMask) * 8;
+
+	std::array<size_t, enumCast(Shape::Side::Count)> cullingStarts;
+	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+	{
+		const auto& adjacent = getStateInfo(getNeighbourState(grid, chunk, block, x, y, z, static_cast<Shape::Side>(side)));
+		cullingStarts[side] = adjacent.isEmpty ? culling.getNoCullingStart() :
+			culling.getCullingStart(info.geometry, adjacent.geometry, static_cast<Shape::Side>(side));
+	}
+
+	for (size_t first = 0, word = 0; first < info.geometrySize; first += bitsPerWord, ++word)
+	{
+		VoxelCullingCache::BitMask culled = 0;
+		for (auto start : cullingStarts)
+			culled |= culling.getMaskWord(start + word);
+
+		size_t count = std::min<size_t>(bitsPerWord, info.geometrySize - first);
+		for (size_t polygon = 0; polygon < count; ++polygon)
+		{
+			if ((culled >> polygon) & 1)
+				continue;
+			Indices index;
+			index.polygon = geometries[info.geometryStart + first + polygon];
+			index.coloring = appearances[info.appearanceStart + first + polygon];
+			index.block = static_cast<uint32_t>(block);
+			out.push_back(index);
+		}
+	}
+}
+
+Id::VoxelState ChunkMesher::getNeighbourState(const WorldGrid& grid, const WorldGrid::Chunk& chunk, size_t block,
+	size_t x, size_t y, size_t z, Shape::Side side)
+{
+	const size_t last = Constants::chunkWidth - 1;
+	size_t start = chunk.neighbourStarts[enumCast(side)];
+	size_t neighbour = 0;
+	switch (side)
+	{
+	case Shape::Side::Front:
+		if (z != 0) return grid.getBlock(block - Constants::chunkWidth);
+		neighbour = x + last * Constants::chunkWidth + y * Constants::chunkLayerSize;
+		break;
+	case Shape::Side::Back:
+		if (z != last) return grid.getBlock(block + Constants::chunkWidth);
+		neighbour = x + y * Constants::chunkLayerSize;
+		break;
+	case Shape::Side::Left:
+		if (x != 0) return grid.getBlock(block - 1);
+		neighbour = last + z * Constants::chunkWidth + y * Constants::chunkLayerSize;
+		break;
+	case Shape::Side::Right:
+		if (x != last) return grid.getBlock(block + 1);
+		neighbour = z * Constants::chunkWidth + y * Constants::chunkLayerSize;
+		break;
+	case Shape::Side::Bottom:
+		if (y != 0) return grid.getBlock(block - Constants::chunkLayerSize);
+		neighbour = x + z * Constants::chunkWidth + last * Constants::chunkLayerSize;
+		break;
+	case Shape::Side::Top:
+		if (y != last) return grid.getBlock(block + Constants::chunkLayerSize);
+		neighbour = x + z * Constants::chunkWidth;
+		break;
+	default: break;
+	}
+	//a missing neighbour chunk culls nothing, same as air
+	if (start == WorldGrid::noChunkIndex)
+		return Constants::emptyStateId;
+	return grid.getBlock(start + neighbour);
+}
+
+void ChunkMesher::setOccupied(Occupancy& occupancy, size_t row, size_t bit, Id::VoxelState state) const
+{
+	const auto& info = getStateInfo(state);
+	if (info.isEmpty)
+		return;
+	if (info.isFullCube)
+		occupancy.cube[row] |= Row(1) << bit;
+	else occupancy.other[row] |= Row(1) << bit;
+}
+
+void ChunkMesher::buildOccupancy(const WorldGrid& grid, const WorldGrid::Chunk& chunk, Occupancy& occupancy) const
+{
+	const auto& voxelGrid = grid.getGrid();
+	occupancy.cube.fill(0);
+	occupancy.other.fill(0);
+
+	for (size_t i = 0; i < Constants::chunkSize; ++i)
+	{
+		size_t x = i % Constants::chunkWidth;
+		size_t z = (i % Constants::chunkLayerSize) / Constants::chunkWidth;
+		size_t y = i / Constants::chunkLayerSize;
+		setOccupied(occupancy, rowIndex(y + 1, z + 1), x + 1, voxelGrid[chunk.start + i]);
+	}
+
+	//the apron takes the touching layer of each neighbour, missing neighbours stay empty
+	//which leaves the border faces visible like the culling table does
+	const size_t apron = s_rowsPerAxis - 1;
+	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+	{
+		auto start = chunk.neighbourStarts[side];
+		if (start == WorldGrid::noChunkIndex)
+			continue;
+
+		auto sideId = static_cast<Shape::Side>(side);
+		for (size_t a = 0; a < Constants::chunkWidth; ++a)
+			for (size_t b = 0; b < Constants::chunkWidth; ++b)
+			{
+				auto state = voxelGrid[start + getApronOffset(sideId, a, b)];
+				switch (sideId)
+				{
+				case Shape::Side::Left:		//a = y, b = z
+					setOccupied(occupancy, rowIndex(a + 1, b + 1), 0, state);
+					break;
+				case Shape::Side::Right:
+					setOccupied(occupancy, rowIndex(a + 1, b + 1), apron, state);
+					break;
+				case Shape::Side::Front:	//a = y, b = x
+					setOccupied(occupancy, rowIndex(a + 1, 0), b + 1, state);
+					break;
+				case Shape::Side::Back:
+					setOccupied(occupancy, rowIndex(a + 1, apron), b + 1, state);
+					break;
+				case Shape::Side::Bottom:	//a = z, b = x
+					setOccupied(occupancy, rowIndex(0, a + 1), b + 1, state);
+					break;
+				case Shape::Side::Top:
+					setOccupied(occupancy, rowIndex(apron, a + 1), b + 1, state);
+					break;
+				default: break;
+				}
+			}
+	}
+}
+
+size_t ChunkMesher::getApronOffset(Shape::Side side, size_t a, size_t b)
+{
+	const size_t last = Constants::chunkWidth - 1;
+	switch (side)
+	{
+	case Shape::Side::Left: return last + b * Constants::chunkWidth + a * Constants::chunkLayerSize;
+	case Shape::Side::Right: return b * Constants::chunkWidth + a * Constants::chunkLayerSize;
+	case Shape::Side::Front: return b + last * Constants::chunkWidth + a * Constants::chunkLayerSize;
+	case Shape::Side::Back: return b + a * Constants::chunkLayerSize;
+	case Shape::Side::Bottom: return b + a * Constants::chunkWidth + last * Constants::chunkLayerSize;
+	case Shape::Side::Top: return b + a * Constants::chunkWidth;
+	default: return 0;
+	}
+}
+
+size_t ChunkMesher::getSideAxis(Shape::Side side)
+{
+	switch (side)
+	{
+	case Shape::Side::Left:
+	case Shape::Side::Right: return 0;
+	case Shape::Side::Top:
+	case Shape::Side::Bottom: return 1;
+	default: return 2;
+	}
+}
+
+void ChunkMesher::mergeFaces(const WorldGrid& grid, const WorldGrid::Chunk& chunk, Shape::Side side,
+	FaceLayers& faces, IndexBuffer& out) const
+{
+	const auto& voxelGrid = grid.getGrid();
+	const auto& geometries = *m_sources.geometries;
+	const auto& appearances = *m_sources.appearances;
+	const size_t width = Constants::chunkWidth;
+	const size_t axis = getSideAxis(side);
+	const auto sideMask = m_cubeCulledBy[enumCast(side)];
+
+	auto blockAt = [&](size_t layer, size_t u, size_t v) {
+		size_t x = axis == 0 ? layer : u;
+		size_t y = axis == 0 ? u : (axis == 1 ? layer : v);
+		size_t z = axis == 2 ? layer : v;
+		return chunk.start + x + z * Constants::chunkWidth + y * Constants::chunkLayerSize;
+	};
+	//equal appearance starts mean equal colorings since the appearance cache deduplicates its sequences
+	auto keyAt = [&](size_t layer, size_t u, size_t v) {
+		return getStateInfo(voxelGrid[blockAt(layer, u, v)]).appearanceStart;
+	};
+
+	for (size_t layer = 0; layer < width; ++layer)
+	{
+		Row* rows = faces.data() + layer * width;
+		for (size_t v = 0; v < width; ++v)
+			while (rows[v] != 0)
+			{
+				size_t u = static_cast<size_t>(std::countr_zero(rows[v]));
+				auto key = keyAt(layer, u, v);
+
+				size_t quadWidth = 1;
+				while (u + quadWidth < width && ((rows[v] >> (u + quadWidth)) & 1) &&
+					keyAt(layer, u + quadWidth, v) == key)
+					++quadWidth;
+				Row span = ((Row(1) << quadWidth) - 1) << u;
+
+				size_t quadHeight = 1;
+				for (; v + quadHeight < width; ++quadHeight)
+				{
+					if ((rows[v + quadHeight] & span) != span)
+						break;
+					bool sameKey = true;
+					for (size_t i = 0; i < quadWidth && sameKey; ++i)
+						sameKey = keyAt(layer, u + i, v + quadHeight) == key;
+					if (!sameKey)
+						break;
+				}
+				for (size_t i = 0; i < quadHeight; ++i)
+					rows[v + i] &= ~span;
+
+				uint32_t extent = static_cast<uint32_t>((quadWidth - 1) | ((quadHeight - 1) << 4));
+				uint32_t block = static_cast<uint32_t>(blockAt(layer, u, v));
+				for (auto polygons = sideMask; polygons != 0; polygons &= polygons - 1)
+				{
+					size_t polygon = static_cast<size_t>(std::countr_zero(polygons));
+					Indices index;
+					index.polygon = geometries[m_cubeGeometryStart + polygon];
+					index.coloring = appearances[key + polygon];
+					index.block = block;
+					index.extent = extent;
+					out.push_back(index);
+				}
+			}
+	}
+}
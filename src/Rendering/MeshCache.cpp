@@ -0,0 +1,84 @@
+#include "Rendering/MeshCache.h"
+
+void MeshCache::setBudget(size_t budget)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_budget = budget;
+	evict(m_budget);
+}
+
+size_t MeshCache::getBudget() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_budget;
+}
+
+bool MeshCache::find(const ChunkMesher::InputHash& hash, QuadBuffer& out, ChunkMesher::DirectionRanges& ranges)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	auto it = m_keyToEntry.find(hash.key);
+	if (it == m_keyToEntry.end() || it->second->check != hash.check)
+	{
+		if (it != m_keyToEntry.end())
+			++m_collisions;
+		++m_misses;
+		return false;
+	}
+
+	++m_hits;
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	const auto& entry = *it->second;
+	out.insert(out.end(), entry.records.begin(), entry.records.end());
+	ranges = entry.ranges;
+	return true;
+}
+
+void MeshCache::store(const ChunkMesher::InputHash& hash, const QuadBuffer& records, const ChunkMesher::DirectionRanges& ranges)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	//another worker may have meshed the same contents meanwhile
+	if (m_keyToEntry.find(hash.key) != m_keyToEntry.end())
+		return;
+
+	size_t memory = s_entryOverhead + records.size() * sizeof(QuadRecord);
+	if (memory > m_budget)
+		return;
+	evict(m_budget - memory);
+
+	m_entries.push_front(Entry{ hash.key, hash.check, std::vector<QuadRecord>(records.begin(), records.end()), ranges });
+	m_keyToEntry.insert({ hash.key, m_entries.begin() });
+	m_memory += memory;
+}
+
+void MeshCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_entries.clear();
+	m_keyToEntry.clear();
+	m_memory = 0;
+}
+
+MeshCache::Stats MeshCache::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Stats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+	stats.collisions = m_collisions;
+	stats.entries = m_entries.size();
+	stats.memory = m_memory;
+	return stats;
+}
+
+void MeshCache::evict(size_t budget)
+{
+	while (m_memory > budget && !m_entries.empty())
+	{
+		const auto& entry = m_entries.back();
+		m_memory -= getEntryMemory(entry);
+		m_keyToEntry.erase(entry.key);
+		m_entries.pop_back();
+		++m_evictions;
+	}
+}
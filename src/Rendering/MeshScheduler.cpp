@@ -0,0 +1,198 @@
+#include "Rendering/MeshScheduler.h"
+
+#include <algorithm>
+
+void MeshScheduler::init(MT::ThreadPool& pool, size_t chunkCount, const Settings& settings)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_pool = &pool;
+	m_settings = settings;
+	m_jobs.clear();
+	m_jobs.resize(chunkCount);
+	m_parkedChunks.clear();
+	m_queue.clear();
+	m_hasView = false;
+	m_running = 0;
+	m_completed = 0;
+	m_coalesced = 0;
+	m_cancelled = 0;
+	m_latencyCount = 0;
+}
+
+void MeshScheduler::setSettings(const Settings& settings)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_settings = settings;
+}
+
+void MeshScheduler::request(size_t chunkIndex, glm::vec3 center, Task task, Callback onDone)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	auto& job = m_jobs[chunkIndex];
+	job.center = center;
+	job.task = std::move(task);
+	if (onDone)
+		job.onDone.push_back(std::move(onDone));
+
+	if (job.running)
+	{
+		//the running job may have read the chunk before the change, so it is meshed once more
+		if (job.rerun)
+			++m_coalesced;
+		else
+		{
+			job.rerun = true;
+			job.requested = Clock::now();
+		}
+		return;
+	}
+
+	if (job.pending || job.parked)
+	{
+		++m_coalesced;
+		return;
+	}
+
+	job.requested = Clock::now();
+	enqueue(chunkIndex);
+}
+
+void MeshScheduler::update(const glm::mat4& viewProj, glm::vec3 cameraPosition)
+{
+	auto frustum = Frustum::fromViewProj(viewProj);
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_frustum = frustum;
+	m_cameraPosition = cameraPosition;
+	m_hasView = true;
+
+	for (size_t i = 0; i < m_jobs.size(); ++i)
+	{
+		auto& job = m_jobs[i];
+		if (!job.pending)
+			continue;
+
+		if (isFar(job.center))
+		{
+			m_queue.remove(i);
+			job.pending = false;
+			job.parked = true;
+			m_parkedChunks.push_back(i);
+			++m_cancelled;
+		}
+		else m_queue.reprioritize(i, priority(job.center));
+	}
+
+	for (size_t i = 0; i < m_parkedChunks.size();)
+	{
+		size_t chunkIndex = m_parkedChunks[i];
+		if (isFar(m_jobs[chunkIndex].center))
+		{
+			++i;
+			continue;
+		}
+		m_parkedChunks[i] = m_parkedChunks.back();
+		m_parkedChunks.pop_back();
+		m_jobs[chunkIndex].parked = false;
+		enqueue(chunkIndex);
+	}
+}
+
+MeshScheduler::Stats MeshScheduler::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Stats stats;
+	stats.pending = m_queue.size();
+	stats.running = m_running;
+	stats.parked = m_parkedChunks.size();
+	stats.completed = m_completed;
+	stats.coalesced = m_coalesced;
+	stats.cancelled = m_cancelled;
+
+	size_t count = std::min(m_latencyCount, s_latencyWindow);
+	for (size_t i = 0; i < count; ++i)
+	{
+		stats.meanLatency += m_latencies[i];
+		stats.maxLatency = std::max(stats.maxLatency, m_latencies[i]);
+	}
+	if (count > 0)
+		stats.meanLatency /= static_cast<float>(count);
+	return stats;
+}
+
+float MeshScheduler::priority(glm::vec3 center) const
+{
+	float distance = glm::length(center - m_cameraPosition) / static_cast<float>(Constants::chunkWidth);
+	if (!m_hasView || m_frustum.containsChunk(center))
+		return distance;
+	return s_outsideFrustumPriority + distance;
+}
+
+bool MeshScheduler::isFar(glm::vec3 center) const
+{
+	return m_hasView && glm::length(center - m_cameraPosition) >
+		m_settings.cancelDistance * static_cast<float>(Constants::chunkWidth);
+}
+
+void MeshScheduler::pushTicket()
+{
+	//as in PregenerationScheduler a ticket does not carry a job, it pops the most urgent one
+	//when a worker picks it up
+	m_pool->pushTask([this](size_t threadId) {
+		runTicket(threadId);
+		});
+}
+
+void MeshScheduler::runTicket(size_t threadId)
+{
+	size_t chunkIndex;
+	Task task;
+	std::vector<Callback> onDone;
+	Clock::time_point requested;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		float jobPriority;
+		if (!m_queue.tryPop(chunkIndex, jobPriority))
+			return;
+		auto& job = m_jobs[chunkIndex];
+		job.pending = false;
+		job.running = true;
+		task = std::move(job.task);
+		onDone.swap(job.onDone);
+		requested = job.requested;
+		++m_running;
+	}
+
+	task(threadId);
+	for (auto& callback : onDone)
+		callback();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	auto& job = m_jobs[chunkIndex];
+	job.running = false;
+	--m_running;
+	++m_completed;
+	m_latencies[m_latencyCount++ % s_latencyWindow] =
+		std::chrono::duration<float, std::milli>(Clock::now() - requested).count();
+
+	if (job.rerun)
+	{
+		job.rerun = false;
+		enqueue(chunkIndex);
+	}
+}
+
+void MeshScheduler::enqueue(size_t chunkIndex)
+{
+	auto& job = m_jobs[chunkIndex];
+	if (isFar(job.center))
+	{
+		job.parked = true;
+		m_parkedChunks.push_back(chunkIndex);
+		return;
+	}
+
+	job.pending = true;
+	if (m_queue.push(chunkIndex, priority(job.center)))
+		pushTicket();
+}
@@ -0,0 +1,96 @@
+#include "Rendering/MeshStats.h"
+
+namespace
+{
+	const std::array<const char*, enumCast(MeshStats::Metric::Count)> s_metricNames = {
+		"meshTimeUs", "allocationTimeUs", "uploadTimeUs", "triangles", "uploadBytes"
+	};
+	const std::array<const char*, enumCast(MeshStats::Counter::Count)> s_counterNames = {
+		"uploaded", "empty", "enclosed", "cacheHits"
+	};
+	const std::array<double, 4> s_percentiles = { 50.0, 90.0, 99.0, 99.9 };
+	const std::array<const char*, 4> s_percentileNames = { "p50", "p90", "p99", "p999" };
+}
+
+void MeshStats::Snapshot::writeJson(std::ostream& out) const
+{
+	out << "{\n\t\"counters\": {";
+	for (size_t i = 0; i < counters.size(); ++i)
+		out << (i == 0 ? "" : ",") << "\n\t\t\"" << s_counterNames[i] << "\": " << counters[i];
+	out << "\n\t},\n\t\"histograms\": {";
+
+	for (size_t i = 0; i < histograms.size(); ++i)
+	{
+		const auto& histogram = histograms[i];
+		out << (i == 0 ? "" : ",") << "\n\t\t\"" << s_metricNames[i] << "\": {"
+			<< "\n\t\t\t\"count\": " << histogram.getCount()
+			<< ",\n\t\t\t\"min\": " << histogram.getMin()
+			<< ",\n\t\t\t\"max\": " << histogram.getMax()
+			<< ",\n\t\t\t\"mean\": " << histogram.getMean();
+		for (size_t j = 0; j < s_percentiles.size(); ++j)
+			out << ",\n\t\t\t\"" << s_percentileNames[j] << "\": " << histogram.getPercentile(s_percentiles[j]);
+
+		//as [lower bound, count] pairs
+		out << ",\n\t\t\t\"buckets\": [";
+		bool first = true;
+		for (size_t bucket = 0; bucket < HistogramLayout::s_bucketCount; ++bucket)
+		{
+			if (histogram.getBucketCount(bucket) == 0)
+				continue;
+			out << (first ? "" : ", ") << "[" << HistogramLayout::getLowerBound(bucket) << ", "
+				<< histogram.getBucketCount(bucket) << "]";
+			first = false;
+		}
+		out << "]\n\t\t}";
+	}
+	out << "\n\t}\n}\n";
+}
+
+const char* MeshStats::getName(Metric metric)
+{
+	return s_metricNames[enumCast(metric)];
+}
+
+const char* MeshStats::getName(Counter counter)
+{
+	return s_counterNames[enumCast(counter)];
+}
+
+void MeshStats::init(size_t threadCount)
+{
+	m_slots.clear();
+	for (size_t i = 0; i < threadCount; ++i)
+		m_slots.push_back(std::make_unique<Slot>());
+}
+
+MeshStats::Snapshot MeshStats::getSnapshot() const
+{
+	Snapshot snapshot;
+	for (const auto& slot : m_slots)
+	{
+		for (size_t i = 0; i < snapshot.histograms.size(); ++i)
+			slot->histograms[i].addTo(snapshot.histograms[i]);
+		for (size_t i = 0; i < snapshot.counters.size(); ++i)
+			snapshot.counters[i] += slot->counters[i].load(std::memory_order_relaxed);
+	}
+	return snapshot;
+}
+
+void MeshStats::reset()
+{
+	for (auto& slot : m_slots)
+	{
+		for (auto& histogram : slot->histograms)
+			histogram.reset();
+		for (auto& counter : slot->counters)
+			counter.store(0, std::memory_order_relaxed);
+	}
+}
+
+uint64_t MeshStats::countTriangles(const QuadBuffer& records)
+{
+	uint64_t triangles = 0;
+	for (const auto& record : records)
+		triangles += (record.polygonExtent & QuadRecord::s_pairBit) != 0 ? 2 : 1;
+	return triangles;
+}
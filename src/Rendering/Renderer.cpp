@@ -1,5 +1,7 @@
 ﻿#include "Rendering/Renderer.h"
 
+#include <fstream>
+
 #ifdef _WIN32
 #include "imgui_impl_win32.h"
 #include <windows.h>
@@ -13,6 +15,8 @@ void Renderer::init(std::string engineName, std::string appName,
     Platform::Window& window, MT::ThreadPool& poolHandle, const EngineFilesystem& engineFiles)
 {
     m_poolHandle = &poolHandle;
+    m_meshStats.init(m_poolHandle->getWorkerCount());
+    m_meshStatsPath = engineFiles.getFile(EngineFilesystem::Directory::Cache, "MeshStats.json");
 
     m_instance.create(Gfx::AppInfo().setAppName(appName).setEngineName(engineName)
         .setAppVersion({1, 0, 0}).setEngineVersion({1, 0, 0}));
@@ -252,6 +256,10 @@ void Renderer::init(std::string engineName, std::string appName,
         m_perFrameInFlightObjects[i].renderFinishedSemaphore.create(m_device.getFunctionTable(), m_device);
         m_perFrameInFlightObjects[i].inFlightFence.create(m_device.getFunctionTable(), m_device,
             { Gfx::Flags::FenceCreate::Bits::Signaled });
+        m_perFrameInFlightObjects[i].uploadCommandBuffer =
+            m_graphicsCommandPool.allocateCommandBuffer(m_device.getFunctionTable(), m_device);
+        m_perFrameInFlightObjects[i].uploadFence.create(m_device.getFunctionTable(), m_device,
+            { Gfx::Flags::FenceCreate::Bits::None });
 
         //m_perFrameInFlightObjects[i].perFrameSet = sets[i];
         //m_uniformMemory.bindBuffer(m_instance, m_device,
@@ -320,6 +328,12 @@ void Renderer::configureMemory()
     m_stagingMapping = m_stagingMemory.map(m_device.getFunctionTable(), m_device);
     m_stagingMemorySize = 1024 * 1024 * 32;
 
+    Gfx::Utility::createBufferMemoryPairFirstFit(m_device.getFunctionTable(), m_device, m_deviceMemoryProps,
+        m_uploadRingBuffer, m_uploadRingMemory, s_uploadRingSize, Gfx::Flags::BufferUsage::Bits::TransferSrc,
+        Gfx::Flags::MemoryProperty::Bits::HostVisibleCoherent);
+    m_uploadRingMapping = m_uploadRingMemory.map(m_device.getFunctionTable(), m_device);
+    m_uploadRing.init(static_cast<std::byte*>(m_uploadRingMapping.get()), s_uploadRingSize);
+
     Gfx::Utility::createBufferMemoryPairFirstFit(m_device.getFunctionTable(), m_device, m_deviceMemoryProps,
         m_configBuffer, m_configMemory, 256 + m_chunkCount * Constants::chunkSize,
         Gfx::Flags::BufferUsage::Bits::UniformBuffer | Gfx::Flags::BufferUsage::Bits::StorageBuffer,
@@ -345,6 +359,23 @@ void Renderer::configureMemory()
 
 void Renderer::resetChunkBuffers(const WorldGrid& grid)
 {
+    //uploads queued for the old buffers are dropped along with them
+    for (auto& frame : m_perFrameInFlightObjects)
+        if (frame.uploadBatch != 0)
+        {
+            frame.uploadFence.wait(m_device.getFunctionTable(), m_device);
+            frame.uploadFence.reset(m_device.getFunctionTable(), m_device);
+            frame.uploadBatch = 0;
+        }
+    //the pool is recreated below, so its regions are not freed one by one
+    for (auto& frame : m_perFrameInFlightObjects)
+        frame.freedAllocations.clear();
+    {
+        std::lock_guard<std::mutex> lockUpload(m_uploadLock);
+        m_pendingUploads.clear();
+    }
+    m_uploadRing.init(static_cast<std::byte*>(m_uploadRingMapping.get()), s_uploadRingSize);
+
     if(m_gridBuffer.isValid())
     {   
         m_gridBuffer.destroy(m_device.getFunctionTable(), m_device);
@@ -371,24 +402,24 @@ void Renderer::resetChunkBuffers(const WorldGrid& grid)
         Gfx::Flags::MemoryProperty::Bits::HostVisibleCoherent);
 
     auto drawCommandBufferMemReq = Gfx::Utility::createBufferMemoryPairFirstFit(m_device.getFunctionTable(), 
-        m_device, m_deviceMemoryProps, m_drawCommandsBuffer, m_drawCommandsMemory, m_chunkCount * sizeof(PoolDrawCommand),
+        m_device, m_deviceMemoryProps, m_drawCommandsBuffer, m_drawCommandsMemory, s_framesInFlight * getFrameDrawCommandCapacity() * sizeof(PoolDrawCommand),
         Gfx::Flags::BufferUsage::Bits::TransferDst | Gfx::Flags::BufferUsage::Bits::IndirectBuffer 
         | Gfx::Flags::BufferUsage::Bits::StorageBuffer, Gfx::Flags::MemoryProperty::Bits::HostVisibleCoherent);
     m_drawCommandsMapping = m_drawCommandsMemory.map(m_device.getFunctionTable(), m_device);
 
     m_indicesPool.create(m_device.getFunctionTable(), m_device, m_deviceMemoryProps,
-        sizeof(Indices) * 8 * Constants::chunkSize * m_chunkCount, 
+        sizeof(QuadRecord) * 8 * Constants::chunkSize * m_chunkCount, 
         Gfx::Flags::BufferUsage::Bits::StorageBuffer | Gfx::Flags::BufferUsage::Bits::TransferDst, 
         Gfx::Flags::MemoryProperty::Bits::DeviceLocal, Gfx::Flags::MemoryProperty::Bits::None, 
         Gfx::SharingMode::Exclusive, [this](Gfx::MemoryRef memory, Gfx::BufferRef buffer, size_t bufferIndex)
         { this->onPoolBufferAlloc(memory, buffer, bufferIndex); });
         
-    std::memset(m_drawCommandsMapping.get(), 0, m_chunkCount * sizeof(PoolDrawCommand));
+    std::memset(m_drawCommandsMapping.get(), 0, s_framesInFlight * getFrameDrawCommandCapacity() * sizeof(PoolDrawCommand));
 
     std::vector<Gfx::DescriptorBufferInfo> bufferInfos = {
         { m_gridBuffer, 0, blockCount * sizeof(Id::VoxelState) },
         { m_chunkBuffer, 0, m_chunkCount * sizeof(WorldGrid::Chunk) },
-        { m_drawCommandsBuffer, 0, m_chunkCount * sizeof(PoolDrawCommand) }
+        { m_drawCommandsBuffer, 0, s_framesInFlight * getFrameDrawCommandCapacity() * sizeof(PoolDrawCommand) }
     };
 
     std::vector<Gfx::DescriptorSetWrite> writes = {
@@ -402,14 +433,17 @@ void Renderer::resetChunkBuffers(const WorldGrid& grid)
     m_indexAllocations.resize(m_chunkCount, 
         Gfx::MemoryManagement::MemoryPool::Allocation::getEmptyAllocation());
 
-    m_stagingBuffers.resize(m_poolHandle->getWorkerCount());
+    //the arenas and their peaks carry over, they only depend on what the chunks hold
+    m_meshScratch.resize(m_poolHandle->getWorkerCount());
 
-    for (size_t i = 0; i < m_stagingBuffers.size(); ++i)
-        m_stagingBuffers[i].reserve(Constants::chunkSize * 120);
+    m_chunkSolidity = std::make_unique<std::atomic<uint64_t>[]>(m_chunkCount);
+    m_chunkEnclosed = std::make_unique<std::atomic<bool>[]>(m_chunkCount);
+    m_meshStats.reset();
 
-    m_drawIndexToPoolIndex.clear();
-    m_chunkDrawIndices.clear();
-    m_chunkDrawIndices.resize(m_chunkCount);
+    m_chunkDraws.clear();
+    m_chunkDraws.resize(m_chunkCount);
+    m_meshScheduler.init(*m_poolHandle, m_chunkCount, MeshScheduler::Settings());
+    m_visibilityGraph.init(m_chunkCount);
     m_meshedChunks.resize(m_chunkCount, false);
 
     m_drawCommandAmount = 0;
@@ -424,6 +458,20 @@ void Renderer::createAndWriteAssets(AssetCache& assetCache,
         m_stagingMapping, m_stagingMemorySize, voxelStateCache);
     assetCache.writeToDescriptors(m_device, m_descriptorSets[static_cast<size_t>(DescriptorSetIndex::Storage)], 
         m_sampler, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11);
+
+    ChunkMesher::Sources sources;
+    sources.voxelStates = &voxelStateCache;
+    sources.models = &assetCache.getModelCache();
+    sources.geometries = &assetCache.getGeometryCache();
+    sources.appearances = &assetCache.getAppearanceCache();
+    sources.culling = &assetCache.getVoxelCullingCache();
+    sources.polygons = &assetCache.getPolygonCache();
+    sources.normals = &assetCache.getNormalCache();
+    m_chunkMesher.init(sources);
+    //Voxel.vert expands the merged quads and extends their uvs, Voxel.frag wraps them into [0, 1]
+    m_chunkMesher.setMode(ChunkMesher::Mode::Greedy);
+    //meshes of the previous assets would decode to the wrong polygons
+    m_meshCache.clear();
 }
 
 void Renderer::createLayouts()
@@ -490,6 +538,7 @@ void Renderer::cleanup(StorageCache& cache)
         m_perFrameInFlightObjects[i].imageAvailableSemaphore.destroy(m_device.getFunctionTable(), m_device);
         m_perFrameInFlightObjects[i].renderFinishedSemaphore.destroy(m_device.getFunctionTable(), m_device);
         m_perFrameInFlightObjects[i].inFlightFence.destroy(m_device.getFunctionTable(), m_device);
+        m_perFrameInFlightObjects[i].uploadFence.destroy(m_device.getFunctionTable(), m_device);
     }
 
     for(size_t i = 0; i < m_descriptorSetLayouts.size(); ++i) {
@@ -505,6 +554,9 @@ void Renderer::cleanup(StorageCache& cache)
     
     m_stagingMapping.unmap(m_device.getFunctionTable(), m_device, m_stagingMemory);
     m_stagingMemory.destroy(m_device.getFunctionTable(), m_device);
+    m_uploadRingBuffer.destroy(m_device.getFunctionTable(), m_device);
+    m_uploadRingMapping.unmap(m_device.getFunctionTable(), m_device, m_uploadRingMemory);
+    m_uploadRingMemory.destroy(m_device.getFunctionTable(), m_device);
     m_descriptorPool.destroy(m_device.getFunctionTable(), m_device);
 
     m_gridBuffer.destroy(m_device.getFunctionTable(), m_device);
@@ -562,7 +614,12 @@ void Renderer::cleanup(StorageCache& cache)
 
 void Renderer::handleResize(const Gfx::Extent2D& extent)
 {
-    std::lock_guard<std::mutex> lockStaging(m_stagingBufferLock);
+    std::unique_lock<std::shared_mutex> lock(m_drawLock);
+    recreateSwapChain(extent);
+}
+
+void Renderer::recreateSwapChain(const Gfx::Extent2D& extent)
+{
     m_device.waitIdle();
     auto surfaceCapabilities = m_physicalDevice.getSurfaceCapabilities(m_instance.getFunctionTable(), m_surface);
     m_canvas = Gfx::RenderRegion::createFullWindow(surfaceCapabilities.getCurrentExtent());
@@ -584,16 +641,42 @@ void Renderer::drawFrame(const Gfx::Utility::CameraPerspective& camera)
     m_pushConstants.view = camera.getView();
     m_pushConstants.viewProj = m_pushConstants.proj * m_pushConstants.view;
 
-    m_perFrameInFlightObjects[m_currentFrame].inFlightFence.wait(m_device.getFunctionTable(), m_device);
+    auto& frame = m_perFrameInFlightObjects[m_currentFrame];
+    frame.inFlightFence.wait(m_device.getFunctionTable(), m_device);
     std::unique_lock<std::shared_mutex> lock(m_drawLock);
-    m_perFrameInFlightObjects[m_currentFrame].inFlightFence.reset(m_device.getFunctionTable(), m_device);
-        
+
+    //acquired before anything of the frame is submitted, an out of date swap chain gives no image,
+    //so the frame is dropped with its fence still signaled and its uploads still pending
     uint32_t imageIndex;
     auto imageAquireResult = m_swapChainData.swapChain.acquireNextImage(m_device.getFunctionTable(), m_device,
-        m_perFrameInFlightObjects[m_currentFrame].imageAvailableSemaphore, imageIndex);
+        frame.imageAvailableSemaphore, imageIndex);
+    if (imageAquireResult == Gfx::Result::ErrorOutOfDateKHR)
+    {
+        recreateSwapChain(m_swapChainData.swapChainInfo.getImageExtent());
+        return;
+    }
 
-    if (imageAquireResult == Gfx::Result::ErrorOutOfDateKHR ||
-        imageAquireResult == Gfx::Result::SuboptimalKHR) return;
+    frame.inFlightFence.reset(m_device.getFunctionTable(), m_device);
+    //the ring space of the frame's last uploads can be written again
+    if (frame.uploadBatch != 0)
+    {
+        frame.uploadFence.wait(m_device.getFunctionTable(), m_device);
+        frame.uploadFence.reset(m_device.getFunctionTable(), m_device);
+        m_uploadRing.retire(frame.uploadBatch);
+        frame.uploadBatch = 0;
+    }
+    //the frames in flight were recorded after this one's uploads were applied, so none draws from these
+    releaseFreedAllocations(frame);
+    if (recordUploads(frame))
+    {
+        //the same queue as the draw, so the copies land before it reads the records
+        Gfx::QueueSubmitInfo uploadInfo(std::span(&frame.uploadCommandBuffer, 1), {}, {}, {});
+        m_graphicsQueue.submit(m_device.getFunctionTable(), uploadInfo, frame.uploadFence);
+    }
+    //the frame's fence was waited on so its slice is no longer read, the others may still be
+    m_pushConstants.firstDrawCommand = static_cast<uint32_t>(m_currentFrame * getFrameDrawCommandCapacity());
+    writeDrawCommands(m_pushConstants.viewProj, camera.getPosition(), m_pushConstants.firstDrawCommand);
+    m_meshScheduler.update(m_pushConstants.viewProj, camera.getPosition());
 
     m_perFrameInFlightObjects[m_currentFrame].graphicsCommandBuffer.reset(m_device.getFunctionTable());
     
@@ -626,7 +709,7 @@ void Renderer::drawFrame(const Gfx::Utility::CameraPerspective& camera)
         Gfx::Flags::ShaderStage::Bits::Vertex, 0, sizeof(PushConstants), &m_pushConstants);
 
     m_perFrameInFlightObjects[m_currentFrame].graphicsCommandBuffer.drawIndirect(m_device.getFunctionTable(),
-        m_drawCommandsBuffer, 0, m_drawCommandAmount, sizeof(PoolDrawCommand));
+        m_drawCommandsBuffer, m_pushConstants.firstDrawCommand * sizeof(PoolDrawCommand), m_drawCommandAmount, sizeof(PoolDrawCommand));
 
     drawGui(camera);
 
@@ -657,10 +740,13 @@ void Renderer::drawFrame(const Gfx::Utility::CameraPerspective& camera)
         std::span(&imageIndex, 1),
     };
     auto presentResult = m_presentQueue.present(m_device.getFunctionTable(), presentInfo);
-    if (presentResult == Gfx::Result::ErrorOutOfDateKHR ||
-        presentResult == Gfx::Result::SuboptimalKHR) return;
-
     m_currentFrame = (m_currentFrame + 1) % s_framesInFlight;
+
+    //a suboptimal image was still drawn and presented, the swap chain is replaced for the next frame
+    if (imageAquireResult == Gfx::Result::SuboptimalKHR ||
+        presentResult == Gfx::Result::ErrorOutOfDateKHR ||
+        presentResult == Gfx::Result::SuboptimalKHR)
+        recreateSwapChain(m_swapChainData.swapChainInfo.getImageExtent());
 }
 
 void Renderer::drawGui(const Gfx::Utility::CameraPerspective& camera)
@@ -683,7 +769,27 @@ void Renderer::drawGui(const Gfx::Utility::CameraPerspective& camera)
         ImGui::Text("Yaw:               %.2f", camera.getYaw());
         ImGui::Text("Pitch:             %.2f", camera.getPitch());
         ImGui::Text("Block count:       %.2u", static_cast<uint32_t>(m_chunkCount * Constants::chunkSize));
+        ImGui::Text("Faces drawn:       %u of %u",
+            static_cast<uint32_t>(m_drawnRecords), static_cast<uint32_t>(m_meshedRecords));
+        ImGui::Text("Chunks drawn:      %u of %u",
+            static_cast<uint32_t>(m_drawnChunks), static_cast<uint32_t>(m_meshedChunkCount));
+        auto meshStats = m_meshScheduler.getStats();
+        ImGui::Text("Mesh queue:        %u pending, %u running, %u parked",
+            static_cast<uint32_t>(meshStats.pending), static_cast<uint32_t>(meshStats.running),
+            static_cast<uint32_t>(meshStats.parked));
+        ImGui::Text("Mesh latency:      %.2f ms mean, %.2f ms max", meshStats.meanLatency, meshStats.maxLatency);
+        auto cacheStats = m_meshCache.getStats();
+        ImGui::Text("Mesh cache:        %.1f%% hits, %u entries, %.1f KiB",
+            cacheStats.hitRate() * 100.0f, static_cast<uint32_t>(cacheStats.entries), cacheStats.memory / 1024.0f);
+        auto ringStats = m_uploadRing.getStats();
+        ImGui::Text("Upload ring:       %.1f of %.1f MiB, %.1f peak, %u full waits",
+            ringStats.used / (1024.0f * 1024.0f), ringStats.capacity / (1024.0f * 1024.0f),
+            ringStats.peak / (1024.0f * 1024.0f), static_cast<uint32_t>(ringStats.waits));
+        ImGui::Text("Mesh requests:     %u done, %u merged, %u parked away",
+            static_cast<uint32_t>(meshStats.completed), static_cast<uint32_t>(meshStats.coalesced),
+            static_cast<uint32_t>(meshStats.cancelled));
     }
+    drawMeshStats();
     ImGui::Text("Memory Pool Usage:");
     size_t bufferCount = m_indicesPool.getMemoryChunkCount();
     ImGui::Text("Total buffer count: %u", static_cast<uint32_t>(bufferCount));
@@ -706,51 +812,74 @@ void Renderer::updateChunk(const ResourceCache& resources, size_t chunkPoolIndex
     auto startStaging = std::chrono::high_resolution_clock::now();
 
     auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+    //both buffers are reserved to the worker's peak so they take one arena allocation each,
+    //a denser chunk grows them through the arena's fallback path and raises the peak
+    auto& scratch = m_meshScratch[threadId];
+    scratch.arena.reset();
+    IndexBuffer polygons{ ArenaAllocator<Indices>(scratch.arena) };
+    QuadBuffer buffer{ ArenaAllocator<QuadRecord>(scratch.arena) };
+    polygons.reserve(scratch.polygonPeak);
+    buffer.reserve(scratch.recordPeak);
+
+    //chunks without faces still pass the view on, so the graph learns of every chunk
+    VisibilityGraph::Neighbours links;
+    for (size_t side = 0; side < links.size(); ++side)
+        links[side] = chunk.neighbourStarts[side] == WorldGrid::noChunkIndex ? VisibilityGraph::s_noChunk :
+            static_cast<uint32_t>(chunk.neighbourStarts[side] / Constants::chunkSize);
+    m_visibilityGraph.setChunk(chunkPoolIndex, glm::vec3(chunk.coordCorner),
+        m_chunkMesher.computeConnectivity(grid, chunkPoolIndex), links);
+
+    //a solid chunk behind solid neighbour faces has nothing visible, so it is not even hashed
+    std::array<ChunkMesher::Solidity, enumCast(Shape::Side::Count)> neighbours;
+    for (size_t side = 0; side < neighbours.size(); ++side)
+        neighbours[side] = links[side] == VisibilityGraph::s_noChunk ? 0 : getSolidity(resources, grid, links[side]);
+    bool isEnclosed = ChunkMesher::isEnclosed(getSolidity(resources, grid, chunkPoolIndex), neighbours);
+    m_chunkEnclosed[chunkPoolIndex].store(isEnclosed);
+    if (isEnclosed)
+    {
+        m_meshStats.count(threadId, MeshStats::Counter::Enclosed);
+        unmeshChunk(chunkPoolIndex);
+        return;
+    }
 
-    auto& assets = resources.getAssetCache();
-    auto& states = resources.getVoxelStateCache();
-    auto& models = assets.getModelCache();
-    auto& geometries = assets.getGeometryCache();
-    auto& appearances = assets.getAppearanceCache();
-    auto& geometriesCache = geometries.entryCache();
-    auto& appearancesCache = appearances.entryCache();
-	auto& cullingCache = assets.getVoxelCullingCache();
-
-    auto& buffer = m_stagingBuffers[threadId];
-
-    size_t chunkEnd = chunk.start + Constants::chunkSize;
-    for (size_t block = chunk.start; block < chunkEnd; ++block)
+    //records hold voxels within the chunk only, so any chunk with the same padded contents shares them
+    ChunkMesher::DirectionRanges ranges;
+    auto meshKey = m_chunkMesher.hashInput(grid, chunkPoolIndex);
+    bool isCached = m_meshCache.find(meshKey, buffer, ranges);
+    if (!isCached)
     {
-        cullingCache.populateBuffer(block,
-            (block - chunk.start) % Constants::chunkWidth,
-            (block - chunk.start) / Constants::chunkLayerSize,
-            ((block - chunk.start) % Constants::chunkLayerSize) / Constants::chunkWidth,
-            chunk, grid, buffer, states, models, geometriesCache,
-            appearancesCache, geometries, appearances);
+        m_chunkMesher.mesh(grid, chunkPoolIndex, polygons);
+        m_chunkMesher.packQuads(polygons, buffer, ranges);
+        m_meshCache.store(meshKey, buffer, ranges);
     }
+    scratch.polygonPeak = std::max(scratch.polygonPeak, polygons.size());
+    scratch.recordPeak = std::max(scratch.recordPeak, buffer.size());
 
     auto endStaging = std::chrono::high_resolution_clock::now();
     auto stagingDuration = std::chrono::duration_cast<std::chrono::microseconds>(endStaging - startStaging).count();
 
     auto startAllocation = std::chrono::high_resolution_clock::now();
     auto& allocation = m_indexAllocations[chunkPoolIndex];
+    auto previous = Gfx::MemoryManagement::MemoryPool::Allocation::getEmptyAllocation();
 
     if (buffer.size() == 0)
     {
+        m_meshStats.count(threadId, MeshStats::Counter::Empty);
         unmeshChunk(chunkPoolIndex);
         return;
     }
-    // else if (allocation.region.size > buffer.size() * sizeof(Indices))
+    // else if (allocation.region.size > buffer.size() * sizeof(QuadRecord))
     // {
     //     std::unique_lock<std::mutex> lock(m_poolLock);
-    //     m_indicesPool.shrink(allocation, buffer.size() * sizeof(Indices));
+    //     m_indicesPool.shrink(allocation, buffer.size() * sizeof(QuadRecord));
     // }
-    // else if (allocation.region.size < buffer.size() * sizeof(Indices))
+    // else if (allocation.region.size < buffer.size() * sizeof(QuadRecord))
     else
     {
+        //the old region is still drawn until the new one is swapped in, its upload frees it later
+        previous = allocation;
         std::unique_lock<std::mutex> lock(m_poolLock);
-        m_indicesPool.free(allocation);
-        allocation = m_indicesPool.allocate(m_device.getFunctionTable(), m_device, buffer.size() * sizeof(Indices),
+        allocation = m_indicesPool.allocate(m_device.getFunctionTable(), m_device, buffer.size() * sizeof(QuadRecord),
             [this](Gfx::MemoryRef memory, Gfx::BufferRef buffer, size_t bufferIndex) {
                 (void)memory;
                 Gfx::DescriptorBufferInfo bufferInfo = {
@@ -767,94 +896,258 @@ void Renderer::updateChunk(const ResourceCache& resources, size_t chunkPoolIndex
     auto allocationDuration = std::chrono::duration_cast<std::chrono::microseconds>(endAllocation - startAllocation).count();
 
     auto startMemoryPopulate = std::chrono::high_resolution_clock::now();
-    {        
-        {
-            std::array<Gfx::DataTransferInfo, 2> transferInfos = {
-                Gfx::DataTransferInfo{std::span<const Indices>(buffer), m_indicesPool.getBuffer(allocation.bufferIndex), 
-                    static_cast<size_t>(allocation.region.offset)},
-                Gfx::DataTransferInfo{&chunk, 0, m_chunkBuffer, sizeof(WorldGrid::Chunk) * chunkPoolIndex, sizeof(WorldGrid::Chunk)}
-            };
-
-            std::lock_guard<std::mutex> lockStaging(m_stagingBufferLock);
-            
-            m_temporaryBufferPool.oneTimeDataTransfer(m_device.getFunctionTable(), m_device, 
-                m_transferQueue, transferInfos, m_stagingBuffer, m_stagingMapping, m_stagingMemorySize);
-        }
-        
-        std::shared_lock<std::shared_mutex> lockDraw(m_drawLock);
-        m_perFrameInFlightObjects[m_currentFrame].inFlightFence.wait(m_device.getFunctionTable(), m_device);
-        std::lock_guard<std::mutex> lockCommand(m_drawCommandLock);
-        if (!m_meshedChunks[chunkPoolIndex])
-        {
-            m_chunkDrawIndices[chunkPoolIndex] = m_drawCommandAmount++;
-            m_drawIndexToPoolIndex.insert({ m_chunkDrawIndices[chunkPoolIndex], chunkPoolIndex });
-        }
-        
-        auto commands = m_drawCommandsMapping.get<PoolDrawCommand>(0, m_drawCommandAmount);
-        auto& command = commands[m_chunkDrawIndices[chunkPoolIndex]];
-        command.drawCommand.vertexCount = 3;
-        command.drawCommand.instanceCount = buffer.size();
-        command.drawCommand.firstVertex = 0;
-        command.drawCommand.firstInstance = allocation.region.offset / sizeof(Indices);
-        command.bufferId = allocation.bufferIndex;
+    {
+        //the worker only writes into the ring, the draw thread copies out of it with the next frame
+        PendingUpload upload;
+        upload.chunkIndex = chunkPoolIndex;
+        upload.isMeshed = true;
+        upload.recordBytes = buffer.size() * sizeof(QuadRecord);
+        upload.headerOffset = (upload.recordBytes + s_uploadAlignment - 1) & ~(s_uploadAlignment - 1);
+        upload.poolBufferIndex = allocation.bufferIndex;
+        upload.poolOffset = static_cast<size_t>(allocation.region.offset);
+        upload.draw.bufferId = static_cast<uint32_t>(allocation.bufferIndex);
+        upload.draw.firstInstance = static_cast<uint32_t>(allocation.region.offset / sizeof(QuadRecord));
+        upload.draw.ranges = ranges;
+        upload.draw.corner = glm::vec3(chunk.coordCorner);
+        upload.previous = previous;
+
+        //the ring is only cancelled on shutdown, the pool the chunk's region came from goes with it
+        StagingRing::Region region;
+        if (!m_uploadRing.allocate(upload.headerOffset + sizeof(WorldGrid::Chunk), s_uploadAlignment, region))
+            return;
+        std::memcpy(region.data, buffer.data(), upload.recordBytes);
+        std::memcpy(region.data + upload.headerOffset, &chunk, sizeof(WorldGrid::Chunk));
+        upload.ringSequence = region.sequence;
+        upload.ringOffset = region.offset;
+
+        std::lock_guard<std::mutex> lockUpload(m_uploadLock);
+        m_pendingUploads.push_back(upload);
     }
-    buffer.clear();
-    m_meshedChunks[chunkPoolIndex] = true;
     
     auto endMemoryPopulate = std::chrono::high_resolution_clock::now();
     auto memoryPopulateDuration = std::chrono::duration_cast<std::chrono::microseconds>(endMemoryPopulate - startMemoryPopulate).count();
     
-    m_debugConsole.log("Chunk {} updated with {} indices, "
-        "Allocation: size {}, offset {}, buffer {}\n"
-        "Timings (μs): Staging: {}, Allocation: {}, MemoryPopulate: {}\n",
-        chunkPoolIndex, buffer.size(),
-        allocation.region.size, allocation.region.offset, allocation.bufferIndex,
-        stagingDuration, allocationDuration, memoryPopulateDuration);
+    m_meshStats.count(threadId, MeshStats::Counter::Uploaded);
+    if (isCached)
+        m_meshStats.count(threadId, MeshStats::Counter::CacheHits);
+    m_meshStats.record(threadId, MeshStats::Metric::MeshTime, static_cast<uint64_t>(stagingDuration));
+    m_meshStats.record(threadId, MeshStats::Metric::AllocationTime, static_cast<uint64_t>(allocationDuration));
+    m_meshStats.record(threadId, MeshStats::Metric::UploadTime, static_cast<uint64_t>(memoryPopulateDuration));
+    m_meshStats.record(threadId, MeshStats::Metric::Triangles, MeshStats::countTriangles(buffer));
+    m_meshStats.record(threadId, MeshStats::Metric::UploadBytes,
+        buffer.size() * sizeof(QuadRecord) + sizeof(WorldGrid::Chunk));
 }
 
 void Renderer::unmeshChunk(size_t chunkPoolIndex)
 {
-    if (!m_meshedChunks[chunkPoolIndex])
-    {
-        m_debugConsole.log("Chunk {} was generated empty\n", chunkPoolIndex);
+    //only a chunk that was uploaded holds records
+    auto& allocation = m_indexAllocations[chunkPoolIndex];
+    if (allocation.region.size == 0)
         return;
-    }
 
-    auto startUnmesh = std::chrono::high_resolution_clock::now();
+    //queued behind the chunk's earlier uploads so none of them brings the draw back,
+    //the region is freed once no frame can read it anymore
+    PendingUpload removal;
+    removal.chunkIndex = chunkPoolIndex;
+    removal.previous = allocation;
+    allocation = Gfx::MemoryManagement::MemoryPool::Allocation::getEmptyAllocation();
+
+    std::lock_guard<std::mutex> lockUpload(m_uploadLock);
+    m_pendingUploads.push_back(removal);
+}
+
+bool Renderer::recordUploads(PerFrameObjects& frame)
+{
+    m_recordedUploads.clear();
     {
-        std::lock_guard<std::mutex> lockCommand(m_drawCommandLock);
-        auto index = m_chunkDrawIndices[chunkPoolIndex];
-        const auto& itCur = m_drawIndexToPoolIndex.find(index);
-        const auto& itNew = m_drawIndexToPoolIndex.find(m_drawCommandAmount--);
-        itCur->second = itNew->second;
-        m_chunkDrawIndices[itCur->second] = index;
-        m_drawIndexToPoolIndex.erase(itNew);
-
-        std::shared_lock<std::shared_mutex> lockDraw(m_drawLock);
-        m_perFrameInFlightObjects[m_currentFrame].inFlightFence.wait(m_device.getFunctionTable(), m_device);        
-        auto commands = m_drawCommandsMapping.get<PoolDrawCommand>(0, m_drawCommandAmount);
-        commands[index] = commands.back();
+        std::lock_guard<std::mutex> lockUpload(m_uploadLock);
+        std::swap(m_pendingUploads, m_recordedUploads);
     }
+    if (m_recordedUploads.empty())
+        return false;
 
-    auto& allocation = m_indexAllocations[chunkPoolIndex];
-    if (allocation.region.size != 0)
+    auto& commandBuffer = frame.uploadCommandBuffer;
+    commandBuffer.reset(m_device.getFunctionTable());
+    commandBuffer.begin(m_device.getFunctionTable(), Gfx::CommandBufferBeginInfo());
+
+    //records may land where the previous frame still read freed ones
+    commandBuffer.setPipelineBarrier(m_device.getFunctionTable(),
+        Gfx::Flags::PipelineStage::Bits::VertexShader, Gfx::Flags::PipelineStage::Bits::Transfer,
+        Gfx::Flags::Dependency::Bits::None, {}, {}, {});
+
+    m_recordedSequences.clear();
     {
         std::unique_lock<std::mutex> lock(m_poolLock);
+        for (const auto& upload : m_recordedUploads)
+        {
+            if (!upload.isMeshed)
+                continue;
+            commandBuffer.copyBuffer(m_device.getFunctionTable(), m_uploadRingBuffer,
+                m_indicesPool.getBuffer(upload.poolBufferIndex),
+                Gfx::BufferCopy{ upload.ringOffset, upload.poolOffset, upload.recordBytes });
+            commandBuffer.copyBuffer(m_device.getFunctionTable(), m_uploadRingBuffer, m_chunkBuffer,
+                Gfx::BufferCopy{ upload.ringOffset + upload.headerOffset,
+                    sizeof(WorldGrid::Chunk) * upload.chunkIndex, sizeof(WorldGrid::Chunk) });
+            m_recordedSequences.push_back(upload.ringSequence);
+        }
+    }
+
+    Gfx::MemoryBarrier uploaded = { Gfx::Flags::Access::Bits::TransferWrite, Gfx::Flags::Access::Bits::ShaderRead };
+    commandBuffer.setPipelineBarrier(m_device.getFunctionTable(),
+        Gfx::Flags::PipelineStage::Bits::Transfer, Gfx::Flags::PipelineStage::Bits::VertexShader,
+        Gfx::Flags::Dependency::Bits::None, std::span(&uploaded, 1), {}, {});
+    commandBuffer.stopRecord(m_device.getFunctionTable());
+    frame.uploadBatch = m_uploadRing.closeBatch(m_recordedSequences);
+
+    //in request order, so the latest upload or removal of a chunk wins
+    std::lock_guard<std::mutex> lockCommand(m_drawCommandLock);
+    for (const auto& upload : m_recordedUploads)
+    {
+        m_meshedChunks[upload.chunkIndex] = upload.isMeshed;
+        if (upload.isMeshed)
+            m_chunkDraws[upload.chunkIndex] = upload.draw;
+        if (upload.previous.region.size != 0)
+            frame.freedAllocations.push_back(upload.previous);
+    }
+    return true;
+}
+
+void Renderer::releaseFreedAllocations(PerFrameObjects& frame)
+{
+    if (frame.freedAllocations.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_poolLock);
+    for (auto& allocation : frame.freedAllocations)
         m_indicesPool.free(allocation);
+    frame.freedAllocations.clear();
+}
+
+void Renderer::writeDrawCommands(const glm::mat4& viewProj, glm::vec3 cameraPosition, size_t firstCommand)
+{
+    //with the camera outside of the meshed world every chunk is a candidate
+    bool isCulled = m_visibilityGraph.findVisible(Frustum::fromViewProj(viewProj), cameraPosition, m_visibleChunks);
+
+    std::lock_guard<std::mutex> lockCommand(m_drawCommandLock);
+    auto commands = m_drawCommandsMapping.get<PoolDrawCommand>(0, s_framesInFlight * getFrameDrawCommandCapacity());
+
+    m_drawCommandAmount = 0;
+    m_drawnRecords = 0;
+    m_meshedRecords = 0;
+    m_drawnChunks = 0;
+    m_meshedChunkCount = 0;
+    for (size_t i = 0; i < m_chunkCount; ++i)
+    {
+        if (!m_meshedChunks[i])
+            continue;
+
+        const auto& draw = m_chunkDraws[i];
+        m_meshedRecords += draw.ranges.back();
+        ++m_meshedChunkCount;
+        if (isCulled && !m_visibleChunks[i])
+            continue;
+
+        ++m_drawnChunks;
+        for (size_t bucket = 0; bucket < ChunkMesher::s_directionBuckets; ++bucket)
+        {
+            uint32_t count = draw.ranges[bucket + 1] - draw.ranges[bucket];
+            if (count == 0 || !ChunkMesher::canFaceCamera(bucket, draw.corner, cameraPosition))
+                continue;
+
+            auto& command = commands[firstCommand + m_drawCommandAmount++];
+            //two triangles per record, Voxel.vert collapses the second one of a lone triangle
+            command.drawCommand.vertexCount = 6;
+            command.drawCommand.instanceCount = count;
+            command.drawCommand.firstVertex = 0;
+            command.drawCommand.firstInstance = draw.firstInstance + draw.ranges[bucket];
+            command.bufferId = draw.bufferId;
+            command.chunkIndex = static_cast<uint32_t>(i);
+            m_drawnRecords += count;
+        }
     }
-    m_meshedChunks[chunkPoolIndex] = false;
+}
 
-    auto endUnmesh = std::chrono::high_resolution_clock::now();
-    auto unmeshDuration = std::chrono::duration_cast<std::chrono::microseconds>(endUnmesh - startUnmesh).count();
+ChunkMesher::Solidity Renderer::getSolidity(const ResourceCache& resources, const WorldGrid& grid, size_t chunkPoolIndex)
+{
+    //the version is read first, a change during the scan leaves a stale tag and a rescan next time
+    uint64_t version = grid.getChunkVersion(chunkPoolIndex);
+    uint64_t cached = m_chunkSolidity[chunkPoolIndex].load(std::memory_order_acquire);
+    if ((cached & s_solidityKnown) != 0 && (cached >> 8) == version)
+        return static_cast<ChunkMesher::Solidity>(cached & (s_solidityKnown - 1));
+
+    auto solidity = m_chunkMesher.summarizeSolidity(grid, chunkPoolIndex);
+    m_chunkSolidity[chunkPoolIndex].store((version << 8) | s_solidityKnown | solidity, std::memory_order_release);
+
+    //a neighbour skipped as enclosed judged this chunk's old faces, it may see through them now
+    auto previous = static_cast<ChunkMesher::Solidity>(cached & ChunkMesher::s_solidFaces);
+    if ((cached & s_solidityKnown) == 0 || previous == (solidity & ChunkMesher::s_solidFaces))
+        return solidity;
 
-    m_debugConsole.log("Chunk {} unmeshed\n Timings (μs): Unmesh: {}\n", chunkPoolIndex, unmeshDuration);
+    auto& chunk = grid.getPool().getField<1>()[chunkPoolIndex];
+    for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+    {
+        if (chunk.neighbourStarts[side] == WorldGrid::noChunkIndex)
+            continue;
+        size_t neighbour = chunk.neighbourStarts[side] / Constants::chunkSize;
+        if (m_chunkEnclosed[neighbour].load())
+            updateChunkAsync(resources, neighbour, grid);
+    }
+    return solidity;
 }
 
-void Renderer::updateChunkAsync(const ResourceCache& resources, size_t chunkIndex, const WorldGrid& grid)
+void Renderer::updateChunkAsync(const ResourceCache& resources, size_t chunkIndex, const WorldGrid& grid,
+    MeshScheduler::Callback onMeshed)
 {
-    m_poolHandle->pushTask([this, &resources, chunkIndex, &grid](size_t threadId) {
+    auto& chunk = grid.getPool().getField<1>()[chunkIndex];
+    glm::vec3 center = glm::vec3(chunk.coordCorner) + glm::vec3(Constants::chunkDimensions) * 0.5f;
+    m_meshScheduler.request(chunkIndex, center, [this, &resources, chunkIndex, &grid](size_t threadId) {
         updateChunk(resources, chunkIndex, grid, threadId);
-        });
+        }, std::move(onMeshed));
+}
+
+void Renderer::drawMeshStats()
+{
+    if (!ImGui::CollapsingHeader("Meshing"))
+        return;
+
+    auto stats = m_meshStats.getSnapshot();
+    ImGui::Text("Chunks:            %u uploaded, %u cached, %u empty, %u interior",
+        static_cast<uint32_t>(stats.get(MeshStats::Counter::Uploaded)),
+        static_cast<uint32_t>(stats.get(MeshStats::Counter::CacheHits)),
+        static_cast<uint32_t>(stats.get(MeshStats::Counter::Empty)),
+        static_cast<uint32_t>(stats.get(MeshStats::Counter::Enclosed)));
+
+    auto drawMetric = [&](const char* label, MeshStats::Metric metric) {
+        const auto& histogram = stats.get(metric);
+        ImGui::Text("%-18s p50 %u, p99 %u, max %u", label,
+            static_cast<uint32_t>(histogram.getPercentile(50.0)), static_cast<uint32_t>(histogram.getPercentile(99.0)),
+            static_cast<uint32_t>(histogram.getMax()));
+        };
+    drawMetric("Mesh us:", MeshStats::Metric::MeshTime);
+    drawMetric("Allocation us:", MeshStats::Metric::AllocationTime);
+    drawMetric("Upload us:", MeshStats::Metric::UploadTime);
+    drawMetric("Triangles:", MeshStats::Metric::Triangles);
+    drawMetric("Upload bytes:", MeshStats::Metric::UploadBytes);
+
+    //mesh times by power of two, the last bar holds everything slower
+    std::array<float, 16> octaves = {};
+    const auto& meshTime = stats.get(MeshStats::Metric::MeshTime);
+    for (size_t bucket = 0; bucket < HistogramLayout::s_bucketCount; ++bucket)
+    {
+        size_t octave = std::bit_width(HistogramLayout::getLowerBound(bucket));
+        octaves[std::min(octave, octaves.size() - 1)] += static_cast<float>(meshTime.getBucketCount(bucket));
+    }
+    ImGui::PlotHistogram("Mesh us, log2", octaves.data(), static_cast<int>(octaves.size()), 0, nullptr,
+        0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+
+    if (ImGui::Button("Dump to json"))
+    {
+        std::ofstream file(m_meshStatsPath, std::ios::trunc);
+        stats.writeJson(file);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+        m_meshStats.reset();
 }
 
 void Renderer::drawMemoryPoolVisualization(size_t chunkIndex) {
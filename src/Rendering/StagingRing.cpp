@@ -0,0 +1,137 @@
+#include "Rendering/StagingRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+void StagingRing::init(std::byte* data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_data = data;
+	m_size = size;
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+	m_spans.clear();
+	m_frontSequence = 0;
+	m_peak = 0;
+	m_waits = 0;
+	m_isCancelled = false;
+}
+
+bool StagingRing::allocate(size_t size, size_t alignment, Region& region)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	if (size + alignment > m_size)
+		throw std::runtime_error("Upload does not fit into the staging ring");
+
+	if (m_isCancelled)
+		return false;
+	if (place(size, alignment, region))
+		return true;
+
+	++m_waits;
+	m_released.wait(lock, [&]() { return m_isCancelled || place(size, alignment, region); });
+	return !m_isCancelled;
+}
+
+bool StagingRing::tryAllocate(size_t size, size_t alignment, Region& region)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_isCancelled)
+		return false;
+	if (place(size, alignment, region))
+		return true;
+	++m_waits;
+	return false;
+}
+
+uint64_t StagingRing::closeBatch(std::span<const uint64_t> sequences)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	uint64_t batch = m_nextBatch++;
+	for (auto sequence : sequences)
+		m_spans[sequence - m_frontSequence].batch = batch;
+	return batch;
+}
+
+void StagingRing::retire(uint64_t batch)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		for (auto& span : m_spans)
+			if (span.batch != 0 && span.batch <= batch)
+				span.isRetired = true;
+
+		//a region released out of order waits for the ones allocated before it
+		while (!m_spans.empty() && m_spans.front().isRetired)
+		{
+			m_tail = m_spans.front().end;
+			m_used -= m_spans.front().charge;
+			m_spans.pop_front();
+			++m_frontSequence;
+		}
+	}
+	m_released.notify_all();
+}
+
+void StagingRing::cancel()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_isCancelled = true;
+	}
+	m_released.notify_all();
+}
+
+StagingRing::Stats StagingRing::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	Stats stats;
+	stats.used = m_used;
+	stats.capacity = m_size;
+	stats.peak = m_peak;
+	stats.waits = m_waits;
+	stats.batches = m_nextBatch - 1;
+	return stats;
+}
+
+bool StagingRing::place(size_t size, size_t alignment, Region& region)
+{
+	//an empty ring starts over so a large region finds the whole buffer
+	if (m_used == 0)
+	{
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	size_t start = (m_head + alignment - 1) & ~(alignment - 1);
+	size_t charge = 0;
+	if (m_head > m_tail || m_used == 0)
+	{
+		//free space runs from the head to the end and from the start to the tail
+		if (start + size <= m_size)
+			charge = start - m_head + size;
+		else if (size <= m_tail)
+		{
+			start = 0;
+			charge = m_size - m_head + size;
+		}
+		else return false;
+	}
+	else
+	{
+		if (start + size > m_tail)
+			return false;
+		charge = start - m_head + size;
+	}
+
+	m_head = start + size;
+	m_used += charge;
+	m_peak = std::max(m_peak, m_used);
+	m_spans.push_back(Span{ m_head, charge, 0, false });
+
+	region.offset = start;
+	region.data = m_data + start;
+	region.sequence = m_frontSequence + m_spans.size() - 1;
+	return true;
+}
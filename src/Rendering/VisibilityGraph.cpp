@@ -0,0 +1,82 @@
+#include "Rendering/VisibilityGraph.h"
+
+void VisibilityGraph::init(size_t chunkCount)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_nodes.clear();
+	m_nodes.resize(chunkCount);
+	m_queue.clear();
+	m_queue.reserve(chunkCount);
+}
+
+void VisibilityGraph::setChunk(size_t chunkIndex, glm::vec3 corner, ChunkMesher::Connectivity connectivity,
+	const Neighbours& neighbours)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	auto& node = m_nodes[chunkIndex];
+	node.corner = corner;
+	node.connectivity = connectivity;
+	node.neighbours = neighbours;
+	node.isSet = true;
+
+	for (size_t side = 0; side < neighbours.size(); ++side)
+		if (neighbours[side] != s_noChunk)
+			m_nodes[neighbours[side]].neighbours[enumCast(reverseDir3D(side))] = static_cast<uint32_t>(chunkIndex);
+}
+
+bool VisibilityGraph::findVisible(const Frustum& frustum, glm::vec3 cameraPosition,
+	std::vector<bool>& visible)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	size_t start = findCameraChunk(cameraPosition);
+	if (start == s_noChunk)
+		return false;
+
+	visible.assign(m_nodes.size(), false);
+	visible[start] = true;
+
+	//breadth first, so a chunk is reached along one of the straightest paths to it
+	m_queue.clear();
+	m_queue.push_back(Step{ static_cast<uint32_t>(start), s_noSide, 0,
+		m_nodes[start].corner + glm::vec3(Constants::chunkDimensions) * 0.5f });
+	for (size_t next = 0; next < m_queue.size(); ++next)
+	{
+		auto step = m_queue[next];
+		const auto& node = m_nodes[step.chunk];
+		for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+		{
+			auto sideId = static_cast<Shape::Side>(side);
+			auto backSide = enumCast(reverseDir3D(side));
+			uint32_t neighbour = node.neighbours[side];
+			if (neighbour == s_noChunk || visible[neighbour] || (step.directions >> backSide & 1) != 0)
+				continue;
+			if (step.entered != s_noSide &&
+				!ChunkMesher::connects(node.connectivity, static_cast<Shape::Side>(step.entered), sideId))
+				continue;
+
+			glm::vec3 center = step.center + glm::vec3(Constants::directionsFloat3D[side]) *
+				glm::vec3(Constants::chunkDimensions);
+			if (!frustum.containsChunk(center))
+				continue;
+
+			visible[neighbour] = true;
+			m_queue.push_back(Step{ neighbour, static_cast<uint8_t>(backSide),
+				static_cast<uint8_t>(step.directions | 1 << side), center });
+		}
+	}
+	return true;
+}
+
+size_t VisibilityGraph::findCameraChunk(glm::vec3 cameraPosition) const
+{
+	glm::vec3 size = glm::vec3(Constants::chunkDimensions);
+	for (size_t i = 0; i < m_nodes.size(); ++i)
+	{
+		const auto& node = m_nodes[i];
+		glm::vec3 local = cameraPosition - node.corner;
+		if (node.isSet && local.x >= 0.0f && local.y >= 0.0f && local.z >= 0.0f &&
+			local.x < size.x && local.y < size.y && local.z < size.z)
+			return i;
+	}
+	return s_noChunk;
+}
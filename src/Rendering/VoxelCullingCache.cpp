@@ -1,4 +1,86 @@
 #include "Rendering/VoxelCullingCache.h"
+#include "Utility/Hash.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const double s_containmentEpsilon = 1e-5;
+
+	double signedArea(const Clip::PointD& a, const Clip::PointD& b, const Clip::PointD& c)
+	{
+		return ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) * 0.5;
+	}
+
+	bool isInsideTriangle(const Clip::PathD& triangle, const Clip::PointD& point)
+	{
+		double area = signedArea(triangle[0], triangle[1], triangle[2]);
+		if (std::abs(area) <= s_containmentEpsilon)
+			return false;
+		double orientation = area > 0 ? 1.0 : -1.0;
+		for (size_t i = 0; i < 3; ++i)
+			if (signedArea(triangle[i], triangle[(i + 1) % 3], point) * orientation < -s_containmentEpsilon)
+				return false;
+		return true;
+	}
+
+	bool isSame(double a, double b) { return std::abs(a - b) <= s_containmentEpsilon; }
+
+	//true when the two triangles split an axis aligned rectangle along one of its diagonals,
+	//which is how every parallelogram face is registered
+	bool getSplitRectangle(const Clip::PathD& a, const Clip::PathD& b, Clip::RectD& rectangle)
+	{
+		rectangle = Clip::RectD(a[0].x, a[0].y, a[0].x, a[0].y);
+		for (const auto* triangle : { &a, &b })
+			for (const auto& point : *triangle)
+			{
+				rectangle.left = std::min(rectangle.left, point.x);
+				rectangle.right = std::max(rectangle.right, point.x);
+				rectangle.top = std::min(rectangle.top, point.y);
+				rectangle.bottom = std::max(rectangle.bottom, point.y);
+			}
+		double area = (rectangle.right - rectangle.left) * (rectangle.bottom - rectangle.top);
+		if (area <= s_containmentEpsilon)
+			return false;
+
+		for (const auto* triangle : { &a, &b })
+		{
+			if (!isSame(std::abs(signedArea((*triangle)[0], (*triangle)[1], (*triangle)[2])), area * 0.5))
+				return false;
+			for (const auto& point : *triangle)
+				if (!(isSame(point.x, rectangle.left) || isSame(point.x, rectangle.right)) ||
+					!(isSame(point.y, rectangle.top) || isSame(point.y, rectangle.bottom)))
+					return false;
+		}
+
+		//two half area corner triangles cover the rectangle only if they share a diagonal
+		std::vector<Clip::PointD> shared;
+		for (const auto& pointA : a)
+			for (const auto& pointB : b)
+				if (isSame(pointA.x, pointB.x) && isSame(pointA.y, pointB.y))
+					shared.push_back(pointA);
+		return shared.size() == 2 && !isSame(shared[0].x, shared[1].x) && !isSame(shared[0].y, shared[1].y);
+	}
+
+	//nullopt when the adjacent polygons are not a shape the direct test understands
+	std::optional<bool> isCoveredAnalytically(const Clip::PathD& main, const Clip::PathsD& adjacent)
+	{
+		if (adjacent.empty())
+			return false;
+		if (adjacent.size() == 1)
+			return std::all_of(main.begin(), main.end(),
+				[&](const Clip::PointD& point) { return isInsideTriangle(adjacent[0], point); });
+
+		Clip::RectD rectangle;
+		if (adjacent.size() == 2 && getSplitRectangle(adjacent[0], adjacent[1], rectangle))
+			return std::all_of(main.begin(), main.end(), [&](const Clip::PointD& point) {
+				return point.x >= rectangle.left - s_containmentEpsilon && point.x <= rectangle.right + s_containmentEpsilon &&
+					point.y >= rectangle.top - s_containmentEpsilon && point.y <= rectangle.bottom + s_containmentEpsilon;
+				});
+		return std::nullopt;
+	}
+}
 
 void VoxelCullingCache::init(const Shape::PolygonIndexBuffer& geometries,
 	const Id::Cache<Shape::Polygon, Id::Polygon>& polygons,
@@ -6,9 +88,14 @@ void VoxelCullingCache::init(const Shape::PolygonIndexBuffer& geometries,
 	const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>& normals,
 	Shape::GeometryId standardBlockGeometryId)
 {
+	m_geometries = &geometries;
+	m_polygons = &polygons;
+	m_vertices = &vertices;
+	m_normals = &normals;
 	m_standardBlockGeometryId = standardBlockGeometryId;
-	// size is (N^2) * 6, 
-	// for 1000 models it would be 6 000 000 entries or approximately 68 Mega Bytes, which is acceptable
+	// the pair table is (N^2) * 6 ids, 2 bytes each while fewer than 65535 distinct masks exist,
+	// for 1000 models that is 12 Mega Bytes, the masks themselves are only clipped for pairs
+	// that actually meet in the world and identical masks are stored once
 	//empty geometry is not needed because the cache shows which faces to remove if geometry is not empty
 	
 	m_geometryAmount = geometries.entrySize();
@@ -16,39 +103,359 @@ void VoxelCullingCache::init(const Shape::PolygonIndexBuffer& geometries,
 	
 	for (size_t i = 0; i < enumCast(Shape::Side::Count); ++i)
 		m_sideOffsets[i] = i * m_geometryAmountSquared;
-		
-	m_cullings.reserveEntryData(m_geometryAmountSquared * enumCast(Shape::Side::Count));
-	//one entry would have at least one index
-	m_cullings.reserveIndexData(m_geometryAmountSquared * enumCast(Shape::Side::Count));
-	m_cullingIds.reserve(m_geometryAmountSquared * enumCast(Shape::Side::Count));
-	
+
+	m_pairCount = m_geometryAmountSquared * enumCast(Shape::Side::Count);
+	m_wideIds.store(nullptr, std::memory_order_relaxed);
+	m_wideIdStorage.reset();
+	m_narrowIds = std::make_unique<std::atomic<NarrowId>[]>(m_pairCount);
+	for (size_t cell = 0; cell < m_pairCount; ++cell)
+		m_narrowIds[cell].store(s_unknownNarrowId, std::memory_order_relaxed);
+	resetStorage();
+	m_computedPairs = 0;
+	m_savedPairs = 0;
+
 	size_t maxEntrySize = 0;
-	
-	for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+	const auto& entries = geometries.entryData();
+	m_geometryBounds.assign(entries.size(), { glm::vec3(std::numeric_limits<float>::max()),
+		glm::vec3(-std::numeric_limits<float>::max()) });
+	for (size_t i = 0; i < entries.size(); ++i)
 	{
-		for (size_t i = 0; i < m_geometryAmount; ++i)
-		{
-			for (size_t j = 0; j < m_geometryAmount; ++j)
-			{				
-				auto mask = cull(geometries, polygons, vertices, normals,
-					static_cast<Shape::GeometryId>(i),
-					static_cast<Shape::GeometryId>(j),
-					static_cast<Shape::Side>(side));
-				if (mask.size() > maxEntrySize)
-					maxEntrySize = mask.size();
-				m_cullingIds.push_back(m_cullings.add(mask));
+		maxEntrySize = std::max<size_t>(maxEntrySize, (entries[i].size + sizeof(BitMask) * 8 - 1) / (sizeof(BitMask) * 8));
+		for (size_t j = 0; j < entries[i].size; ++j)
+			for (auto position : polygons[geometries[entries[i].start + j]].position)
+			{
+				auto vertex = glm::vec3(vertices[position]);
+				m_geometryBounds[i][0] = glm::min(m_geometryBounds[i][0], vertex);
+				m_geometryBounds[i][1] = glm::max(m_geometryBounds[i][1], vertex);
 			}
+	}
+
+	//a power of two stride keeps every mask inside one segment and turns ids into starts with a shift
+	m_maskStrideBits = 0;
+	while ((size_t(1) << m_maskStrideBits) < maxEntrySize)
+		++m_maskStrideBits;
+	if (m_maskStrideBits > s_segmentBits)
+		throw std::runtime_error("Geometry has too many polygons for a culling mask");
+	storeMask({});
+	m_contentHash = computeContentHash();
+}
+
+void VoxelCullingCache::resetStorage()
+{
+	for (auto& segment : m_segments)
+		segment.reset();
+	m_segmentViews.fill(nullptr);
+	m_mapping.close();
+	m_maskIds.clear();
+	m_maskCount = 0;
+}
+
+uint64_t VoxelCullingCache::computeContentHash() const
+{
+	Fnv1a hash;
+	hash.add(s_fileVersion).add<uint64_t>(sizeof(BitMask));
+
+	hash.add<uint64_t>(m_geometries->entrySize());
+	for (const auto& entry : m_geometries->entryData())
+		hash.add(entry.start).add(entry.size).add(enumCast(entry.metadata.geometryType));
+	hash.add<uint64_t>(m_geometries->indexSize());
+	for (auto polygon : m_geometries->indexData())
+		hash.add(static_cast<uint32_t>(polygon));
+
+	hash.add<uint64_t>(m_polygons->size());
+	for (const auto& polygon : m_polygons->data())
+	{
+		for (auto position : polygon.position)
+			hash.add(static_cast<uint32_t>(position));
+		hash.add(static_cast<uint32_t>(polygon.normal));
+	}
+
+	hash.add<uint64_t>(m_vertices->size());
+	for (const auto& vertex : m_vertices->data())
+		hash.add(vertex);
+	hash.add<uint64_t>(m_normals->size());
+	for (const auto& normal : m_normals->data())
+		hash.add(normal);
+	return hash.get();
+}
+
+bool VoxelCullingCache::load(const std::filesystem::path& path)
+{
+	static_assert(sizeof(FileHeader) % sizeof(BitMask) == 0 && alignof(BitMask) <= alignof(WideId),
+		"Mask words in a mapped table must stay aligned");
+
+	std::unique_lock<std::mutex> lock(m_computeMutex);
+	MappedFile mapping;
+	if (!mapping.open(path) || mapping.size() < sizeof(FileHeader))
+		return false;
+
+	FileHeader header;
+	std::memcpy(&header, mapping.data(), sizeof(header));
+	size_t stride = size_t(1) << m_maskStrideBits;
+	bool valid = header.magic == s_fileMagic && header.version == s_fileVersion &&
+		header.contentHash == m_contentHash && header.pairCount == m_pairCount &&
+		header.maskStride == stride && header.maskCount > 0 &&
+		header.maskCount * stride <= s_maxSegments * s_segmentSize &&
+		mapping.size() == sizeof(FileHeader) + header.pairCount * sizeof(WideId) +
+			header.maskCount * stride * sizeof(BitMask);
+	if (!valid)
+		return false;
+
+	auto bytes = static_cast<const uint8_t*>(mapping.data());
+	const WideId* ids = reinterpret_cast<const WideId*>(bytes + sizeof(FileHeader));
+	const BitMask* words = reinterpret_cast<const BitMask*>(ids + header.pairCount);
+	for (size_t cell = 0; cell < header.pairCount; ++cell)
+		if (ids[cell] != s_unknownId && ids[cell] >= header.maskCount)
+			return false;
+
+	//full segments are read straight from the mapping, the last partial one is copied so masks
+	//clipped later can be appended right after the loaded ones
+	resetStorage();
+	m_wideIds.store(nullptr, std::memory_order_relaxed);
+	m_wideIdStorage.reset();
+	for (size_t cell = 0; cell < m_pairCount; ++cell)
+		m_narrowIds[cell].store(s_unknownNarrowId, std::memory_order_relaxed);
+	m_maskCount = static_cast<size_t>(header.maskCount);
+	size_t wordCount = m_maskCount << m_maskStrideBits;
+	for (size_t segment = 0; segment * s_segmentSize < wordCount; ++segment)
+	{
+		size_t first = segment * s_segmentSize;
+		if (first + s_segmentSize <= wordCount)
+			m_segmentViews[segment] = words + first;
+		else
+		{
+			m_segments[segment] = std::make_unique<BitMask[]>(s_segmentSize);
+			std::copy(words + first, words + wordCount, m_segments[segment].get());
+			m_segmentViews[segment] = m_segments[segment].get();
+		}
+	}
+	for (size_t id = 0; id < m_maskCount; ++id)
+		m_maskIds.emplace(std::vector<BitMask>(words + (id << m_maskStrideBits), words + ((id + 1) << m_maskStrideBits)),
+			static_cast<WideId>(id));
+
+	size_t knownPairs = 0;
+	for (size_t cell = 0; cell < header.pairCount; ++cell)
+		if (ids[cell] != s_unknownId)
+		{
+			publishId(cell, ids[cell]);
+			++knownPairs;
+		}
+	m_computedPairs = knownPairs;
+	m_savedPairs = knownPairs;
+	m_mapping = std::move(mapping);
+	return true;
+}
+
+bool VoxelCullingCache::save(const std::filesystem::path& path) const
+{
+	std::unique_lock<std::mutex> lock(m_computeMutex);
+
+	FileHeader header = {};
+	header.magic = s_fileMagic;
+	header.version = s_fileVersion;
+	header.contentHash = m_contentHash;
+	header.pairCount = m_pairCount;
+	header.maskCount = m_maskCount;
+	header.maskStride = size_t(1) << m_maskStrideBits;
+
+	std::vector<WideId> ids(m_pairCount);
+	for (size_t cell = 0; cell < ids.size(); ++cell)
+		ids[cell] = readId(cell, std::memory_order_relaxed);
+
+	//written under a temporary name and renamed, a crash never leaves a truncated table behind
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+	auto temporaryPath = path;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(WideId));
+
+		size_t wordCount = m_maskCount << m_maskStrideBits;
+		for (size_t segment = 0; segment * s_segmentSize < wordCount; ++segment)
+			file.write(reinterpret_cast<const char*>(m_segmentViews[segment]),
+				std::min(s_segmentSize, wordCount - segment * s_segmentSize) * sizeof(BitMask));
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+	}
+
+	//windows refuses to replace a file that is mapped, such as the one this table was loaded from,
+	//but lets it be moved aside, the old file goes once it is no longer mapped
+	auto previousPath = path;
+	previousPath += ".old";
+	std::filesystem::remove(previousPath, error);
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		std::filesystem::rename(path, previousPath, error);
+		if (!error)
+		{
+			std::filesystem::rename(temporaryPath, path, error);
+			std::error_code restoreError;
+			if (error)
+				std::filesystem::rename(previousPath, path, restoreError);
 		}
 	}
-	m_noCullingId = m_cullings.add(std::vector<BitMask>(maxEntrySize, 0));
-	m_noCullingIndex = m_cullings.entryCache()[m_noCullingId].start;
+	if (error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	m_savedPairs = m_computedPairs.load(std::memory_order_relaxed);
+	return true;
+}
+
+//a polygon can only be hidden by a coplanar one, so the main geometry has to reach at least as far
+//along the side as the adjacent one starts
+bool VoxelCullingCache::canTouch(Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side) const
+{
+	glm::vec3 direction = Constants::directionsFloat3D[enumCast(side)];
+	const auto& main = m_geometryBounds[geometryMain];
+	const auto& adj = m_geometryBounds[geometryAdj];
+	float mainReach = 0.0f;
+	float adjStart = glm::dot(direction, direction);
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		mainReach += std::max(main[0][axis] * direction[axis], main[1][axis] * direction[axis]);
+		adjStart += std::min(adj[0][axis] * direction[axis], adj[1][axis] * direction[axis]);
+	}
+	return adjStart <= mainReach + 1e-4f;
+}
+
+size_t VoxelCullingCache::getMaskCount() const
+{
+	std::unique_lock<std::mutex> lock(m_computeMutex);
+	return m_maskCount;
+}
+
+size_t VoxelCullingCache::getMaskWordCount() const
+{
+	return getMaskCount() << m_maskStrideBits;
+}
+
+size_t VoxelCullingCache::getMemoryUsage() const
+{
+	size_t idSize = usesWideIds() ? sizeof(WideId) : sizeof(NarrowId);
+	return m_pairCount * idSize + getMaskWordCount() * sizeof(BitMask);
+}
+
+size_t VoxelCullingCache::computeCulling(Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj,
+	Shape::Side side, size_t cell) const
+{
+	//clipping runs outside the lock, threads racing on the same pair get the same mask and
+	//only the first one publishes it
+	auto mask = cull(*m_geometries, *m_polygons, *m_vertices, *m_normals, geometryMain, geometryAdj, side);
+
+	std::unique_lock<std::mutex> lock(m_computeMutex);
+	WideId id = readId(cell, std::memory_order_relaxed);
+	if (id == s_unknownId)
+	{
+		id = storeMask(std::move(mask));
+		publishId(cell, id);
+		m_computedPairs.fetch_add(1, std::memory_order_relaxed);
+	}
+	return size_t(id) << m_maskStrideBits;
+}
+
+void VoxelCullingCache::buildAll(const TaskRunner& run)
+{
+	const size_t cellsPerTask = 64;
+	size_t cellCount = m_pairCount;
+	size_t taskCount = (cellCount + cellsPerTask - 1) / cellsPerTask;
+	std::vector<std::vector<BitMask>> masks(cellCount);
+	std::vector<uint8_t> clipped(cellCount, 0);
+
+	run(taskCount, [&](size_t task) {
+		size_t end = std::min(cellCount, (task + 1) * cellsPerTask);
+		for (size_t cell = task * cellsPerTask; cell < end; ++cell)
+		{
+			if (readId(cell, std::memory_order_acquire) != s_unknownId)
+				continue;
+			size_t pair = cell % m_geometryAmountSquared;
+			masks[cell] = cull(*m_geometries, *m_polygons, *m_vertices, *m_normals,
+				static_cast<Shape::GeometryId>(static_cast<uint32_t>(pair / m_geometryAmount)),
+				static_cast<Shape::GeometryId>(static_cast<uint32_t>(pair % m_geometryAmount)),
+				static_cast<Shape::Side>(cell / m_geometryAmountSquared));
+			clipped[cell] = 1;
+		}
+		});
+
+	//stored serially in table order, the ids do not depend on which thread clipped what
+	std::unique_lock<std::mutex> lock(m_computeMutex);
+	for (size_t cell = 0; cell < cellCount; ++cell)
+	{
+		if (!clipped[cell] || readId(cell, std::memory_order_relaxed) != s_unknownId)
+			continue;
+		publishId(cell, storeMask(std::move(masks[cell])));
+		m_computedPairs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void VoxelCullingCache::publishId(size_t cell, WideId id) const
+{
+	auto wide = m_wideIds.load(std::memory_order_relaxed);
+	if (!wide && id >= s_unknownNarrowId)
+	{
+		//readers that still see the narrow table keep finding valid ids there, anything they
+		//find unknown is looked up again in the wide table under the lock
+		m_wideIdStorage = std::make_unique<std::atomic<WideId>[]>(m_pairCount);
+		for (size_t i = 0; i < m_pairCount; ++i)
+		{
+			NarrowId narrow = m_narrowIds[i].load(std::memory_order_relaxed);
+			m_wideIdStorage[i].store(narrow != s_unknownNarrowId ? narrow : s_unknownId, std::memory_order_relaxed);
+		}
+		wide = m_wideIdStorage.get();
+		m_wideIds.store(wide, std::memory_order_release);
+	}
+
+	if (wide)
+		wide[cell].store(id, std::memory_order_release);
+	else m_narrowIds[cell].store(static_cast<NarrowId>(id), std::memory_order_release);
+}
+
+//masks are padded to the stride, so a short mask and a longer one that only adds zero words
+//share their id, which makes id 0 the all zero mask of every geometry
+VoxelCullingCache::WideId VoxelCullingCache::storeMask(std::vector<BitMask> mask) const
+{
+	size_t stride = size_t(1) << m_maskStrideBits;
+	if (mask.size() > stride)
+		throw std::runtime_error("Culling mask is longer than the mask stride");
+	mask.resize(stride, 0);
+	if (m_maskCount > 0 && std::all_of(mask.begin(), mask.end(), [](BitMask word) { return word == 0; }))
+		return 0;
+
+	auto it = m_maskIds.find(mask);
+	if (it != m_maskIds.end())
+		return it->second;
+	if (((m_maskCount + 1) << m_maskStrideBits) > s_maxSegments * s_segmentSize || m_maskCount >= s_unknownId)
+		throw std::runtime_error("Culling mask storage exhausted");
+
+	size_t first = m_maskCount << m_maskStrideBits;
+	auto& segment = m_segments[first >> s_segmentBits];
+	if (!segment)
+	{
+		segment = std::make_unique<BitMask[]>(s_segmentSize);
+		m_segmentViews[first >> s_segmentBits] = segment.get();
+	}
+	std::copy(mask.begin(), mask.end(), segment.get() + (first & (s_segmentSize - 1)));
+
+	auto id = static_cast<WideId>(m_maskCount++);
+	m_maskIds.emplace(std::move(mask), id);
+	return id;
 }
 
 std::vector<VoxelCullingCache::BitMask> VoxelCullingCache::cull(const Shape::PolygonIndexBuffer& geometries,
 	const Id::Cache<Shape::Polygon, Id::Polygon>& polygons,
 	const Id::Cache<glm::vec4, Id::Vertex, VecEpsilonEqualComparator<glm::vec4>>& vertices,
 	const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>& normals,
-	Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side)
+	Shape::GeometryId geometryMain, Shape::GeometryId geometryAdj, Shape::Side side) const
 {
 	//auto entry = geometries.entryCache()[geometryMain];
 	//auto maskSize = (entry.size - 1) / (sizeof(BitMask) * 8) + 1;
@@ -59,6 +466,9 @@ std::vector<VoxelCullingCache::BitMask> VoxelCullingCache::cull(const Shape::Pol
 	auto& entryMain = geometryEntries[geometryMain];
 	auto& entryAdj = geometryEntries[geometryAdj];
 
+	if (m_analyticFastPath && !canTouch(geometryMain, geometryAdj, side))
+		return std::vector<BitMask>((entryMain.size + sizeof(BitMask) * 8 - 1) / (sizeof(BitMask) * 8), 0);
+
 	for (size_t i = 0; i < entryMain.size; ++i)
 	{
 		clipPolygon(i, Constants::directionsFloat3D[enumCast(side)], entryMain, entryAdj,
@@ -75,13 +485,10 @@ inline void VoxelCullingCache::clipPolygon(size_t i, glm::vec3 adjOffset,
 	const Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>>& normals,
 	std::vector<BitMask>& result) const
 {
-	Clip::ClipperD clipper;
-	Clip::PathsD adjUnion;
 	Clip::PathD mainPoly;
+	Clip::PathsD adjPolys;
 	if (i % ((sizeof(BitMask) * 8)) == 0)
 		result.push_back(0);
-	mainPoly.clear();
-	adjUnion.clear();
 
 	auto polygonId = geometries[entryMain.start + i];
 	auto polygon = polygons[polygonId];
@@ -118,7 +525,7 @@ inline void VoxelCullingCache::clipPolygon(size_t i, glm::vec3 adjOffset,
 		{
 			auto vertex = glm::vec3(vertices[polygon.position[vert]]) + adjOffset;
 			auto projection = cs.worldToLocal(vertex);
-			if (abs(projection.z) > std::numeric_limits<float>::epsilon())
+			if (std::abs(projection.z) > 1e-4f)
 				continue;
 			adjPoly.push_back(Clip::PointD(projection.x, projection.y));
 		}
@@ -129,9 +536,27 @@ inline void VoxelCullingCache::clipPolygon(size_t i, glm::vec3 adjOffset,
 			auto projection = cs.worldToLocal(vertex);
 			adjPoly.push_back(Clip::PointD(projection.x, projection.y));
 		}
-		clipper.AddSubject(Clip::PathsD{ adjPoly });
+		adjPolys.push_back(std::move(adjPoly));
+	}
+
+	if (adjPolys.empty())
+		return;
+	if (m_analyticFastPath)
+	{
+		auto covered = isCoveredAnalytically(mainPoly, adjPolys);
+		if (covered.has_value())
+		{
+			if (*covered)
+				result.back() |= (1 << (i % ((sizeof(BitMask) * 8))));
+			return;
+		}
 	}
 
+	//only built when the direct test could not decide, constructing a clipper is not free
+	Clip::ClipperD clipper;
+	Clip::PathsD adjUnion;
+	for (const auto& adjPoly : adjPolys)
+		clipper.AddSubject(Clip::PathsD{ adjPoly });
 	bool success = clipper.Execute(Clip::ClipType::Union,
 		Clip::FillRule::EvenOdd,
 		adjUnion);
@@ -149,7 +574,7 @@ inline void VoxelCullingCache::clipPolygon(size_t i, glm::vec3 adjOffset,
 
 void VoxelCullingCache::populateBuffer(size_t block, size_t x, size_t y, size_t z,
 	const WorldGrid::Chunk& chunk, 
-	const WorldGrid& grid, std::vector<Indices>& indices,
+	const WorldGrid& grid, IndexBuffer& indices,
 	const Id::NamedCache<Voxel::State, Id::VoxelState>& voxelStates,
 	const Id::NamedCache<Shape::Model, Id::Model>& modelCache,
 	const Shape::PolygonIndexBuffer::EntryCache& geometryEntries,
@@ -175,7 +600,7 @@ void VoxelCullingCache::populateBuffer(size_t block, size_t x, size_t y, size_t
 	{
 		currentMask = 0;
 		for (size_t j = 0; j < enumCast(Shape::Side::Count); ++j)
-			currentMask |= m_cullings[cullingIndices[j] + i];
+			currentMask |= getMaskWord(cullingIndices[j] + i);
 		for (size_t j = 0; j < (sizeof(BitMask) * 8); ++j)
 		{
 			if ((currentMask & 1) == 0)
@@ -190,9 +615,12 @@ void VoxelCullingCache::populateBuffer(size_t block, size_t x, size_t y, size_t
 		}
 	}
 
+	//the last word does not exist when the size is a multiple of the word size
+	if (rest == 0)
+		return;
 	currentMask = 0;
 	for (size_t j = 0; j < enumCast(Shape::Side::Count); ++j)
-		currentMask |= m_cullings[cullingIndices[j] + count];
+		currentMask |= getMaskWord(cullingIndices[j] + count);
 	for (size_t j = 0; j < rest; ++j)
 	{
 		if ((currentMask & 1) == 0)
@@ -207,25 +635,24 @@ void VoxelCullingCache::populateBuffer(size_t block, size_t x, size_t y, size_t
 	}
 }
 
-std::array<VoxelCullingCache::CullingId, enumCast(Shape::Side::Count)> VoxelCullingCache::getCullingIndices(
+std::array<size_t, enumCast(Shape::Side::Count)> VoxelCullingCache::getCullingIndices(
 	size_t block, size_t x, size_t y, size_t z, Shape::GeometryId geometryMain,
 	const WorldGrid::Chunk& chunk, const WorldGrid& grid,
 	const Id::NamedCache<Voxel::State, Id::VoxelState>& voxelStates,
 	const Id::NamedCache<Shape::Model, Id::Model>& modelCache) const
 {
-	std::array<CullingId, enumCast(Shape::Side::Count)> cullingIndices;
-	auto& cullingEntries = m_cullings.entryCache();
+	std::array<size_t, enumCast(Shape::Side::Count)> cullingIndices;
 	cullingIndices[enumCast(Shape::Side::Bottom)] = getCullingIndex<Shape::Side::Bottom>(
-		block, x, y, z, geometryMain, chunk, grid, cullingEntries, voxelStates, modelCache);
+		block, x, y, z, geometryMain, chunk, grid, voxelStates, modelCache);
 	cullingIndices[enumCast(Shape::Side::Top)] = getCullingIndex<Shape::Side::Top>(
-		block, x, y, z, geometryMain, chunk, grid, cullingEntries, voxelStates, modelCache);
+		block, x, y, z, geometryMain, chunk, grid, voxelStates, modelCache);
 	cullingIndices[enumCast(Shape::Side::Left)] = getCullingIndex<Shape::Side::Left>(
-		block, x, y, z, geometryMain, chunk, grid, cullingEntries, voxelStates, modelCache);
+		block, x, y, z, geometryMain, chunk, grid, voxelStates, modelCache);
 	cullingIndices[enumCast(Shape::Side::Right)] = getCullingIndex<Shape::Side::Right>(
-		block, x, y, z, geometryMain, chunk, grid, cullingEntries, voxelStates, modelCache);
+		block, x, y, z, geometryMain, chunk, grid, voxelStates, modelCache);
 	cullingIndices[enumCast(Shape::Side::Back)] = getCullingIndex<Shape::Side::Back>(
-		block, x, y, z, geometryMain, chunk, grid, cullingEntries, voxelStates, modelCache);
+		block, x, y, z, geometryMain, chunk, grid, voxelStates, modelCache);
 	cullingIndices[enumCast(Shape::Side::Front)] = getCullingIndex<Shape::Side::Front>(
-		block, x, y, z, geometryMain, chunk, grid, cullingEntries, voxelStates, modelCache);
+		block, x, y, z, geometryMain, chunk, grid, voxelStates, modelCache);
 	return cullingIndices;
 }
\ No newline at end of file
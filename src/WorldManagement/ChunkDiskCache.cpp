@@ -0,0 +1,139 @@
+#include "WorldManagement/ChunkDiskCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+void ChunkDiskCache::init(const std::filesystem::path& root, SeedType seed, uint64_t parametersHash)
+{
+	m_seed = seed;
+	m_parametersHash = parametersHash;
+	m_directory = root / getKeyName(seed, parametersHash);
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+	if (error)
+	{
+		std::cerr << "Chunk cache disabled, failed to create " << m_directory.string()
+			<< ": " << error.message() << std::endl;
+		m_enabled = false;
+		return;
+	}
+	m_enabled = true;
+
+	//the key name starts with the seed, anything else with the same prefix was made by older settings
+	std::string seedPrefix = getKeyName(seed, 0).substr(0, 17);
+	for (const auto& entry : std::filesystem::directory_iterator(root, error))
+	{
+		auto name = entry.path().filename().string();
+		if (entry.is_directory() && name.rfind(seedPrefix, 0) == 0 && entry.path() != m_directory)
+		{
+			std::filesystem::remove_all(entry.path(), error);
+			if (error)
+				std::cerr << "Failed to remove stale chunk cache " << entry.path().string() << std::endl;
+		}
+	}
+}
+
+bool ChunkDiskCache::load(glm::ivec3 chunkCoords, std::span<Id::VoxelState> blocks)
+{
+	if (!m_enabled)
+		return false;
+
+	std::ifstream file(getEntryPath(chunkCoords), std::ios::binary);
+	if (!file)
+	{
+		++m_misses;
+		return false;
+	}
+
+	Header header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	bool valid = file && header.magic == s_magic && header.version == s_version &&
+		header.seed == m_seed && header.parametersHash == m_parametersHash &&
+		header.coords[0] == chunkCoords.x && header.coords[1] == chunkCoords.y &&
+		header.coords[2] == chunkCoords.z && header.voxelCount == blocks.size();
+	if (valid)
+	{
+		file.read(reinterpret_cast<char*>(blocks.data()), blocks.size_bytes());
+		valid = static_cast<size_t>(file.gcount()) == blocks.size_bytes();
+	}
+
+	if (!valid)
+	{
+		++m_rejected;
+		++m_misses;
+		return false;
+	}
+	++m_hits;
+	return true;
+}
+
+void ChunkDiskCache::store(glm::ivec3 chunkCoords, std::span<const Id::VoxelState> blocks)
+{
+	if (!m_enabled)
+		return;
+
+	Header header = {};
+	header.magic = s_magic;
+	header.version = s_version;
+	header.seed = m_seed;
+	header.parametersHash = m_parametersHash;
+	header.coords[0] = chunkCoords.x;
+	header.coords[1] = chunkCoords.y;
+	header.coords[2] = chunkCoords.z;
+	header.voxelCount = static_cast<uint32_t>(blocks.size());
+
+	//written under a temporary name and renamed, a crash never leaves a truncated entry behind
+	auto path = getEntryPath(chunkCoords);
+	std::stringstream temporaryName;
+	temporaryName << path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+	auto temporaryPath = path.parent_path() / temporaryName.str();
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size_bytes());
+		if (!file)
+		{
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+		std::filesystem::remove(temporaryPath, error);
+	else ++m_stores;
+}
+
+ChunkDiskCache::Stats ChunkDiskCache::getStats() const
+{
+	Stats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.stores = m_stores;
+	stats.rejected = m_rejected;
+	return stats;
+}
+
+std::filesystem::path ChunkDiskCache::getEntryPath(glm::ivec3 chunkCoords) const
+{
+	char name[64];
+	std::snprintf(name, sizeof(name), "%d_%d_%d.chunk", chunkCoords.x, chunkCoords.y, chunkCoords.z);
+	return m_directory / name;
+}
+
+std::string ChunkDiskCache::getKeyName(SeedType seed, uint64_t parametersHash)
+{
+	char name[64];
+	std::snprintf(name, sizeof(name), "%016llx_%016llx",
+		static_cast<unsigned long long>(seed), static_cast<unsigned long long>(parametersHash));
+	return name;
+}
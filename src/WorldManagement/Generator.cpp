@@ -1,71 +1,229 @@
 #include "WorldManagement/Generator.h"
+#include "Utility/Hash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+	uint64_t mixHash(uint64_t value)
+	{
+		value += 0x9e3779b97f4a7c15ull;
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+
+	int32_t floorDiv(int32_t value, int32_t divisor)
+	{
+		return value / divisor - (value % divisor != 0 && (value < 0) != (divisor < 0));
+	}
+}
 
 Generator::Generator()
 {
 	m_seed = 0;
 }
 
+Generator::Structure Generator::makeBoulder(int32_t radius, float chance)
+{
+	Structure boulder;
+	boulder.chance = chance;
+	for (int32_t x = -radius; x <= radius; ++x)
+		for (int32_t y = -radius; y <= radius; ++y)
+			for (int32_t z = -radius; z <= radius; ++z)
+				if (x * x + y * y + z * z <= radius * radius)
+					boulder.voxels.push_back({ glm::ivec3(x, y + radius - 1, z), BlockTypes::Dirt, true });
+	return boulder;
+}
+
 void Generator::set(SeedType seed)
 { 
 	m_seed = seed; 
-	m_perlinNoise2d.setSeed(m_seed);
-	m_perlinNoise3d1.setSeed(m_seed);
-	m_perlinNoise3d2.setSeed(m_seed ^ std::numeric_limits<SeedType>::max());
+	m_terrain.setSeed(m_seed);
 	m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Air)] = 0;
 	m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Dirt)] = 1;
 }
 
-bool Generator::shouldBeCave(int32_t x, int32_t y, int32_t z)
+void Generator::setTerrain(NoiseProgram terrain)
+{
+	m_terrain = std::move(terrain);
+	m_terrain.setSeed(m_seed);
+}
+
+void Generator::loadFromFile(std::string_view path)
 {
-	float caveDensity = (m_perlinNoise3d1.getFbm(x, y, z, 3, 0.04f) + 1) / 2;
-	caveDensity *= caveDensity;
-	// Create the worm effect by checking if noise is within a specific range
+	auto roots = Json::Value::fromFile(path);
+	if (roots.size() != 1 || !roots.front().isObject())
+		throw std::runtime_error("Generator file must contain exactly one object root");
+	const auto& root = roots.front().asObject();
+
+	setTerrain(NoiseGraph::compile(roots.front()));
 
-	// Check if the noise value is within our "worm" range
-	if (caveDensity >= 0.4f) return 0;
+	clearStructures();
+	auto structures = root.find("structures");
+	if (structures == root.end())
+		return;
+	if (!structures->second.isArray())
+		throw std::runtime_error("'structures' must be an array in generator file");
+	for (const auto& structure : structures->second.asArray())
+		addStructure(parseStructure(structure));
+}
 
-	caveDensity += pow((m_perlinNoise3d2.getFbm(x, y, z, 3, 0.04f) + 1) / 2, 2);
-	if (caveDensity >= 0.4f) return 0;
+Generator::Structure Generator::parseStructure(const Json::Value& value)
+{
+	if (!value.isObject())
+		throw std::runtime_error("Generator structure must be an object");
+	const auto& structure = value.asObject();
+	auto field = [&structure](const std::string& name) -> const Json::Value& {
+		auto it = structure.find(name);
+		if (it == structure.end())
+			throw std::runtime_error("Missing required '" + name + "' in generator structure");
+		return it->second;
+		};
+	auto number = [](const Json::Value& input, const std::string& name) -> double {
+		if (input.isInteger()) return static_cast<double>(input.asInteger());
+		else if (input.isNumber()) return input.asNumber();
+		throw std::runtime_error("'" + name + "' must be a number in generator structure");
+		};
 
-	return 1;
+	const auto& type = field("type");
+	if (!type.isString())
+		throw std::runtime_error("'type' must be a string in generator structure");
+	if (type.asString() == "Boulder")
+		return makeBoulder(static_cast<int32_t>(number(field("radius"), "radius")),
+			static_cast<float>(number(field("chance"), "chance")));
+	throw std::runtime_error("Unknown generator structure type '" + type.asString() + "'");
 }
 
 void Generator::setChunkData(WorldGrid& grid, size_t allocIndex)
 {
+	grid.beginGeneration(allocIndex);
+
+	auto& alloc = grid.getAllocatedChunks()[allocIndex];
+	glm::ivec3 chunkCoords = glm::ivec3(alloc.getField<1>().coord);
+	if (m_cache == nullptr || !m_cache->load(chunkCoords, alloc.getField<0>()))
+	{
+		generateTerrain(grid, allocIndex);
+		if (m_cache != nullptr)
+			m_cache->store(chunkCoords, alloc.getField<0>());
+	}
+
+	placeStructures(grid, allocIndex);
+	grid.finishGeneration(allocIndex);
+}
+
+uint64_t Generator::getTerrainHash() const
+{
+	Fnv1a hash;
+	hash.add(s_terrainVersion).add<uint64_t>(Constants::chunkSize);
+	hash.add(m_terrain.getHash());
+	for (auto id : m_relevantBlockIds)
+		hash.add(static_cast<Id::VoxelState::DataType>(id));
+	return hash.get();
+}
+
+void Generator::generateTerrain(WorldGrid& grid, size_t allocIndex)
+{
+	static_assert(Constants::chunkLayerSize == NoiseProgram::s_batchSize, "noise batches are evaluated one chunk layer at a time");
+
 	auto& alloc = grid.getAllocatedChunks()[allocIndex];
 	auto& chunk = alloc.getField<1>();
 	auto blocks = alloc.getField<0>();
 
+	if (m_terrain.empty())
+		throw std::runtime_error("Generator has no terrain program set");
+
 	glm::ivec3 coords000 = chunk.coordCorner;
-	size_t height = 0;
-	float amplitudeHight = 16.f;
-	//float density;
 
-	for (size_t x = 0; x < Constants::chunkWidth; x++)
-		for (size_t z = 0; z < Constants::chunkDepth; z++)
+	//scratch memory is kept per thread, chunks are generated concurrently
+	thread_local NoiseProgram::Workspace workspace;
+	m_terrain.prepare(workspace);
+
+	float xs[Constants::chunkLayerSize];
+	float ys[Constants::chunkLayerSize];
+	float zs[Constants::chunkLayerSize];
+
+	for (size_t z = 0; z < Constants::chunkDepth; z++)
+		for (size_t x = 0; x < Constants::chunkWidth; x++)
+		{
+			xs[z * Constants::chunkDepth + x] = static_cast<float>(x + coords000.x);
+			zs[z * Constants::chunkDepth + x] = static_cast<float>(z + coords000.z);
+		}
+
+	//column only terms such as the surface height are computed once per chunk
+	m_terrain.run(NoiseProgram::Section::Invariant, xs, ys, zs, Constants::chunkLayerSize, workspace);
+
+	for (size_t y = 0; y < Constants::chunkHeight; y++)
+	{
+		std::fill(std::begin(ys), std::end(ys), static_cast<float>(y + coords000.y));
+		m_terrain.run(NoiseProgram::Section::Varying, xs, ys, zs, Constants::chunkLayerSize, workspace);
+
+		const float* output = m_terrain.getOutput(workspace);
+		for (size_t i = 0; i < Constants::chunkLayerSize; i++)
+		{
+			auto type = static_cast<uint32_t>(std::clamp(std::lround(output[i]), 0l,
+				static_cast<long>(BlockTypes::Num) - 1));
+			blocks[y * Constants::chunkLayerSize + i] = m_relevantBlockIds[type];
+		}
+	}
+}
+
+void Generator::placeStructures(WorldGrid& grid, size_t allocIndex)
+{
+	if (m_structures.empty())
+		return;
+
+	auto& alloc = grid.getAllocatedChunks()[allocIndex];
+	auto& chunk = alloc.getField<1>();
+	auto blocks = alloc.getField<0>();
+	glm::ivec3 chunkCoords = glm::ivec3(chunk.coord);
+	auto air = m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Air)];
+
+	uint64_t chunkHash = mixHash(m_seed ^ mixHash(static_cast<uint32_t>(chunkCoords.x) |
+		(static_cast<uint64_t>(static_cast<uint32_t>(chunkCoords.z)) << 32)) ^ mixHash(static_cast<uint32_t>(chunkCoords.y)));
+
+	for (size_t attempt = 0; attempt < s_structureAttemptsPerChunk; ++attempt)
+	{
+		uint64_t hash = mixHash(chunkHash + attempt);
+		auto& structure = m_structures[hash % m_structures.size()];
+		if (static_cast<float>((hash >> 40) & 0xffff) / 65536.0f >= structure.chance)
+			continue;
+
+		size_t x = (hash >> 16) % Constants::chunkWidth;
+		size_t z = (hash >> 24) % Constants::chunkDepth;
+
+		//the ground must be inside this chunk with air above it, the top layer is skipped
+		//since the voxel above it belongs to a chunk that may not be generated yet
+		size_t y = Constants::chunkHeight - 1;
+		for (; y > 0; --y)
+			if (blocks[(y - 1) * Constants::chunkLayerSize + z * Constants::chunkWidth + x] != air &&
+				blocks[y * Constants::chunkLayerSize + z * Constants::chunkWidth + x] == air)
+				break;
+		if (y == 0)
+			continue;
+
+		glm::ivec3 anchor = glm::ivec3(chunk.coordCorner) + glm::ivec3(x, y, z);
+		for (const auto& voxel : structure.voxels)
 		{
-			height = m_groundLevel + amplitudeHight * m_perlinNoise2d.getFbm(x + coords000.x, 
-				z + coords000.z, 3, 0.02f);
-			size_t yEnd;
-
-			if (coords000.y + Constants::chunkHeight < height)
-				yEnd = Constants::chunkHeight;
-			else if (coords000.y < static_cast<int64_t>(height))
-				yEnd = height - coords000.y;
-			else yEnd = 0;
-
-			for (size_t y = 0; y < yEnd; y++)
-			{
-				if (shouldBeCave(x + coords000.x, y + coords000.y, z + coords000.z))
-					blocks[y * Constants::chunkLayerSize + z * Constants::chunkDepth + x] =
-					m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Air)];
-				else blocks[y * Constants::chunkLayerSize + z * Constants::chunkDepth + x] =
-					m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Dirt)];
-			}
-			for (size_t y = yEnd; y < Constants::chunkHeight; y++)
-				blocks[y * Constants::chunkLayerSize + z * Constants::chunkDepth + x] =
-				m_relevantBlockIds[static_cast<uint32_t>(BlockTypes::Air)];
+			glm::ivec3 position = anchor + voxel.offset;
+			glm::ivec3 targetChunk = {
+				floorDiv(position.x, static_cast<int32_t>(Constants::chunkWidth)),
+				floorDiv(position.y, static_cast<int32_t>(Constants::chunkHeight)),
+				floorDiv(position.z, static_cast<int32_t>(Constants::chunkDepth)) };
+			glm::ivec3 local = position - targetChunk * glm::ivec3(Constants::chunkDimensions);
+
+			WorldGrid::VoxelEdit edit;
+			edit.index = static_cast<uint16_t>(local.x + local.z * Constants::chunkWidth + local.y * Constants::chunkLayerSize);
+			edit.state = m_relevantBlockIds[static_cast<uint32_t>(voxel.type)];
+			edit.replaces = voxel.onlyIntoAir ? air : WorldGrid::anyState;
+
+			if (targetChunk == chunkCoords)
+				WorldGrid::applyEdit(blocks, edit);
+			else grid.pushEdit(targetChunk, edit);
 		}
+	}
 }
 
 void Generator::fillChunk(WorldGrid& grid, size_t allocIndex, BlockTypes type) {
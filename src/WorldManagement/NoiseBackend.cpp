@@ -0,0 +1,176 @@
+#include "WorldManagement/NoiseBackend.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	const std::array<std::string_view, enumCast(NoiseBackend::Type::Num)> s_typeNames = {
+		"Perlin",
+		"Value",
+	};
+
+	inline int32_t fastFloor(float value)
+	{
+		int32_t truncated = static_cast<int32_t>(value);
+		return truncated - static_cast<int32_t>(value < static_cast<float>(truncated));
+	}
+
+	inline float fade(float t)
+	{
+		return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+	}
+
+	inline float lerp(float a, float b, float t)
+	{
+		return a + (b - a) * t;
+	}
+
+	inline uint32_t hashLattice(uint32_t seed, int32_t x, int32_t y, int32_t z)
+	{
+		uint32_t hash = seed ^ (static_cast<uint32_t>(x) * 0x27d4eb2du)
+			^ (static_cast<uint32_t>(y) * 0x165667b1u) ^ (static_cast<uint32_t>(z) * 0x9e3779b1u);
+		hash = (hash ^ (hash >> 15)) * 0x2c1b3c6du;
+		hash = (hash ^ (hash >> 12)) * 0x297a2d39u;
+		return hash ^ (hash >> 15);
+	}
+
+	//maps the upper 24 bits of a hash to [-1, 1]
+	inline float hashToUnit(uint32_t hash)
+	{
+		return static_cast<float>(hash >> 8) * (2.0f / 16777215.0f) - 1.0f;
+	}
+
+	inline uint32_t nextOctaveSeed(uint32_t seed)
+	{
+		return seed * 0x9e3779b9u + 0x7f4a7c15u;
+	}
+}
+
+std::unique_ptr<NoiseBackend> NoiseBackend::create(Type type)
+{
+	switch (type)
+	{
+	case Type::Perlin: return std::make_unique<PerlinNoiseBackend>();
+	case Type::Value: return std::make_unique<ValueNoiseBackend>();
+	default: throw std::runtime_error("Invalid noise backend type");
+	}
+}
+
+std::string_view NoiseBackend::typeToString(Type type)
+{
+	return s_typeNames[enumCast(type)];
+}
+
+NoiseBackend::Type NoiseBackend::typeFromString(std::string_view name)
+{
+	auto it = std::find(s_typeNames.begin(), s_typeNames.end(), name);
+	if (it == s_typeNames.end())
+		throw std::runtime_error("Unknown noise backend '" + std::string(name) + "'");
+	return static_cast<Type>(it - s_typeNames.begin());
+}
+
+void PerlinNoiseBackend::setSeed(SeedType seed)
+{
+	m_noise2d.setSeed(seed);
+	m_noise3d.setSeed(seed);
+}
+
+void PerlinNoiseBackend::fbm2d(const float* x, const float* z, float* out, size_t count,
+	uint32_t octaves, float frequency)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = m_noise2d.getFbm(x[i], z[i], octaves, frequency);
+}
+
+void PerlinNoiseBackend::fbm3d(const float* x, const float* y, const float* z, float* out, size_t count,
+	uint32_t octaves, float frequency)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = m_noise3d.getFbm(x[i], y[i], z[i], octaves, frequency);
+}
+
+void ValueNoiseBackend::fbm2d(const float* x, const float* z, float* out, size_t count,
+	uint32_t octaves, float frequency)
+{
+	std::fill(out, out + count, 0.0f);
+
+	float amplitude = 1.0f;
+	float amplitudeSum = 0.0f;
+	uint32_t seed = m_seed;
+	for (uint32_t octave = 0; octave < octaves; ++octave)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			float px = x[i] * frequency;
+			float pz = z[i] * frequency;
+			int32_t ix = fastFloor(px);
+			int32_t iz = fastFloor(pz);
+			float u = fade(px - static_cast<float>(ix));
+			float v = fade(pz - static_cast<float>(iz));
+
+			float v00 = hashToUnit(hashLattice(seed, ix, 0, iz));
+			float v10 = hashToUnit(hashLattice(seed, ix + 1, 0, iz));
+			float v01 = hashToUnit(hashLattice(seed, ix, 0, iz + 1));
+			float v11 = hashToUnit(hashLattice(seed, ix + 1, 0, iz + 1));
+
+			out[i] += amplitude * lerp(lerp(v00, v10, u), lerp(v01, v11, u), v);
+		}
+		amplitudeSum += amplitude;
+		amplitude *= 0.5f;
+		frequency *= 2.0f;
+		seed = nextOctaveSeed(seed);
+	}
+
+	float normalization = 1.0f / amplitudeSum;
+	for (size_t i = 0; i < count; ++i)
+		out[i] *= normalization;
+}
+
+void ValueNoiseBackend::fbm3d(const float* x, const float* y, const float* z, float* out, size_t count,
+	uint32_t octaves, float frequency)
+{
+	std::fill(out, out + count, 0.0f);
+
+	float amplitude = 1.0f;
+	float amplitudeSum = 0.0f;
+	uint32_t seed = m_seed;
+	for (uint32_t octave = 0; octave < octaves; ++octave)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			float px = x[i] * frequency;
+			float py = y[i] * frequency;
+			float pz = z[i] * frequency;
+			int32_t ix = fastFloor(px);
+			int32_t iy = fastFloor(py);
+			int32_t iz = fastFloor(pz);
+			float u = fade(px - static_cast<float>(ix));
+			float v = fade(py - static_cast<float>(iy));
+			float w = fade(pz - static_cast<float>(iz));
+
+			float v000 = hashToUnit(hashLattice(seed, ix, iy, iz));
+			float v100 = hashToUnit(hashLattice(seed, ix + 1, iy, iz));
+			float v010 = hashToUnit(hashLattice(seed, ix, iy + 1, iz));
+			float v110 = hashToUnit(hashLattice(seed, ix + 1, iy + 1, iz));
+			float v001 = hashToUnit(hashLattice(seed, ix, iy, iz + 1));
+			float v101 = hashToUnit(hashLattice(seed, ix + 1, iy, iz + 1));
+			float v011 = hashToUnit(hashLattice(seed, ix, iy + 1, iz + 1));
+			float v111 = hashToUnit(hashLattice(seed, ix + 1, iy + 1, iz + 1));
+
+			float front = lerp(lerp(v000, v100, u), lerp(v010, v110, u), v);
+			float back = lerp(lerp(v001, v101, u), lerp(v011, v111, u), v);
+			out[i] += amplitude * lerp(front, back, w);
+		}
+		amplitudeSum += amplitude;
+		amplitude *= 0.5f;
+		frequency *= 2.0f;
+		seed = nextOctaveSeed(seed);
+	}
+
+	float normalization = 1.0f / amplitudeSum;
+	for (size_t i = 0; i < count; ++i)
+		out[i] *= normalization;
+}
@@ -0,0 +1,464 @@
+#include "WorldManagement/NoiseGraph.h"
+#include "Utility/Hash.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	struct OpCodeName
+	{
+		std::string_view name;
+		NoiseProgram::OpCode op;
+	};
+
+	const std::array<OpCodeName, 12> s_opCodeNames = { {
+		{ "Constant",	NoiseProgram::OpCode::Constant },
+		{ "Noise2d",	NoiseProgram::OpCode::Noise2d },
+		{ "Noise3d",	NoiseProgram::OpCode::Noise3d },
+		{ "Fbm2d",		NoiseProgram::OpCode::Fbm2d },
+		{ "Fbm3d",		NoiseProgram::OpCode::Fbm3d },
+		{ "Add",		NoiseProgram::OpCode::Add },
+		{ "Sub",		NoiseProgram::OpCode::Sub },
+		{ "Mul",		NoiseProgram::OpCode::Mul },
+		{ "Min",		NoiseProgram::OpCode::Min },
+		{ "Max",		NoiseProgram::OpCode::Max },
+		{ "Clamp",		NoiseProgram::OpCode::Clamp },
+		{ "Threshold",	NoiseProgram::OpCode::Threshold },
+	} };
+
+	const uint16_t s_noRegister = std::numeric_limits<uint16_t>::max();
+
+	double readNumber(const Json::Value& value, std::string_view what) {
+		if (value.isInteger()) return static_cast<double>(value.asInteger());
+		else if (value.isNumber()) return value.asNumber();
+		throw std::runtime_error("'" + std::string(what) + "' must be a number in noise graph");
+	}
+
+	const Json::Value& requireField(const Json::Value::Object& node, const std::string& field) {
+		auto it = node.find(field);
+		if (it == node.end())
+			throw std::runtime_error("Missing required '" + field + "' in noise graph node");
+		return it->second;
+	}
+}
+
+NoiseProgram::NoiseProgram(const NoiseProgram& other)
+{
+	*this = other;
+}
+
+NoiseProgram& NoiseProgram::operator=(const NoiseProgram& other)
+{
+	if (this == &other)
+		return *this;
+
+	m_instructions = other.m_instructions;
+	std::copy(std::begin(other.m_sectionStarts), std::end(other.m_sectionStarts), std::begin(m_sectionStarts));
+	m_noiseSources = other.m_noiseSources;
+	m_noise.clear();
+	for (const auto& noise : other.m_noise)
+		m_noise.push_back(noise->clone());
+	m_backendType = other.m_backendType;
+	m_seed = other.m_seed;
+	m_registerCount = other.m_registerCount;
+	m_output = other.m_output;
+	return *this;
+}
+
+void NoiseProgram::setSeed(SeedType seed)
+{
+	m_seed = seed;
+	for (size_t i = 0; i < m_noiseSources.size(); ++i)
+		m_noise[i]->setSeed(seed ^ m_noiseSources[i].salt);
+}
+
+void NoiseProgram::setBackend(NoiseBackend::Type type)
+{
+	m_backendType = type;
+	m_noise.clear();
+	for (size_t i = 0; i < m_noiseSources.size(); ++i)
+		m_noise.push_back(NoiseBackend::create(type));
+	setSeed(m_seed);
+}
+
+uint64_t NoiseProgram::getHash() const
+{
+	Fnv1a hash;
+	hash.add(enumCast(m_backendType));
+	for (const auto& instruction : m_instructions)
+	{
+		hash.add(enumCast(instruction.op)).add(instruction.destination);
+		hash.add(instruction.sources[0]).add(instruction.sources[1]).add(instruction.sources[2]);
+		hash.add(instruction.noise).add(instruction.octaves).add(instruction.value);
+	}
+	for (auto start : m_sectionStarts)
+		hash.add<uint64_t>(start);
+	for (const auto& source : m_noiseSources)
+		hash.add(source.salt).add(source.is3d);
+	hash.add(m_output);
+	return hash.get();
+}
+
+void NoiseProgram::run(Section section, const float* x, const float* y, const float* z,
+	size_t count, Workspace& workspace)
+{
+	assert(count <= s_batchSize);
+	for (size_t i = m_sectionStarts[enumCast(section)]; i < m_sectionStarts[enumCast(section) + 1]; ++i)
+	{
+		const auto& instruction = m_instructions[i];
+		float* out = workspace.getRegister(instruction.destination);
+		const float* a = instruction.sources[0] != s_noRegister ? workspace.getRegister(instruction.sources[0]) : nullptr;
+		const float* b = instruction.sources[1] != s_noRegister ? workspace.getRegister(instruction.sources[1]) : nullptr;
+		const float* c = instruction.sources[2] != s_noRegister ? workspace.getRegister(instruction.sources[2]) : nullptr;
+
+		switch (instruction.op)
+		{
+		case OpCode::Constant:
+			std::fill(out, out + count, instruction.value);
+			break;
+		case OpCode::CoordinateX:
+			std::memcpy(out, x, count * sizeof(float));
+			break;
+		case OpCode::CoordinateY:
+			std::memcpy(out, y, count * sizeof(float));
+			break;
+		case OpCode::CoordinateZ:
+			std::memcpy(out, z, count * sizeof(float));
+			break;
+		case OpCode::Noise2d:
+		case OpCode::Fbm2d:
+			m_noise[instruction.noise]->fbm2d(x, z, out, count, instruction.octaves, instruction.value);
+			break;
+		case OpCode::Noise3d:
+		case OpCode::Fbm3d:
+			m_noise[instruction.noise]->fbm3d(x, y, z, out, count, instruction.octaves, instruction.value);
+			break;
+		case OpCode::Add:
+			binary(a, b, out, count, [](float l, float r) { return l + r; });
+			break;
+		case OpCode::Sub:
+			binary(a, b, out, count, [](float l, float r) { return l - r; });
+			break;
+		case OpCode::Mul:
+			binary(a, b, out, count, [](float l, float r) { return l * r; });
+			break;
+		case OpCode::Min:
+			binary(a, b, out, count, [](float l, float r) { return l < r ? l : r; });
+			break;
+		case OpCode::Max:
+			binary(a, b, out, count, [](float l, float r) { return l > r ? l : r; });
+			break;
+		case OpCode::Clamp:
+			for (size_t j = 0; j < count; ++j)
+				out[j] = a[j] < b[j] ? b[j] : (a[j] > c[j] ? c[j] : a[j]);
+			break;
+		case OpCode::Threshold:
+			for (size_t j = 0; j < count; ++j)
+				out[j] = a[j] >= instruction.value ? 1.0f : 0.0f;
+			break;
+		case OpCode::Select:
+			for (size_t j = 0; j < count; ++j)
+				out[j] = a[j] >= 0.5f ? b[j] : c[j];
+			break;
+		default:
+			throw std::runtime_error("Invalid noise program opcode");
+		}
+	}
+}
+
+NoiseProgram NoiseGraph::compileFromFile(std::string_view path)
+{
+	auto roots = Json::Value::fromFile(path);
+	if (roots.size() != 1)
+		throw std::runtime_error("Noise graph file must contain exactly one root");
+	return compile(roots.front());
+}
+
+NoiseProgram NoiseGraph::compile(const Json::Value& graph)
+{
+	if (!graph.isObject())
+		throw std::runtime_error("Noise graph root must be an object");
+	const auto& root = graph.asObject();
+
+	Builder builder;
+	auto nodes = root.find("nodes");
+	if (nodes != root.end())
+	{
+		if (!nodes->second.isObject())
+			throw std::runtime_error("'nodes' must be an object in noise graph");
+		for (const auto& [name, definition] : nodes->second.asObject())
+			builder.definitions.insert({ name, &definition });
+	}
+
+	//the backend can also be switched after compilation, this only picks the default
+	auto backend = NoiseBackend::Type::Perlin;
+	auto backendIt = root.find("backend");
+	if (backendIt != root.end())
+	{
+		if (!backendIt->second.isString())
+			throw std::runtime_error("'backend' must be a string in noise graph");
+		backend = NoiseBackend::typeFromString(backendIt->second.asString());
+	}
+
+	size_t output = parseInput(builder, requireField(root, "output"));
+	return emit(builder, output, backend);
+}
+
+size_t NoiseGraph::parseInput(Builder& builder, const Json::Value& input)
+{
+	if (input.isString())
+		return parseNamed(builder, input.asString());
+	else if (input.isObject())
+		return parseNode(builder, input);
+	return addConstant(builder, static_cast<float>(readNumber(input, "input")));
+}
+
+size_t NoiseGraph::parseNamed(Builder& builder, const std::string& name)
+{
+	auto named = builder.namedNodes.find(name);
+	if (named != builder.namedNodes.end())
+		return named->second;
+
+	auto definition = builder.definitions.find(name);
+	if (definition == builder.definitions.end())
+		throw std::runtime_error("Unknown node '" + name + "' referenced in noise graph");
+	if (builder.visiting[name])
+		throw std::runtime_error("Cycle detected in noise graph at node '" + name + "'");
+
+	builder.visiting[name] = true;
+	size_t index = parseNode(builder, *definition->second);
+	builder.visiting[name] = false;
+
+	builder.namedNodes.insert({ name, index });
+	return index;
+}
+
+size_t NoiseGraph::parseNode(Builder& builder, const Json::Value& nodeValue)
+{
+	if (!nodeValue.isObject())
+		throw std::runtime_error("Noise graph node must be an object");
+	const auto& node = nodeValue.asObject();
+
+	const auto& typeValue = requireField(node, "type");
+	if (!typeValue.isString())
+		throw std::runtime_error("'type' must be a string in noise graph node");
+	const auto& type = typeValue.asString();
+
+	if (type == "Coordinate")
+	{
+		const auto& axis = requireField(node, "axis");
+		if (!axis.isString())
+			throw std::runtime_error("'axis' must be a string in noise graph node");
+		Node result;
+		if (axis.asString() == "X") result.op = NoiseProgram::OpCode::CoordinateX;
+		else if (axis.asString() == "Y") result.op = NoiseProgram::OpCode::CoordinateY;
+		else if (axis.asString() == "Z") result.op = NoiseProgram::OpCode::CoordinateZ;
+		else throw std::runtime_error("'axis' must be one of X, Y or Z in noise graph node");
+		result.varying = result.op == NoiseProgram::OpCode::CoordinateY;
+		builder.nodes.push_back(result);
+		return builder.nodes.size() - 1;
+	}
+
+	if (type == "Select")
+	{
+		Node result;
+		result.op = NoiseProgram::OpCode::Select;
+		result.inputs.push_back(parseInput(builder, requireField(node, "condition")));
+		result.inputs.push_back(parseInput(builder, requireField(node, "true")));
+		result.inputs.push_back(parseInput(builder, requireField(node, "false")));
+		for (auto input : result.inputs)
+			result.varying |= builder.nodes[input].varying;
+		builder.nodes.push_back(result);
+		return builder.nodes.size() - 1;
+	}
+
+	auto opName = std::find_if(s_opCodeNames.begin(), s_opCodeNames.end(),
+		[&type](const OpCodeName& entry) { return entry.name == type; });
+	if (opName == s_opCodeNames.end())
+		throw std::runtime_error("Unknown noise graph node type '" + type + "'");
+
+	Node result;
+	result.op = opName->op;
+
+	switch (result.op)
+	{
+	case NoiseProgram::OpCode::Constant:
+		return addConstant(builder, static_cast<float>(readNumber(requireField(node, "value"), "value")));
+	case NoiseProgram::OpCode::Noise2d:
+	case NoiseProgram::OpCode::Noise3d:
+	case NoiseProgram::OpCode::Fbm2d:
+	case NoiseProgram::OpCode::Fbm3d:
+	{
+		auto seed = node.find("seed");
+		if (seed != node.end())
+		{
+			if (!seed->second.isInteger())
+				throw std::runtime_error("'seed' must be an integer in noise graph node");
+			result.salt = static_cast<uint64_t>(seed->second.asInteger());
+		}
+		result.value = static_cast<float>(readNumber(requireField(node, "frequency"), "frequency"));
+		if (result.op == NoiseProgram::OpCode::Fbm2d || result.op == NoiseProgram::OpCode::Fbm3d)
+		{
+			auto octaves = readNumber(requireField(node, "octaves"), "octaves");
+			if (octaves < 1 || octaves > 16)
+				throw std::runtime_error("'octaves' must be between 1 and 16 in noise graph node");
+			result.octaves = static_cast<uint16_t>(octaves);
+		}
+		result.varying = result.op == NoiseProgram::OpCode::Noise3d || result.op == NoiseProgram::OpCode::Fbm3d;
+		builder.nodes.push_back(result);
+		return builder.nodes.size() - 1;
+	}
+	case NoiseProgram::OpCode::Add:
+	case NoiseProgram::OpCode::Sub:
+	case NoiseProgram::OpCode::Mul:
+	case NoiseProgram::OpCode::Min:
+	case NoiseProgram::OpCode::Max:
+	{
+		const auto& inputs = requireField(node, "inputs");
+		if (!inputs.isArray() || inputs.asArray().size() < 2)
+			throw std::runtime_error("'inputs' must be an array of at least two inputs in noise graph node");
+
+		//variadic operations are folded into a chain of binary instructions
+		size_t accumulator = parseInput(builder, inputs.asArray()[0]);
+		for (size_t i = 1; i < inputs.asArray().size(); ++i)
+		{
+			size_t operand = parseInput(builder, inputs.asArray()[i]);
+			Node link;
+			link.op = result.op;
+			link.inputs = { accumulator, operand };
+			link.varying = builder.nodes[accumulator].varying || builder.nodes[operand].varying;
+			builder.nodes.push_back(link);
+			accumulator = builder.nodes.size() - 1;
+		}
+		return accumulator;
+	}
+	case NoiseProgram::OpCode::Clamp:
+		result.inputs.push_back(parseInput(builder, requireField(node, "input")));
+		result.inputs.push_back(parseInput(builder, requireField(node, "min")));
+		result.inputs.push_back(parseInput(builder, requireField(node, "max")));
+		break;
+	case NoiseProgram::OpCode::Threshold:
+		result.inputs.push_back(parseInput(builder, requireField(node, "input")));
+		result.value = static_cast<float>(readNumber(requireField(node, "value"), "value"));
+		break;
+	default:
+		throw std::runtime_error("Unsupported noise graph node type '" + type + "'");
+	}
+
+	for (auto input : result.inputs)
+		result.varying |= builder.nodes[input].varying;
+	builder.nodes.push_back(result);
+	return builder.nodes.size() - 1;
+}
+
+size_t NoiseGraph::addConstant(Builder& builder, float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	auto it = builder.constants.find(bits);
+	if (it != builder.constants.end())
+		return it->second;
+
+	Node result;
+	result.op = NoiseProgram::OpCode::Constant;
+	result.value = value;
+	builder.nodes.push_back(result);
+	builder.constants.insert({ bits, builder.nodes.size() - 1 });
+	return builder.nodes.size() - 1;
+}
+
+NoiseProgram NoiseGraph::emit(const Builder& builder, size_t output, NoiseBackend::Type backend)
+{
+	NoiseProgram program;
+	const auto& nodes = builder.nodes;
+
+	//nodes are created after their inputs, so index order is already topological,
+	//only nodes reachable from the output are emitted
+	std::vector<bool> reachable(nodes.size(), false);
+	reachable[output] = true;
+	for (size_t i = nodes.size(); i-- > 0;)
+		if (reachable[i])
+			for (auto input : nodes[i].inputs)
+				reachable[input] = true;
+
+	//invariant nodes never depend on varying ones, so moving them to the front keeps the order valid
+	std::vector<size_t> order;
+	for (size_t section = 0; section < enumCast(NoiseProgram::Section::Num); ++section)
+	{
+		program.m_sectionStarts[section] = order.size();
+		for (size_t i = 0; i < nodes.size(); ++i)
+			if (reachable[i] && nodes[i].varying == (section == enumCast(NoiseProgram::Section::Varying)))
+				order.push_back(i);
+	}
+	program.m_sectionStarts[enumCast(NoiseProgram::Section::Num)] = order.size();
+
+	//an invariant value read by the varying section must survive every layer, so it is never freed
+	const size_t pinned = std::numeric_limits<size_t>::max();
+	std::vector<size_t> lastUse(nodes.size(), 0);
+	for (size_t position = 0; position < order.size(); ++position)
+		for (auto input : nodes[order[position]].inputs)
+			lastUse[input] = (!nodes[input].varying && nodes[order[position]].varying) ? pinned :
+				(lastUse[input] == pinned ? pinned : position);
+	lastUse[output] = pinned;
+
+	std::vector<uint16_t> registers(nodes.size(), s_noRegister);
+	std::vector<uint16_t> freeRegisters;
+	std::vector<uint16_t> noiseIndices(nodes.size(), 0);
+
+	for (size_t position = 0; position < order.size(); ++position)
+	{
+		const auto& node = nodes[order[position]];
+
+		NoiseProgram::Instruction instruction = {};
+		instruction.op = node.op;
+		instruction.value = node.value;
+		instruction.octaves = node.octaves;
+		instruction.sources[0] = instruction.sources[1] = instruction.sources[2] = s_noRegister;
+		for (size_t i = 0; i < node.inputs.size(); ++i)
+			instruction.sources[i] = registers[node.inputs[i]];
+
+		if (node.op == NoiseProgram::OpCode::Noise2d || node.op == NoiseProgram::OpCode::Fbm2d ||
+			node.op == NoiseProgram::OpCode::Noise3d || node.op == NoiseProgram::OpCode::Fbm3d)
+		{
+			bool is3d = node.op == NoiseProgram::OpCode::Noise3d || node.op == NoiseProgram::OpCode::Fbm3d;
+			size_t sourceIndex = 0;
+			for (; sourceIndex < program.m_noiseSources.size(); ++sourceIndex)
+			{
+				const auto& source = program.m_noiseSources[sourceIndex];
+				if (source.is3d == is3d && source.salt == node.salt)
+					break;
+			}
+			if (sourceIndex == program.m_noiseSources.size())
+				program.m_noiseSources.push_back({ node.salt, is3d });
+			instruction.noise = static_cast<uint16_t>(sourceIndex);
+		}
+
+		//inputs that die here hand their registers over, every opcode is elementwise so in place is safe
+		for (auto input : node.inputs)
+			if (lastUse[input] == position && registers[input] != s_noRegister &&
+				std::find(freeRegisters.begin(), freeRegisters.end(), registers[input]) == freeRegisters.end())
+				freeRegisters.push_back(registers[input]);
+
+		uint16_t destination;
+		if (freeRegisters.empty())
+			destination = program.m_registerCount++;
+		else
+		{
+			auto lowest = std::min_element(freeRegisters.begin(), freeRegisters.end());
+			destination = *lowest;
+			freeRegisters.erase(lowest);
+		}
+		registers[order[position]] = destination;
+		instruction.destination = destination;
+
+		program.m_instructions.push_back(instruction);
+	}
+
+	program.m_output = registers[output];
+	program.setBackend(backend);
+	return program;
+}
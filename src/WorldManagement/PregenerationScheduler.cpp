@@ -0,0 +1,299 @@
+#include "WorldManagement/PregenerationScheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	const size_t s_noAllocation = std::numeric_limits<size_t>::max();
+
+	//structures spill edits into every surrounding chunk, so a chunk is final only once all 26 are generated
+	const std::array<glm::ivec3, 26> s_neighbourOffsets = [] {
+		std::array<glm::ivec3, 26> offsets;
+		size_t i = 0;
+		for (int32_t x = -1; x <= 1; ++x)
+			for (int32_t y = -1; y <= 1; ++y)
+				for (int32_t z = -1; z <= 1; ++z)
+					if (x != 0 || y != 0 || z != 0)
+						offsets[i++] = glm::ivec3(x, y, z);
+		return offsets;
+		}();
+}
+
+void PregenerationScheduler::init(WorldGrid& grid, Generator& generator, Renderer& renderer,
+	const ResourceCache& resources, MT::ThreadPool& pool, const Settings& settings)
+{
+	m_grid = &grid;
+	m_generator = &generator;
+	m_renderer = &renderer;
+	m_resources = &resources;
+	m_pool = &pool;
+	m_settings = settings;
+
+	size_t chunkCount = grid.getAllocatedChunks().size();
+	m_states = std::make_unique<std::atomic<ChunkState>[]>(chunkCount);
+	m_priorities = std::make_unique<std::atomic<float>[]>(chunkCount);
+	for (size_t i = 0; i < chunkCount; ++i)
+	{
+		m_states[i] = ChunkState::Empty;
+		m_priorities[i] = s_notRequested;
+	}
+	//the mesh scheduler would otherwise park the far end of the cone before it is meshed
+	MeshScheduler::Settings meshSettings;
+	meshSettings.cancelDistance = std::max(meshSettings.cancelDistance, settings.viewRadius + settings.maxLookahead + 1.0f);
+	renderer.setMeshSchedulerSettings(meshSettings);
+
+	m_seen.assign(chunkCount, false);
+	m_inCone.assign(chunkCount, false);
+	m_coneChunks.clear();
+	m_hasCameraChunk = false;
+}
+
+void PregenerationScheduler::update(glm::vec3 cameraPosition, glm::vec3 velocity, float deltaTime)
+{
+	//smoothing keeps the cone from jittering when keys are tapped
+	float blend = m_settings.velocitySmoothingTime > 0.0f ?
+		1.0f - std::exp(-deltaTime / m_settings.velocitySmoothingTime) : 1.0f;
+	m_velocity += (velocity - m_velocity) * blend;
+
+	glm::ivec3 cameraChunk = glm::ivec3(glm::floor(cameraPosition / glm::vec3(Constants::chunkDimensions)));
+	bool moved = !m_hasCameraChunk || cameraChunk != m_cameraChunk;
+	m_cameraChunk = cameraChunk;
+	m_hasCameraChunk = true;
+
+	if (moved)
+		requestVisible();
+
+	glm::vec3 direction = glm::length(m_velocity) > std::numeric_limits<float>::epsilon() ?
+		glm::normalize(m_velocity) : glm::vec3(0.0f);
+	if (moved || glm::dot(direction, m_coneDirection) < std::cos(m_settings.coneHalfAngle * 0.25f))
+	{
+		m_coneDirection = direction;
+		requestCone();
+	}
+}
+
+PregenerationScheduler::Stats PregenerationScheduler::getStats() const
+{
+	Stats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.generated = m_generatedCount;
+	stats.meshed = m_meshedCount;
+	stats.pregenerated = m_pregeneratedCount;
+	stats.pending = m_queue.size();
+	return stats;
+}
+
+void PregenerationScheduler::requestVisible()
+{
+	int32_t radius = static_cast<int32_t>(std::ceil(m_settings.viewRadius));
+	for (int32_t x = -radius; x <= radius; ++x)
+		for (int32_t y = -radius; y <= radius; ++y)
+			for (int32_t z = -radius; z <= radius; ++z)
+			{
+				float distance = glm::length(glm::vec3(x, y, z));
+				if (distance > m_settings.viewRadius)
+					continue;
+				size_t allocIndex = findChunk(m_cameraChunk + glm::ivec3(x, y, z));
+				if (allocIndex == s_noAllocation)
+					continue;
+
+				if (!m_seen[allocIndex])
+				{
+					m_seen[allocIndex] = true;
+					if (m_states[allocIndex] == ChunkState::Meshed) ++m_hits;
+					else ++m_misses;
+				}
+				request(allocIndex, distance);
+			}
+}
+
+void PregenerationScheduler::requestCone()
+{
+	float speed = glm::length(m_velocity) / static_cast<float>(Constants::chunkWidth);
+	float length = std::min(speed * m_settings.lookaheadTime, m_settings.maxLookahead);
+
+	for (auto allocIndex : m_coneChunks)
+		m_inCone[allocIndex] = false;
+
+	std::vector<size_t> coneChunks;
+	if (length >= 1.0f)
+	{
+		//the cone starts at the camera and extends past the view radius by the extrapolated distance
+		float coneEnd = m_settings.viewRadius + length;
+		float tangent = std::tan(m_settings.coneHalfAngle);
+		float cosine = std::cos(m_settings.coneHalfAngle);
+		glm::vec3 origin = glm::vec3(m_cameraChunk);
+
+		for (float step = 0.0f; step <= coneEnd; step += 1.0f)
+		{
+			glm::ivec3 center = glm::ivec3(glm::round(origin + m_coneDirection * step));
+			int32_t radius = static_cast<int32_t>(std::ceil(step * tangent));
+			for (int32_t x = -radius; x <= radius; ++x)
+				for (int32_t y = -radius; y <= radius; ++y)
+					for (int32_t z = -radius; z <= radius; ++z)
+					{
+						glm::ivec3 coords = center + glm::ivec3(x, y, z);
+						glm::vec3 offset = glm::vec3(coords - m_cameraChunk);
+						float distance = glm::length(offset);
+						if (distance <= m_settings.viewRadius || distance > coneEnd ||
+							glm::dot(offset, m_coneDirection) < distance * cosine)
+							continue;
+
+						size_t allocIndex = findChunk(coords);
+						if (allocIndex == s_noAllocation || m_inCone[allocIndex])
+							continue;
+						m_inCone[allocIndex] = true;
+						coneChunks.push_back(allocIndex);
+						request(allocIndex, s_backgroundPriority + distance);
+					}
+		}
+	}
+
+	//chunks that left the cone are cancelled unless something more urgent asked for them since
+	for (auto allocIndex : m_coneChunks)
+	{
+		if (m_inCone[allocIndex] || m_priorities[allocIndex] < s_backgroundPriority)
+			continue;
+		m_priorities[allocIndex] = s_notRequested;
+		m_queue.remove(allocIndex);
+	}
+	m_coneChunks = std::move(coneChunks);
+}
+
+void PregenerationScheduler::request(size_t allocIndex, float priority)
+{
+	auto state = m_states[allocIndex].load();
+	if (state == ChunkState::Meshing || state == ChunkState::Meshed)
+		return;
+
+	float current = m_priorities[allocIndex];
+	while (priority < current && !m_priorities[allocIndex].compare_exchange_weak(current, priority));
+
+	if (state == ChunkState::Empty && m_queue.push(allocIndex, priority))
+		pushTicket();
+	else if (state == ChunkState::Generated && isMeshable(allocIndex))
+		requestMesh(allocIndex);
+
+	//meshing needs the neighbours finished, so they are generated at the same urgency
+	auto& chunk = m_grid->getAllocatedChunks()[allocIndex].getField<1>();
+	for (const auto& offset : s_neighbourOffsets)
+	{
+		size_t neighbour = findChunk(glm::ivec3(chunk.coord) + offset);
+		if (neighbour != s_noAllocation && m_states[neighbour] == ChunkState::Empty &&
+			m_queue.push(neighbour, priority))
+			pushTicket();
+	}
+}
+
+void PregenerationScheduler::pushTicket()
+{
+	//tickets do not carry a job, each one pops the most urgent job when a worker picks it up,
+	//this lets nearby work overtake background work that was queued earlier
+	m_pool->pushTask([this](size_t) {
+		runTicket();
+		});
+}
+
+void PregenerationScheduler::runTicket()
+{
+	size_t allocIndex;
+	float priority;
+	if (!m_queue.tryPop(allocIndex, priority))
+		return;
+
+	bool background = priority >= s_backgroundPriority;
+	if (background && m_runningBackground.fetch_add(1) >= m_settings.maxBackgroundJobs)
+	{
+		//too many workers on background jobs already, the ticket is reissued when one of them finishes
+		--m_runningBackground;
+		m_queue.push(allocIndex, priority);
+		++m_deferredTickets;
+		if (m_runningBackground == 0)
+		{
+			size_t deferred = m_deferredTickets;
+			while (deferred > 0 && !m_deferredTickets.compare_exchange_weak(deferred, deferred - 1));
+			if (deferred > 0)
+				pushTicket();
+		}
+		return;
+	}
+
+	generate(allocIndex);
+
+	if (background)
+	{
+		--m_runningBackground;
+		size_t deferred = m_deferredTickets;
+		while (deferred > 0 && !m_deferredTickets.compare_exchange_weak(deferred, deferred - 1));
+		if (deferred > 0)
+			pushTicket();
+	}
+}
+
+void PregenerationScheduler::generate(size_t allocIndex)
+{
+	auto expected = ChunkState::Empty;
+	if (!m_states[allocIndex].compare_exchange_strong(expected, ChunkState::Generating))
+		return;
+
+	m_generator->setChunkData(*m_grid, allocIndex);
+	m_states[allocIndex] = ChunkState::Generated;
+	++m_generatedCount;
+	onGenerated(allocIndex);
+}
+
+void PregenerationScheduler::onGenerated(size_t allocIndex)
+{
+	auto& chunk = m_grid->getAllocatedChunks()[allocIndex].getField<1>();
+	auto tryMesh = [this](size_t candidate) {
+		if (isRequested(candidate) && m_states[candidate] == ChunkState::Generated && isMeshable(candidate))
+			requestMesh(candidate);
+		};
+
+	tryMesh(allocIndex);
+	for (const auto& offset : s_neighbourOffsets)
+	{
+		size_t neighbour = findChunk(glm::ivec3(chunk.coord) + offset);
+		if (neighbour != s_noAllocation)
+			tryMesh(neighbour);
+	}
+}
+
+void PregenerationScheduler::requestMesh(size_t allocIndex)
+{
+	auto expected = ChunkState::Generated;
+	if (!m_states[allocIndex].compare_exchange_strong(expected, ChunkState::Meshing))
+		return;
+
+	//the mesh scheduler orders the job by distance and frustum from here on
+	bool background = m_priorities[allocIndex] >= s_backgroundPriority;
+	m_renderer->updateChunkAsync(*m_resources, m_grid->getAllocatedChunks()[allocIndex].getIndex(), *m_grid,
+		[this, allocIndex, background]() {
+			m_states[allocIndex] = ChunkState::Meshed;
+			++m_meshedCount;
+			if (background)
+				++m_pregeneratedCount;
+		});
+}
+
+bool PregenerationScheduler::isMeshable(size_t allocIndex) const
+{
+	auto& chunk = m_grid->getAllocatedChunks()[allocIndex].getField<1>();
+	for (const auto& offset : s_neighbourOffsets)
+	{
+		size_t neighbour = findChunk(glm::ivec3(chunk.coord) + offset);
+		if (neighbour != s_noAllocation && m_states[neighbour] < ChunkState::Generated)
+			return false;
+	}
+	return true;
+}
+
+size_t PregenerationScheduler::findChunk(glm::ivec3 chunkCoords) const
+{
+	const auto& coordToChunk = m_grid->getCoordToChunk();
+	auto it = coordToChunk.find(chunkCoords);
+	return it == coordToChunk.end() ? s_noAllocation : it->second;
+}
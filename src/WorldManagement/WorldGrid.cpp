@@ -17,6 +17,7 @@ void WorldGrid::generateSphere(size_t radius, glm::ivec3 centerPos)
 	m_coordToAllocation.clear();
 
 	m_pool = GridPool(radius * radius * radius * 8);
+	resetChunkEdits();
 
 	glm::ivec3 pos;
 
@@ -44,6 +45,7 @@ void WorldGrid::generateCylinder(size_t radius, size_t height, glm::ivec3 center
 	m_coordToAllocation.clear();
 
 	m_pool = GridPool(radius * radius * height * 4);
+	resetChunkEdits();
 
 	glm::ivec3 pos;
 
@@ -70,6 +72,7 @@ void WorldGrid::generateParallelogram(size_t width, size_t height, size_t depth,
 	m_coordToAllocation.clear();
 
 	m_pool = GridPool(width * height * depth);
+	resetChunkEdits();
 	glm::ivec3 pos;
 
 	for (pos.x = cornerPos.x; pos.x < cornerPos.x + static_cast<int32_t>(width); ++pos.x)
@@ -94,4 +97,55 @@ void WorldGrid::sortAllocationsByDistance(glm::ivec3 centerPos)
 	m_coordToAllocation.clear();
 	for (size_t i = 0; i < m_allocations.size(); ++i)
 		m_coordToAllocation.insert({ glm::ivec3(m_allocations[i].getField<1>().coord), i });
-}
\ No newline at end of file
+}
+
+void WorldGrid::beginGeneration(size_t allocIndex)
+{
+	m_chunkEdits[m_allocations[allocIndex].getIndex()].state = GenerationState::Generating;
+}
+
+void WorldGrid::finishGeneration(size_t allocIndex)
+{
+	size_t poolIndex = m_allocations[allocIndex].getIndex();
+	m_chunkEdits[poolIndex].state.store(GenerationState::Done, std::memory_order_seq_cst);
+	drainEdits(poolIndex);
+}
+
+bool WorldGrid::pushEdit(glm::ivec3 chunkCoords, const VoxelEdit& edit)
+{
+	auto it = m_coordToAllocation.find(chunkCoords);
+	if (it == m_coordToAllocation.end())
+		return false;
+
+	size_t poolIndex = m_allocations[it->second].getIndex();
+	auto& edits = m_chunkEdits[poolIndex];
+	edits.queue.push(edit);
+
+	//the owner already drained, whoever pushes afterwards has to apply the edit, the push and the
+	//load are both seq_cst like the owner's store and drain so one of the two sees the other
+	if (edits.state.load(std::memory_order_seq_cst) == GenerationState::Done)
+		drainEdits(poolIndex);
+	return true;
+}
+
+void WorldGrid::drainEdits(size_t poolIndex)
+{
+	auto& edits = m_chunkEdits[poolIndex];
+	auto blocks = std::span<Id::VoxelState>(m_pool.getField<0>().data() + poolIndex * Constants::chunkSize,
+		Constants::chunkSize);
+
+	//only one thread applies edits at a time, a thread that loses the race leaves its edit
+	//to the current drainer which checks the queue again before leaving
+	do
+	{
+		bool expected = false;
+		if (!edits.draining.compare_exchange_strong(expected, true))
+			return;
+		edits.queue.drain([&blocks](const VoxelEdit& edit) {
+			applyEdit(blocks, edit);
+			});
+		markChanged(poolIndex);
+		//seq_cst store then seq_cst load, mirrored by a pusher's push then failed compare exchange
+		edits.draining.store(false, std::memory_order_seq_cst);
+	} while (!edits.queue.empty());
+}
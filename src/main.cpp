@@ -7,6 +7,7 @@
 
 #include "WorldManagement/WorldGrid.h"
 #include "WorldManagement/Generator.h"
+#include "WorldManagement/PregenerationScheduler.h"
 
 #include "PlatformAbstractions/Console.h"
 
@@ -38,9 +39,11 @@ T getVector(const Json::Value& value) {
 	return vec;
 }
 
-void handleInputs(Platform::Window& window, Graphics::Utility::CameraPerspective& camera,
+//returns the camera velocity in world units per second
+glm::vec3 handleInputs(Platform::Window& window, Graphics::Utility::CameraPerspective& camera,
 	float deltaTime, float sensitivity, float moveVelocity, float speedMoveVelocity)
 {
+	glm::vec3 velocity(0.0f);
 	if (cursorMode)
 	{
         auto& mouse = window.getMouse();
@@ -73,11 +76,13 @@ void handleInputs(Platform::Window& window, Graphics::Utility::CameraPerspective
 		if (glm::length(moveDir) > std::numeric_limits<float>::epsilon()) {
 			moveDir = glm::normalize(moveDir);
 			if(mouse.buttonPressed<Platform::MouseButton::Rmb>())
-				camera.move(moveDir * deltaTime * speedMoveVelocity);
-			else camera.move(moveDir * deltaTime * moveVelocity);
+				velocity = moveDir * speedMoveVelocity;
+			else velocity = moveDir * moveVelocity;
+			camera.move(velocity * deltaTime);
 			moveDir = glm::vec3(0);		
 		}
 	}
+	return velocity;
 }
 
 void keyPressed(Platform::KeyboardKey key) {
@@ -152,7 +157,13 @@ int main()
 	Graphics::Utility::CameraPerspective camera = Graphics::Utility::CameraPerspective(
 		worldUpVector, position, pitch, yaw, fov, 800.f / 600.f, 0.1f, 100000.0f);
 	
-	generator.set(1234);
+	const uint64_t worldSeed = 1234;
+	generator.set(worldSeed);
+	generator.loadFromFile(engineFiles.getFile(EngineFilesystem::Directory::Generators, "terrain.json").string());
+
+	ChunkDiskCache chunkCache;
+	chunkCache.init(engineFiles.getCacheDirectory() / "chunks", worldSeed, generator.getTerrainHash());
+	generator.setCache(&chunkCache);
     
     window.create({ 800, 600 }, "app", Platform::WindowAttributes::firstPersonGameMaximisedAtr());
 
@@ -170,6 +181,17 @@ int main()
 	resources.registerResources(engineFiles);
 	resources.getAssetCache().printStatistics();
 
+	//the culling table saved by the last run is reused while the geometry stays the same, it is
+	//filled lazily while meshing unless asked to be built up front, an eager build only clips
+	//the pairs a loaded table is missing
+	auto cullingTablePath = engineFiles.getCacheDirectory() / "culling" / "culling.table";
+	resources.getAssetCache().loadCullingTable(cullingTablePath);
+	auto cullingTableIt = config.asObject().find("CullingTable");
+	if (cullingTableIt != config.asObject().end() && cullingTableIt->second.asString() == "Eager") {
+		resources.getAssetCache().buildCullingTable(pool);
+		resources.getAssetCache().saveCullingTable(cullingTablePath);
+	}
+
 	float deltaTime = 0.0f;
 
 	float mouseSensitivity = config.asObject().at("MouseSensitivity").asNumber();
@@ -183,16 +205,22 @@ int main()
 		camera.getPosition().x / Constants::chunkWidth,
 		camera.getPosition().y / Constants::chunkHeight,
 		camera.getPosition().z / Constants::chunkDepth));
-	for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
-		pool.pushTask([&generator, &grid, i]() {
-			//generator.fillChunk(grid, i, Generator::BlockTypes::Dirt);
-			generator.setChunkData(grid, i);
-		});
-	pool.pausePool();
 	renderer.dumpHandles();
-	
-	for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
-		renderer.updateChunkAsync(resources, grid.getAllocatedChunks()[i].getIndex(), grid);
+
+	//chunks are generated and meshed on demand around the camera and ahead of its motion
+	PregenerationScheduler::Settings pregenerationSettings;
+	auto pregenerationIt = config.asObject().find("Pregeneration");
+	if (pregenerationIt != config.asObject().end()) {
+		auto& pregeneration = pregenerationIt->second.asObject();
+		pregenerationSettings.viewRadius = getNumber<float>(pregeneration.at("ViewRadius"));
+		pregenerationSettings.lookaheadTime = getNumber<float>(pregeneration.at("LookaheadTime"));
+		pregenerationSettings.maxLookahead = getNumber<float>(pregeneration.at("MaxLookahead"));
+		pregenerationSettings.coneHalfAngle = glm::radians(getNumber<float>(pregeneration.at("ConeHalfAngle")));
+		pregenerationSettings.maxBackgroundJobs = getNumber<size_t>(pregeneration.at("MaxBackgroundJobs"));
+	}
+	PregenerationScheduler pregeneration;
+	pregeneration.init(grid, generator, renderer, resources, pool, pregenerationSettings);
+	pregeneration.update(camera.getPosition(), glm::vec3(0.0f), 0.0f);
 	
 	while (!window.shouldClose()) {
 		auto startTime = std::chrono::high_resolution_clock::now();
@@ -206,14 +234,29 @@ int main()
 		
 		camera.setAspectRatio(window.getAspectRatio());
 		
-		handleInputs(window, camera, deltaTime, mouseSensitivity, moveVelocity, speedMoveVelocity);
+		auto velocity = handleInputs(window, camera, deltaTime, mouseSensitivity, moveVelocity, speedMoveVelocity);
+		pregeneration.update(camera.getPosition(), velocity, deltaTime);
 		
 		renderer.drawFrame(camera);
 		
 		auto currentTime = std::chrono::high_resolution_clock::now();
 		deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 	}
+	renderer.cancelUploads();
 	pool.terminate();
+
+	//pairs clipped lazily during this run are kept for the next one
+	resources.getAssetCache().saveCullingTable(cullingTablePath);
+
+	auto pregenerationStats = pregeneration.getStats();
+	std::cout << "Pregeneration: hit rate " << pregenerationStats.hitRate() * 100.0f << "% ("
+		<< pregenerationStats.hits << " hits, " << pregenerationStats.misses << " misses), "
+		<< pregenerationStats.generated << " generated, " << pregenerationStats.meshed << " meshed, "
+		<< pregenerationStats.pregenerated << " meshed ahead of the camera" << std::endl;
+
+	auto cacheStats = chunkCache.getStats();
+	std::cout << "Chunk cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses ("
+		<< cacheStats.rejected << " invalid), " << cacheStats.stores << " stored" << std::endl;
 	renderer.cleanup(resources.getAssetCache().getStorageCache());
 	window.destroy();
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "Common.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//measures concurrent reads from the id caches while they still take the shared lock and after
+//they were frozen, runs headless,
+//usage: CacheReadBenchmark [threads] [reads per thread in millions]
+
+namespace
+{
+	using VertexCache = Id::Cache<glm::vec4, Id::Vertex, VecEpsilonEqualComparator<glm::vec4>>;
+	using ModelCache = Id::NamedCache<uint32_t, Id::Model>;
+
+	const size_t s_vertexCount = 4096;
+	const size_t s_modelCount = 1024;
+
+	void fillCaches(VertexCache& vertices, ModelCache& models)
+	{
+		vertices.reserve(s_vertexCount);
+		for (size_t i = 0; i < s_vertexCount; ++i)
+			vertices.add(glm::vec4(static_cast<float>(i), 0.0f, 0.0f, 1.0f));
+
+		models.reserve(s_modelCount);
+		for (size_t i = 0; i < s_modelCount; ++i)
+			models.add(static_cast<uint32_t>(i), "model" + std::to_string(i));
+	}
+
+	//the same access pattern as meshing, a model lookup followed by vertex lookups
+	double readsPerSecond(const VertexCache& vertices, const ModelCache& models, size_t threadCount, size_t reads)
+	{
+		std::vector<std::thread> threads;
+		std::vector<float> sums(threadCount, 0.0f);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back([&, t]() {
+				uint32_t seed = static_cast<uint32_t>(t) * 2654435761u + 1;
+				float sum = 0.0f;
+				for (size_t i = 0; i < reads; i += 2)
+				{
+					seed = seed * 1664525u + 1013904223u;
+					auto model = models[Id::Model((seed >> 8) % s_modelCount)];
+					sum += vertices[Id::Vertex((model * 4 + (seed >> 24)) % s_vertexCount)].x;
+				}
+				sums[t] = sum;
+				});
+		for (auto& thread : threads)
+			thread.join();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		//keeps the reads from being optimized out
+		float total = 0.0f;
+		for (auto sum : sums)
+			total += sum;
+		if (total < 0.0f)
+			std::cout << total << std::endl;
+
+		return threadCount * reads / std::chrono::duration<double>(end - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t threadCount = argc > 1 ? std::stoul(argv[1]) : std::max<size_t>(1, std::thread::hardware_concurrency());
+	size_t reads = static_cast<size_t>((argc > 2 ? std::stod(argv[2]) : 4.0) * 1e6);
+	threadCount = std::max<size_t>(1, threadCount);
+	reads = std::max<size_t>(2, reads);
+
+	VertexCache vertices;
+	ModelCache models;
+	fillCaches(vertices, models);
+
+	double locked = readsPerSecond(vertices, models, threadCount, reads);
+	vertices.freeze();
+	models.freeze();
+	if (!vertices.isFrozen() || !models.isFrozen())
+	{
+		std::cerr << "Caches did not freeze" << std::endl;
+		return EXIT_FAILURE;
+	}
+	double frozen = readsPerSecond(vertices, models, threadCount, reads);
+
+	std::cout << threadCount << " threads, " << reads << " reads each" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << std::left << std::setw(12) << "locked" << locked / 1e6 << " Mreads/s" << std::endl;
+	std::cout << std::left << std::setw(12) << "frozen" << frozen / 1e6 << " Mreads/s" << std::endl;
+	std::cout << "speedup " << frozen / locked << "x" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#include "HeapCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> s_heapAllocations = 0;
+}
+
+size_t getHeapAllocationCount()
+{
+	return s_heapAllocations;
+}
+
+void* operator new(size_t size)
+{
+	++s_heapAllocations;
+	if (void* pointer = std::malloc(size == 0 ? 1 : size))
+		return pointer;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
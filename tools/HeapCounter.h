@@ -0,0 +1,6 @@
+#pragma once
+#include <cstddef>
+
+//linking HeapCounter.cpp replaces the global operator new and delete so tools can count heap
+//allocations, they live in their own file so the compiler never sees malloc and a new expression together
+size_t getHeapAllocationCount();
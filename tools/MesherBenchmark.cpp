@@ -0,0 +1,964 @@
+#include "Rendering/ChunkMesher.h"
+#include "Rendering/MeshCache.h"
+#include "Rendering/MeshStats.h"
+#include "Rendering/VisibilityGraph.h"
+#include "HeapCounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+//checks the chunk mesher against scenes with known polygon counts, then measures meshing
+//throughput on terrain like chunks, runs headless,
+//usage: MesherBenchmark [iterations] [grid edge in chunks]
+
+namespace
+{
+	//everything meshing reads, registered the same way the asset and resource caches do it
+	struct Assets
+	{
+		Shape::VertexCache vertices;
+		Shape::UvCache uvs;
+		Id::Cache<glm::vec4, Id::Normal, VecEpsilonEqualComparator<glm::vec4>> normals;
+		Shape::PolygonCache polygons;
+		Shape::ColoringCache colorings;
+		Shape::PolygonIndexBuffer geometries;
+		Shape::ColoringIndexBuffer appearances;
+		Id::NamedCache<Shape::Model, Id::Model> models;
+		Id::NamedCache<Voxel::State, Id::VoxelState> states;
+		VoxelCullingCache culling;
+		ChunkMesher mesher;
+		ChunkMesher greedyMesher;
+
+		Id::VoxelState cube;
+		Id::VoxelState slab;
+	};
+
+	Id::Model registerBox(Assets& assets, const std::string& name, glm::vec3 dimension,
+		Shape::GeometryType geometryType, uint32_t texture)
+	{
+		Id::Texture textureIds[6];
+		glm::vec2 uvs[6][4];
+		for (size_t i = 0; i < enumCast(Shape::Side::Count); ++i)
+		{
+			textureIds[i] = Id::Texture(texture);
+			for (size_t j = 0; j < enumCast(Shape::FaceCorner::Count); ++j)
+				uvs[i][j] = Shape::defaultUvs[j];
+		}
+
+		std::vector<Id::Polygon> geometry;
+		std::vector<Id::Coloring> appearance;
+		Shape::registerParallelogram(textureIds, uvs, dimension, assets.vertices, assets.uvs, assets.normals,
+			assets.polygons, assets.colorings, geometry, appearance);
+
+		Shape::Model model = { assets.geometries.add(geometry, { geometryType }), assets.appearances.add(appearance) };
+		return assets.models.add(std::move(model), name);
+	}
+
+	void buildAssets(Assets& assets)
+	{
+		auto standardId = Shape::registerStandardCube(assets.vertices, assets.normals, assets.polygons, assets.geometries);
+		auto cubeModel = registerBox(assets, "cube", Shape::s_defaultDimensions, Shape::GeometryType::Cube, 0);
+		auto slabModel = registerBox(assets, "slab", glm::vec3(1.0f, 0.5f, 1.0f), Shape::GeometryType::Generic, 1);
+		assets.culling.init(assets.geometries, assets.polygons, assets.vertices, assets.normals, standardId);
+
+		auto emptyId = assets.states.add(Voxel::State{ Constants::emptyModelId, {}, "empty" }, "empty");
+		if (emptyId != Constants::emptyStateId)
+			throw std::runtime_error("Empty state id mismatch");
+		assets.cube = assets.states.add(Voxel::State{ cubeModel, {}, "cube" }, "cube");
+		assets.slab = assets.states.add(Voxel::State{ slabModel, {}, "slab" }, "slab");
+
+		ChunkMesher::Sources sources;
+		sources.voxelStates = &assets.states;
+		sources.models = &assets.models;
+		sources.geometries = &assets.geometries;
+		sources.appearances = &assets.appearances;
+		sources.culling = &assets.culling;
+		sources.polygons = &assets.polygons;
+		sources.normals = &assets.normals;
+		assets.mesher.init(sources);
+		assets.greedyMesher.init(sources);
+		assets.greedyMesher.setMode(ChunkMesher::Mode::Greedy);
+	}
+
+	//the engine freezes its caches once loading is done, so meshing and clipping read them unlocked
+	void freezeAssets(Assets& assets)
+	{
+		assets.vertices.freeze();
+		assets.uvs.freeze();
+		assets.normals.freeze();
+		assets.polygons.freeze();
+		assets.colorings.freeze();
+		assets.geometries.freeze();
+		assets.appearances.freeze();
+		assets.models.freeze();
+		assets.states.freeze();
+	}
+
+	size_t localIndex(size_t x, size_t y, size_t z)
+	{
+		return x + z * Constants::chunkWidth + y * Constants::chunkLayerSize;
+	}
+
+	void setLocal(WorldGrid& grid, size_t allocIndex, size_t x, size_t y, size_t z, Id::VoxelState state)
+	{
+		const auto& chunk = grid.getAllocatedChunks()[allocIndex].getField<1>();
+		grid.getBlock(chunk.start + localIndex(x, y, z)) = state;
+	}
+
+	void fillChunk(WorldGrid& grid, size_t allocIndex, Id::VoxelState state)
+	{
+		for (size_t i = 0; i < Constants::chunkSize; ++i)
+			grid.getBlock(grid.getAllocatedChunks()[allocIndex].getField<1>().start + i) = state;
+	}
+
+	size_t meshAll(const ChunkMesher& mesher, const WorldGrid& grid, IndexBuffer& out)
+	{
+		size_t total = 0;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			out.clear();
+			mesher.mesh(grid, alloc.getIndex(), out);
+			total += out.size();
+		}
+		return total;
+	}
+
+	bool sameIndices(const Indices& a, const Indices& b)
+	{
+		return a.polygon == b.polygon && a.coloring == b.coloring && a.block == b.block && a.extent == b.extent;
+	}
+
+	bool lessIndices(const Indices& a, const Indices& b)
+	{
+		return std::tie(a.polygon, a.coloring, a.block) < std::tie(b.polygon, b.coloring, b.block);
+	}
+
+	//splits greedy quads back into single faces, mirrors the extent decoding in Voxel.vert
+	void expandQuads(const Assets& assets, const IndexBuffer& quads, IndexBuffer& out)
+	{
+		const size_t axisStrides[3] = { 1, Constants::chunkLayerSize, Constants::chunkWidth };
+		for (const auto& quad : quads)
+		{
+			glm::vec4 normal = glm::abs(assets.normals[assets.polygons[quad.polygon].normal]);
+			size_t axis = normal.x >= normal.y && normal.x >= normal.z ? 0 : (normal.y >= normal.z ? 1 : 2);
+			size_t strideU = axisStrides[axis == 0 ? 1 : 0];
+			size_t strideV = axisStrides[axis == 2 ? 1 : 2];
+
+			for (size_t v = 0; v <= ((quad.extent >> 4) & 0xF); ++v)
+				for (size_t u = 0; u <= (quad.extent & 0xF); ++u)
+				{
+					Indices face = quad;
+					face.block = static_cast<uint32_t>(quad.block + u * strideU + v * strideV);
+					face.extent = 0;
+					out.push_back(face);
+				}
+		}
+	}
+
+	//mirrors the record decoding in Voxel.vert
+	void unpackQuads(const QuadBuffer& records, size_t chunkPoolIndex, IndexBuffer& out)
+	{
+		for (const auto& record : records)
+		{
+			Indices first;
+			first.polygon = record.polygonExtent & ((uint32_t(1) << QuadRecord::s_polygonBits) - 1);
+			first.coloring = record.coloringBlock & ((uint32_t(1) << QuadRecord::s_coloringBits) - 1);
+			first.block = static_cast<uint32_t>(chunkPoolIndex * Constants::chunkSize +
+				(record.coloringBlock >> QuadRecord::s_blockShift));
+			first.extent = (record.polygonExtent >> QuadRecord::s_extentShift) & 0xFF;
+			out.push_back(first);
+			if (record.polygonExtent & QuadRecord::s_pairBit)
+			{
+				Indices second = first;
+				++second.polygon;
+				++second.coloring;
+				out.push_back(second);
+			}
+		}
+	}
+
+	//every record of a side bucket has to face that side
+	bool isInBucket(const Assets& assets, const QuadRecord& record, size_t bucket)
+	{
+		if (bucket == ChunkMesher::s_unalignedBucket)
+			return true;
+		auto polygon = Id::Polygon(record.polygonExtent & ((uint32_t(1) << QuadRecord::s_polygonBits) - 1));
+		glm::vec3 normal = assets.normals[assets.polygons[polygon].normal];
+		return glm::length(normal - glm::vec3(Constants::directionsFloat3D[bucket])) < 1e-4f;
+	}
+
+	//packing and decoding has to give back what was meshed, regrouped by direction, counts the records
+	//on the way
+	size_t countPackMismatches(const Assets& assets, const ChunkMesher& mesher, const WorldGrid& grid,
+		size_t& recordCount)
+	{
+		IndexBuffer polygons, unpacked;
+		QuadBuffer records;
+		ChunkMesher::DirectionRanges ranges;
+		size_t mismatches = 0;
+		recordCount = 0;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			polygons.clear();
+			unpacked.clear();
+			records.clear();
+			mesher.mesh(grid, alloc.getIndex(), polygons);
+			mesher.packQuads(polygons, records, ranges);
+			unpackQuads(records, alloc.getIndex(), unpacked);
+			recordCount += records.size();
+
+			bool same = ranges.back() == records.size();
+			for (size_t bucket = 0; bucket < ChunkMesher::s_directionBuckets; ++bucket)
+				for (size_t i = ranges[bucket]; same && i < ranges[bucket + 1]; ++i)
+					same &= isInBucket(assets, records[i], bucket);
+			std::sort(polygons.begin(), polygons.end(), lessIndices);
+			std::sort(unpacked.begin(), unpacked.end(), lessIndices);
+			same &= unpacked.size() == polygons.size() &&
+				std::equal(unpacked.begin(), unpacked.end(), polygons.begin(), sameIndices);
+			mismatches += same ? 0 : 1;
+		}
+		return mismatches;
+	}
+
+	//share of the records a camera at the given position still draws after direction rejection
+	double drawnRecordShare(const ChunkMesher& mesher, const WorldGrid& grid, glm::vec3 camera)
+	{
+		IndexBuffer polygons;
+		QuadBuffer records;
+		ChunkMesher::DirectionRanges ranges;
+		size_t drawn = 0, total = 0;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			polygons.clear();
+			records.clear();
+			mesher.mesh(grid, alloc.getIndex(), polygons);
+			mesher.packQuads(polygons, records, ranges);
+			glm::vec3 corner = alloc.getField<1>().coordCorner;
+			for (size_t bucket = 0; bucket < ChunkMesher::s_directionBuckets; ++bucket)
+				if (ChunkMesher::canFaceCamera(bucket, corner, camera))
+					drawn += ranges[bucket + 1] - ranges[bucket];
+			total += records.size();
+		}
+		return total == 0 ? 1.0 : static_cast<double>(drawn) / total;
+	}
+
+	//the bitmask path has to produce exactly what culling every voxel through the table does
+	size_t countReferenceMismatches(const Assets& assets, const WorldGrid& grid)
+	{
+		IndexBuffer fast, reference;
+		size_t mismatches = 0;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			fast.clear();
+			reference.clear();
+			assets.mesher.mesh(grid, alloc.getIndex(), fast);
+			assets.mesher.meshReference(grid, alloc.getIndex(), reference);
+			if (fast.size() != reference.size() ||
+				!std::equal(fast.begin(), fast.end(), reference.begin(), sameIndices))
+				++mismatches;
+		}
+		return mismatches;
+	}
+
+	//greedy quads have to cover exactly the faces of the reference, order aside
+	size_t countGreedyMismatches(const Assets& assets, const WorldGrid& grid)
+	{
+		IndexBuffer quads, faces, reference;
+		size_t mismatches = 0;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			quads.clear();
+			faces.clear();
+			reference.clear();
+			assets.greedyMesher.mesh(grid, alloc.getIndex(), quads);
+			expandQuads(assets, quads, faces);
+			assets.mesher.meshReference(grid, alloc.getIndex(), reference);
+			std::sort(faces.begin(), faces.end(), lessIndices);
+			std::sort(reference.begin(), reference.end(), lessIndices);
+			if (faces.size() != reference.size() ||
+				!std::equal(faces.begin(), faces.end(), reference.begin(), sameIndices))
+				++mismatches;
+		}
+		return mismatches;
+	}
+
+	//meshes every chunk from several threads at once with a culling table nothing was clipped into yet,
+	//every result has to match the reference of an already warm table
+	size_t countConcurrentMismatches(const Assets& fresh, const Assets& warm, const WorldGrid& grid)
+	{
+		const size_t threadCount = 4;
+		const auto& chunks = grid.getAllocatedChunks();
+		std::vector<IndexBuffer> meshes(chunks.size());
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back([&, t]() {
+				for (size_t i = t; i < chunks.size(); i += threadCount)
+					fresh.mesher.mesh(grid, chunks[i].getIndex(), meshes[i]);
+				});
+		for (auto& thread : threads)
+			thread.join();
+
+		IndexBuffer reference;
+		size_t mismatches = 0;
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			reference.clear();
+			warm.mesher.meshReference(grid, chunks[i].getIndex(), reference);
+			if (meshes[i].size() != reference.size() ||
+				!std::equal(meshes[i].begin(), meshes[i].end(), reference.begin(), sameIndices))
+				++mismatches;
+		}
+		return mismatches;
+	}
+
+	//counts the chunks the solidity summaries mark as enclosed, and among them those that do mesh to something
+	size_t countEnclosed(const ChunkMesher& mesher, const WorldGrid& grid, size_t& visible)
+	{
+		std::vector<ChunkMesher::Solidity> solidity(grid.getPool().getPoolSize(), 0);
+		for (const auto& alloc : grid.getAllocatedChunks())
+			solidity[alloc.getIndex()] = mesher.summarizeSolidity(grid, alloc.getIndex());
+
+		size_t enclosed = 0;
+		visible = 0;
+		IndexBuffer out;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			const auto& chunk = alloc.getField<1>();
+			std::array<ChunkMesher::Solidity, enumCast(Shape::Side::Count)> neighbours;
+			for (size_t side = 0; side < neighbours.size(); ++side)
+				neighbours[side] = chunk.neighbourStarts[side] == WorldGrid::noChunkIndex ? 0 :
+					solidity[chunk.neighbourStarts[side] / Constants::chunkSize];
+			if (!ChunkMesher::isEnclosed(solidity[alloc.getIndex()], neighbours))
+				continue;
+
+			++enclosed;
+			out.clear();
+			mesher.mesh(grid, alloc.getIndex(), out);
+			visible += out.empty() ? 0 : 1;
+		}
+		return enclosed;
+	}
+
+	//chunks the visibility graph reaches from the camera with a frustum that lets everything through
+	size_t countReachable(const ChunkMesher& mesher, const WorldGrid& grid, glm::vec3 camera)
+	{
+		VisibilityGraph graph;
+		graph.init(grid.getPool().getPoolSize());
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			const auto& chunk = alloc.getField<1>();
+			VisibilityGraph::Neighbours links;
+			for (size_t side = 0; side < links.size(); ++side)
+				links[side] = chunk.neighbourStarts[side] == WorldGrid::noChunkIndex ? VisibilityGraph::s_noChunk :
+					static_cast<uint32_t>(chunk.neighbourStarts[side] / Constants::chunkSize);
+			graph.setChunk(alloc.getIndex(), glm::vec3(chunk.coordCorner),
+				mesher.computeConnectivity(grid, alloc.getIndex()), links);
+		}
+
+		std::vector<bool> visible;
+		if (!graph.findVisible(Frustum(), camera, visible))
+			return 0;
+		return static_cast<size_t>(std::count(visible.begin(), visible.end(), true));
+	}
+
+	glm::vec3 getChunkCenter(const WorldGrid& grid, size_t allocIndex)
+	{
+		return glm::vec3(grid.getAllocatedChunks()[allocIndex].getField<1>().coordCorner) +
+			glm::vec3(Constants::chunkDimensions) * 0.5f;
+	}
+
+	bool check(const char* name, size_t result, size_t expected)
+	{
+		bool passed = result == expected;
+		std::cout << (passed ? "[pass] " : "[FAIL] ") << name << ": " << result;
+		if (!passed)
+			std::cout << ", expected " << expected;
+		std::cout << std::endl;
+		return passed;
+	}
+
+	//percentiles within the bucket precision, exact counts and extremes, nothing lost across threads
+	bool checkMeshStats()
+	{
+		bool passed = true;
+		auto isNear = [](uint64_t value, uint64_t expected) {
+			return value + value / HistogramLayout::s_subBuckets >= expected &&
+				value <= expected + expected / HistogramLayout::s_subBuckets;
+			};
+
+		Histogram histogram;
+		for (uint64_t value = 1; value <= 10000; ++value)
+			histogram.record(value);
+		passed &= check("histogram count", histogram.getCount(), 10000);
+		passed &= check("histogram max", histogram.getMax(), 10000);
+		passed &= check("histogram min", histogram.getMin(), 1);
+		passed &= check("histogram p50 near 5000", isNear(histogram.getPercentile(50.0), 5000) ? 1 : 0, 1);
+		passed &= check("histogram p99 near 9900", isNear(histogram.getPercentile(99.0), 9900) ? 1 : 0, 1);
+		passed &= check("histogram p100", histogram.getPercentile(100.0), 10000);
+		for (uint64_t value : { uint64_t(0), uint64_t(31), uint64_t(32), uint64_t(1000), uint64_t(123456789), HistogramLayout::s_maxValue })
+		{
+			size_t bucket = HistogramLayout::getBucket(value);
+			passed &= check("histogram bucket bounds", HistogramLayout::getLowerBound(bucket) <= value &&
+				value <= HistogramLayout::getUpperBound(bucket) ? 1 : 0, 1);
+		}
+
+		const size_t threadCount = 4, samples = 20000;
+		MeshStats stats;
+		stats.init(threadCount);
+		std::vector<std::thread> threads;
+		for (size_t thread = 0; thread < threadCount; ++thread)
+			threads.emplace_back([&stats, thread]() {
+				for (size_t i = 0; i < samples; ++i)
+				{
+					stats.record(thread, MeshStats::Metric::MeshTime, i);
+					stats.count(thread, MeshStats::Counter::Uploaded);
+				}
+				});
+		for (auto& thread : threads)
+			thread.join();
+		auto snapshot = stats.getSnapshot();
+		passed &= check("concurrent stats samples", snapshot.get(MeshStats::Metric::MeshTime).getCount(), threadCount * samples);
+		passed &= check("concurrent stats sum", snapshot.get(MeshStats::Metric::MeshTime).getSum(),
+			threadCount * samples * (samples - 1) / 2);
+		passed &= check("concurrent stats counter", snapshot.get(MeshStats::Counter::Uploaded), threadCount * samples);
+
+		std::ostringstream json;
+		snapshot.writeJson(json);
+		passed &= check("stats json names the mesh time", json.str().find("\"meshTimeUs\": {") != std::string::npos ? 1 : 0, 1);
+		stats.reset();
+		passed &= check("reset stats samples", stats.getSnapshot().get(MeshStats::Metric::MeshTime).getCount(), 0);
+		return passed;
+	}
+
+	bool runChecks(const Assets& assets)
+	{
+		const size_t polygonsPerFace = 2;
+		const size_t layer = Constants::chunkWidth * Constants::chunkDepth;
+		IndexBuffer out;
+		WorldGrid grid;
+		bool passed = true;
+
+		grid.generateCube(1, glm::ivec3(0));
+		passed &= check("empty chunk", meshAll(assets.mesher, grid, out), 0);
+
+		setLocal(grid, 0, 5, 5, 5, assets.cube);
+		passed &= check("single cube", meshAll(assets.mesher, grid, out), 6 * polygonsPerFace);
+		size_t records = 0;
+		passed &= check("single cube packed chunks differing", countPackMismatches(assets, assets.mesher, grid, records), 0);
+		passed &= check("single cube packed records", records, 6);
+
+		setLocal(grid, 0, 6, 5, 5, assets.cube);
+		passed &= check("two adjacent cubes", meshAll(assets.mesher, grid, out), 10 * polygonsPerFace);
+
+		//the cube covers the side of the slab next to it, the half height slab side covers nothing
+		grid.generateCube(1, glm::ivec3(0));
+		setLocal(grid, 0, 5, 5, 5, assets.cube);
+		setLocal(grid, 0, 6, 5, 5, assets.slab);
+		passed &= check("cube beside slab", meshAll(assets.mesher, grid, out), 11 * polygonsPerFace);
+
+		grid.generateCube(1, glm::ivec3(0));
+		fillChunk(grid, 0, assets.cube);
+		passed &= check("solid chunk", meshAll(assets.mesher, grid, out), 6 * layer * polygonsPerFace);
+
+		//faces between neighbouring chunks are hidden, only the outer shell remains
+		grid.generateCube(2, glm::ivec3(0));
+		for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
+			fillChunk(grid, i, assets.cube);
+		passed &= check("solid 2x2x2 chunks", meshAll(assets.mesher, grid, out), 8 * 3 * layer * polygonsPerFace);
+
+		//only the center chunk is surrounded, a single air voxel on a face it touches uncovers it
+		size_t visible = 0;
+		grid.generateCube(3, glm::ivec3(0));
+		for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
+			fillChunk(grid, i, assets.cube);
+		passed &= check("solid 3x3x3 chunks enclosed", countEnclosed(assets.mesher, grid, visible), 1);
+		passed &= check("solid 3x3x3 enclosed chunks meshing to something", visible, 0);
+		auto above = grid.getCoordToChunk().at(glm::ivec3(1, 2, 1));
+		setLocal(grid, above, 5, 0, 5, Constants::emptyStateId);
+		passed &= check("solid 3x3x3 chunks with a hole enclosed", countEnclosed(assets.mesher, grid, visible), 0);
+		setLocal(grid, above, 5, 1, 5, Constants::emptyStateId);
+		setLocal(grid, above, 5, 0, 5, assets.cube);
+		passed &= check("solid 3x3x3 chunks with a buried hole enclosed", countEnclosed(assets.mesher, grid, visible), 1);
+
+		//a hollow center chunk sees its six neighbours and no further through solid ones
+		for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
+			fillChunk(grid, i, assets.cube);
+		auto center = grid.getCoordToChunk().at(glm::ivec3(1, 1, 1));
+		auto right = grid.getCoordToChunk().at(glm::ivec3(2, 1, 1));
+		fillChunk(grid, center, Constants::emptyStateId);
+		for (size_t x = 0; x < Constants::chunkWidth; ++x)
+			setLocal(grid, right, x, 5, 5, Constants::emptyStateId);
+		for (size_t y = 0; y < Constants::chunkHeight; ++y)
+			setLocal(grid, right, 9, y, 9, Constants::emptyStateId);
+		auto connectivityOf = [&](size_t allocIndex) {
+			return static_cast<size_t>(assets.mesher.computeConnectivity(grid, grid.getAllocatedChunks()[allocIndex].getIndex()));
+			};
+		passed &= check("hollow chunk connectivity", connectivityOf(center), ChunkMesher::s_fullyConnected);
+		passed &= check("solid chunk connectivity", connectivityOf(above), 0);
+		passed &= check("two tunnel chunk connectivity", connectivityOf(right),
+			ChunkMesher::getConnectionBit(Shape::Side::Left, Shape::Side::Right) |
+			ChunkMesher::getConnectionBit(Shape::Side::Bottom, Shape::Side::Top));
+		passed &= check("chunks reached from a hollow chunk", countReachable(assets.mesher, grid, getChunkCenter(grid, center)), 7);
+		//from the hollow chunk above the view turns sideways but never back down
+		fillChunk(grid, above, Constants::emptyStateId);
+		passed &= check("chunks reached through two hollow chunks", countReachable(assets.mesher, grid, getChunkCenter(grid, center)), 11);
+		passed &= check("chunks reached from outside the grid", countReachable(assets.mesher, grid, glm::vec3(-100.0f)), 0);
+
+		//random mix of cubes, slabs and air over several chunks
+		grid.generateCube(3, glm::ivec3(0));
+		uint32_t seed = 7;
+		for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
+			for (size_t j = 0; j < Constants::chunkSize; ++j)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				uint32_t roll = (seed >> 16) % 8;
+				Id::VoxelState state = roll < 4 ? assets.cube : roll == 4 ? assets.slab : Constants::emptyStateId;
+				grid.getBlock(grid.getAllocatedChunks()[i].getField<1>().start + j) = state;
+			}
+		passed &= check("random scene chunks differing from reference", countReferenceMismatches(assets, grid), 0);
+		passed &= check("random scene greedy chunks differing from reference", countGreedyMismatches(assets, grid), 0);
+		passed &= check("random scene packed chunks differing", countPackMismatches(assets, assets.mesher, grid, records), 0);
+		passed &= check("random scene greedy packed chunks differing", countPackMismatches(assets, assets.greedyMesher, grid, records), 0);
+		passed &= check("random scene chunks enclosed", countEnclosed(assets.mesher, grid, visible), 0);
+
+		Assets fresh;
+		buildAssets(fresh);
+		freezeAssets(fresh);
+		passed &= check("concurrent lazy culling chunks differing from reference",
+			countConcurrentMismatches(fresh, assets, grid), 0);
+
+		//a flat layer merges into one quad per side
+		grid.generateCube(1, glm::ivec3(0));
+		for (size_t z = 0; z < Constants::chunkDepth; ++z)
+			for (size_t x = 0; x < Constants::chunkWidth; ++x)
+				setLocal(grid, 0, x, 0, z, assets.cube);
+		passed &= check("flat layer greedy", meshAll(assets.greedyMesher, grid, out), 6 * polygonsPerFace);
+		passed &= check("flat layer greedy chunks differing from reference", countGreedyMismatches(assets, grid), 0);
+
+		grid.generateCube(1, glm::ivec3(0));
+		fillChunk(grid, 0, assets.cube);
+		passed &= check("solid chunk greedy", meshAll(assets.greedyMesher, grid, out), 6 * polygonsPerFace);
+
+		passed &= checkMeshStats();
+		return passed;
+	}
+
+	uint32_t hashColumn(int32_t x, int32_t z)
+	{
+		uint32_t hash = static_cast<uint32_t>(x) * 0x27d4eb2du ^ static_cast<uint32_t>(z) * 0x165667b1u;
+		hash = (hash ^ (hash >> 15)) * 0x2c1b3c6du;
+		return hash ^ (hash >> 12);
+	}
+
+	//rolling hills with scattered slabs on top, surfaces cross the chunk borders in every direction
+	void fillTerrain(const Assets& assets, WorldGrid& grid, size_t edge)
+	{
+		const int32_t worldHeight = static_cast<int32_t>(edge * Constants::chunkHeight);
+		for (size_t i = 0; i < grid.getAllocatedChunks().size(); ++i)
+		{
+			const auto& chunk = grid.getAllocatedChunks()[i].getField<1>();
+			for (size_t z = 0; z < Constants::chunkDepth; ++z)
+				for (size_t x = 0; x < Constants::chunkWidth; ++x)
+				{
+					int32_t worldX = chunk.coordCorner.x + static_cast<int32_t>(x);
+					int32_t worldZ = chunk.coordCorner.z + static_cast<int32_t>(z);
+					int32_t height = worldHeight / 2 + static_cast<int32_t>(hashColumn(worldX / 4, worldZ / 4) % 9) - 4;
+					bool slabOnTop = hashColumn(worldX, worldZ) % 7 == 0;
+					for (size_t y = 0; y < Constants::chunkHeight; ++y)
+					{
+						int32_t worldY = chunk.coordCorner.y + static_cast<int32_t>(y);
+						Id::VoxelState state = Constants::emptyStateId;
+						if (worldY < height)
+							state = assets.cube;
+						else if (worldY == height && slabOnTop)
+							state = assets.slab;
+						grid.getBlock(chunk.start + localIndex(x, y, z)) = state;
+					}
+				}
+		}
+	}
+
+	template<typename Func>
+	double medianSeconds(size_t iterations, Func&& func)
+	{
+		std::vector<double> seconds;
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			func();
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds.push_back(std::chrono::duration<double>(end - start).count());
+		}
+		std::sort(seconds.begin(), seconds.end());
+		return seconds[seconds.size() / 2];
+	}
+
+	//meshes and packs every chunk the way Renderer::updateChunk does on one worker,
+	//returns the heap allocations made while doing so
+	size_t meshIntoArena(const ChunkMesher& mesher, const WorldGrid& grid, ScratchArena& arena,
+		size_t& polygonPeak, size_t& recordPeak)
+	{
+		size_t before = getHeapAllocationCount();
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			arena.reset();
+			IndexBuffer polygons{ ArenaAllocator<Indices>(arena) };
+			QuadBuffer records{ ArenaAllocator<QuadRecord>(arena) };
+			polygons.reserve(polygonPeak);
+			records.reserve(recordPeak);
+
+			ChunkMesher::DirectionRanges ranges;
+			mesher.mesh(grid, alloc.getIndex(), polygons);
+			mesher.packQuads(polygons, records, ranges);
+			polygonPeak = std::max(polygonPeak, polygons.size());
+			recordPeak = std::max(recordPeak, records.size());
+		}
+		return getHeapAllocationCount() - before;
+	}
+
+	//meshes every chunk through the cache like Renderer::updateChunk, returns the chunks whose
+	//records or ranges differ from meshing them directly
+	size_t meshThroughCache(const ChunkMesher& mesher, const WorldGrid& grid, MeshCache& cache)
+	{
+		size_t mismatches = 0;
+		IndexBuffer polygons;
+		QuadBuffer cached, direct;
+		for (const auto& alloc : grid.getAllocatedChunks())
+		{
+			ChunkMesher::DirectionRanges cachedRanges, directRanges;
+			polygons.clear();
+			cached.clear();
+			direct.clear();
+			mesher.mesh(grid, alloc.getIndex(), polygons);
+			mesher.packQuads(polygons, direct, directRanges);
+
+			auto key = mesher.hashInput(grid, alloc.getIndex());
+			if (!cache.find(key, cached, cachedRanges))
+			{
+				cache.store(key, direct, directRanges);
+				continue;
+			}
+			bool same = cachedRanges == directRanges && cached.size() == direct.size();
+			for (size_t i = 0; same && i < cached.size(); ++i)
+				same = cached[i].polygonExtent == direct[i].polygonExtent && cached[i].coloringBlock == direct[i].coloringBlock;
+			mismatches += same ? 0 : 1;
+		}
+		return mismatches;
+	}
+
+	void runBenchmark(const Assets& assets, size_t iterations, size_t edge)
+	{
+		WorldGrid grid;
+		grid.generateCube(edge, glm::ivec3(0));
+		fillTerrain(assets, grid, edge);
+		size_t records = 0, greedyRecords = 0;
+		if (countReferenceMismatches(assets, grid) != 0 || countGreedyMismatches(assets, grid) != 0 ||
+			countPackMismatches(assets, assets.mesher, grid, records) != 0 ||
+			countPackMismatches(assets, assets.greedyMesher, grid, greedyRecords) != 0)
+			throw std::runtime_error("Terrain mesh differs from the reference mesh");
+
+		IndexBuffer out;
+		out.reserve(Constants::chunkSize * 6);
+		size_t instances = meshAll(assets.mesher, grid, out);
+		size_t greedyInstances = meshAll(assets.greedyMesher, grid, out);
+		size_t chunkCount = grid.getAllocatedChunks().size();
+
+		double fast = medianSeconds(iterations, [&]() { meshAll(assets.mesher, grid, out); });
+		double greedy = medianSeconds(iterations, [&]() { meshAll(assets.greedyMesher, grid, out); });
+		double reference = medianSeconds(iterations, [&]() {
+			for (const auto& alloc : grid.getAllocatedChunks())
+			{
+				out.clear();
+				assets.mesher.meshReference(grid, alloc.getIndex(), out);
+			}
+			});
+
+		std::cout << std::endl << "Terrain " << edge << "^3 chunks, " << instances << " polygon instances, "
+			<< iterations << " iterations, median times" << std::endl;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << std::left << std::setw(12) << "bitmask" << fast * 1e6 / chunkCount << " us/chunk, "
+			<< chunkCount * Constants::chunkSize / fast / 1e6 << " Mvoxels/s" << std::endl;
+		std::cout << std::left << std::setw(12) << "greedy" << greedy * 1e6 / chunkCount << " us/chunk, "
+			<< chunkCount * Constants::chunkSize / greedy / 1e6 << " Mvoxels/s" << std::endl;
+		std::cout << std::left << std::setw(12) << "reference" << reference * 1e6 / chunkCount << " us/chunk, "
+			<< chunkCount * Constants::chunkSize / reference / 1e6 << " Mvoxels/s" << std::endl;
+		std::cout << "speedup " << reference / fast << "x" << std::endl;
+
+		//the slow chunks are what a frame waits on, so the tail matters as much as the mean
+		Histogram chunkTimes;
+		for (size_t i = 0; i < iterations; ++i)
+			for (const auto& alloc : grid.getAllocatedChunks())
+			{
+				auto start = std::chrono::steady_clock::now();
+				out.clear();
+				assets.greedyMesher.mesh(grid, alloc.getIndex(), out);
+				chunkTimes.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count()));
+			}
+		std::cout << "greedy per chunk p50 " << chunkTimes.getPercentile(50.0) / 1000.0 << " us, p99 "
+			<< chunkTimes.getPercentile(99.0) / 1000.0 << " us, max " << chunkTimes.getMax() / 1000.0 << " us" << std::endl;
+		std::cout << "culling pairs clipped " << assets.culling.getComputedPairCount() << " of "
+			<< assets.culling.getPairCount() << ", " << assets.culling.getMaskWordCount() << " mask words" << std::endl;
+		std::cout << "greedy instances " << greedyInstances << ", " << static_cast<double>(instances) / greedyInstances
+			<< "x fewer, " << greedyInstances * sizeof(Indices) / 1024 << " KiB of indices" << std::endl;
+		std::cout << "quad records " << records << " per face, " << greedyRecords << " greedy, "
+			<< greedyRecords * sizeof(QuadRecord) / 1024 << " KiB uploaded, "
+			<< static_cast<double>(instances * sizeof(Indices)) / (greedyRecords * sizeof(QuadRecord))
+			<< "x less than per face indices" << std::endl;
+
+		glm::vec3 center = glm::vec3(edge * Constants::chunkWidth) * 0.5f;
+		glm::vec3 outside = glm::vec3(edge * Constants::chunkWidth) * 1.5f;
+		std::cout << "direction rejection draws " << drawnRecordShare(assets.greedyMesher, grid, center) * 100.0
+			<< "% of records from the grid center, " << drawnRecordShare(assets.greedyMesher, grid, outside) * 100.0
+			<< "% from outside a corner" << std::endl;
+
+		//the first pass starts from an empty arena and grows it, after that nothing should reach the heap
+		ScratchArena arena;
+		size_t polygonPeak = 0, recordPeak = 0;
+		size_t warmup = meshIntoArena(assets.greedyMesher, grid, arena, polygonPeak, recordPeak);
+		size_t growth = arena.getGrowthCount();
+		if (!check("heap allocations meshing into a warm arena",
+			meshIntoArena(assets.greedyMesher, grid, arena, polygonPeak, recordPeak), 0) ||
+			!check("arena growths after warmup", arena.getGrowthCount() - growth, 0))
+			throw std::runtime_error("Meshing allocated outside its arena");
+		std::cout << "mesh arena peak " << arena.getHighWaterMark() / 1024.0 << " KiB per worker, "
+			<< growth << " growths and " << warmup << " heap allocations while warming up" << std::endl;
+
+		//the terrain repeats whole chunks below and above the surface, a budget of a single
+		//mesh forces evictions on top of that
+		MeshCache cache(64 * 1024 * 1024);
+		if (!check("cached meshes differing", meshThroughCache(assets.greedyMesher, grid, cache), 0))
+			throw std::runtime_error("Cached meshes differ from meshing");
+		auto stats = cache.getStats();
+
+		//an entry under the same key with other contents must not be handed out
+		QuadBuffer colliding;
+		ChunkMesher::DirectionRanges collidingRanges;
+		auto firstHash = assets.greedyMesher.hashInput(grid, grid.getAllocatedChunks()[0].getIndex());
+		firstHash.check = ~firstHash.check;
+		if (!check("key collision served from the cache", cache.find(firstHash, colliding, collidingRanges) ? 1 : 0, 0) ||
+			!check("key collisions counted", cache.getStats().collisions, 1))
+			throw std::runtime_error("Mesh cache trusts the key alone");
+
+		MeshCache tinyCache(16 * 1024);
+		meshThroughCache(assets.greedyMesher, grid, tinyCache);
+		auto tinyStats = tinyCache.getStats();
+		if (!check("tiny cache over budget", tinyStats.memory > tinyCache.getBudget() ? 1 : 0, 0) ||
+			!check("tiny cache evicted", tinyStats.evictions > 0 ? 1 : 0, 1))
+			throw std::runtime_error("Mesh cache does not keep its budget");
+
+		size_t visible = 0;
+		size_t enclosed = countEnclosed(assets.greedyMesher, grid, visible);
+		if (!check("terrain enclosed chunks meshing to something", visible, 0))
+			throw std::runtime_error("An enclosed chunk has visible faces");
+		double summarize = medianSeconds(iterations, [&]() {
+			size_t solid = 0;
+			for (const auto& alloc : grid.getAllocatedChunks())
+				solid += assets.greedyMesher.summarizeSolidity(grid, alloc.getIndex());
+			if (solid == 1)
+				std::cout << solid << std::endl;
+			});
+		std::cout << "enclosed chunks " << enclosed << " of " << chunkCount << ", summarizing "
+			<< summarize * 1e6 / chunkCount << " us/chunk" << std::endl;
+
+		auto top = grid.getCoordToChunk().find(glm::ivec3(edge / 2, edge - 1, edge / 2));
+		size_t reachable = top == grid.getCoordToChunk().end() ? 0 :
+			countReachable(assets.greedyMesher, grid, getChunkCenter(grid, top->second));
+		double connect = medianSeconds(iterations, [&]() {
+			size_t connections = 0;
+			for (const auto& alloc : grid.getAllocatedChunks())
+				connections += assets.greedyMesher.computeConnectivity(grid, alloc.getIndex());
+			if (connections == 1)
+				std::cout << connections << std::endl;
+			});
+		std::cout << "chunks reachable from the top center " << reachable << " of " << chunkCount
+			<< ", connectivity " << connect * 1e6 / chunkCount << " us/chunk" << std::endl;
+
+		double hash = medianSeconds(iterations, [&]() {
+			uint64_t combined = 0;
+			for (const auto& alloc : grid.getAllocatedChunks())
+				combined ^= assets.greedyMesher.hashInput(grid, alloc.getIndex()).key;
+			if (combined == 1)
+				std::cout << combined << std::endl;
+			});
+		std::cout << "mesh cache " << stats.hitRate() * 100.0f << "% hits, " << stats.entries << " entries, "
+			<< stats.memory / 1024.0 << " KiB, hashing " << hash * 1e6 / chunkCount << " us/chunk, "
+			<< tinyStats.evictions << " evictions with a " << tinyCache.getBudget() / 1024 << " KiB budget" << std::endl;
+	}
+
+	//runs the tasks on plain threads, the engine hands them to MT::ThreadPool instead
+	void runOnThreads(size_t threadCount, size_t taskCount, const std::function<void(size_t)>& task)
+	{
+		std::atomic<size_t> next = 0;
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back([&]() {
+				for (size_t i = next++; i < taskCount; i = next++)
+					task(i);
+				});
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	//boxes with every combination of quarter step sizes, their faces overlap partially in all directions
+	void registerBoxes(Assets& assets)
+	{
+		for (size_t i = 0; i < 64; ++i)
+		{
+			glm::vec3 dimension(
+				static_cast<float>(1 + i % 4) / 4.0f,
+				static_cast<float>(1 + (i / 4) % 4) / 4.0f,
+				static_cast<float>(1 + (i / 16) % 4) / 4.0f);
+			registerBox(assets, "box" + std::to_string(i), dimension, Shape::GeometryType::Generic, 2);
+		}
+	}
+
+	//compares every mask word and, when asked, where the masks were stored
+	size_t countTableMismatches(const Assets& assets, const VoxelCullingCache& a, const VoxelCullingCache& b,
+		bool compareStarts)
+	{
+		const size_t bitsPerWord = sizeof(VoxelCullingCache::BitMask) * 8;
+		const auto& entries = assets.geometries.entryData();
+		size_t mismatches = 0;
+		for (size_t side = 0; side < enumCast(Shape::Side::Count); ++side)
+			for (uint32_t main = 0; main < entries.size(); ++main)
+				for (uint32_t adj = 0; adj < entries.size(); ++adj)
+				{
+					auto sideId = static_cast<Shape::Side>(side);
+					size_t startA = a.getCullingStart(main, adj, sideId);
+					size_t startB = b.getCullingStart(main, adj, sideId);
+					bool same = !compareStarts || startA == startB;
+					for (size_t word = 0; word * bitsPerWord < entries[main].size; ++word)
+						same &= a.getMaskWord(startA + word) == b.getMaskWord(startB + word);
+					mismatches += same ? 0 : 1;
+				}
+		return mismatches;
+	}
+
+	//saves a partly clipped table, loads it back, finishes it lazily on top of the mapping and
+	//saves that again, then makes sure a table saved for other geometry is rejected
+	bool checkCullingPersistence(const Assets& assets, const VoxelCullingCache& complete)
+	{
+		auto directory = std::filesystem::temp_directory_path() / "MesherBenchmarkCulling";
+		auto path = directory / "culling.table";
+		auto standardId = assets.culling.getStandardBlockGeometryId();
+		auto serial = [](size_t taskCount, const std::function<void(size_t)>& task) {
+			for (size_t i = 0; i < taskCount; ++i)
+				task(i);
+			};
+
+		VoxelCullingCache partial, loaded, reloaded;
+		for (auto* table : { &partial, &loaded, &reloaded })
+			table->init(assets.geometries, assets.polygons, assets.vertices, assets.normals, standardId);
+		uint32_t geometryCount = static_cast<uint32_t>(assets.geometries.entrySize());
+		for (uint32_t main = 0; main < geometryCount / 2; ++main)
+			for (uint32_t adj = 0; adj < geometryCount; ++adj)
+				partial.getCullingStart(main, adj, Shape::Side::Top);
+
+		bool passed = true;
+		passed &= check("partial table saved", partial.save(path) ? 1 : 0, 1);
+		double loadSeconds = medianSeconds(1, [&]() { passed &= check("partial table loaded", loaded.load(path) ? 1 : 0, 1); });
+		passed &= check("loaded pairs", loaded.getComputedPairCount(), partial.getComputedPairCount());
+		loaded.buildAll(serial);
+		passed &= check("pairs clipped after loading differing", countTableMismatches(assets, complete, loaded, false), 0);
+
+		//the loaded table still reads from the file it replaces, which windows only allows by moving it aside
+		passed &= check("completed table saved over its mapping", loaded.save(path) ? 1 : 0, 1);
+		passed &= check("pairs differing after saving over the mapping", countTableMismatches(assets, complete, loaded, false), 0);
+		passed &= check("completed table saved again", loaded.save(path) ? 1 : 0, 1);
+		passed &= check("completed table loaded", reloaded.load(path) ? 1 : 0, 1);
+		passed &= check("reloaded pairs", reloaded.getComputedPairCount(), reloaded.getPairCount());
+		passed &= check("reloaded pairs differing", countTableMismatches(assets, loaded, reloaded, true), 0);
+
+		Assets other;
+		buildAssets(other);
+		freezeAssets(other);
+		passed &= check("table for other geometry loaded", other.culling.load(path) ? 1 : 0, 0);
+
+		std::cout << std::left << std::setw(20) << "load saved table" << loadSeconds * 1e3 << " ms, "
+			<< std::filesystem::file_size(path) << " bytes" << std::endl;
+
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+		return passed;
+	}
+
+	bool benchmarkCullingBuild()
+	{
+		Assets assets;
+		buildAssets(assets);
+		registerBoxes(assets);
+		freezeAssets(assets);
+		auto standardId = assets.culling.getStandardBlockGeometryId();
+		size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+		VoxelCullingCache clipped, analytic, parallel;
+		for (auto* table : { &clipped, &analytic, &parallel })
+			table->init(assets.geometries, assets.polygons, assets.vertices, assets.normals, standardId);
+		clipped.setAnalyticFastPath(false);
+
+		auto serial = [](size_t taskCount, const std::function<void(size_t)>& task) {
+			for (size_t i = 0; i < taskCount; ++i)
+				task(i);
+			};
+		auto threaded = [threadCount](size_t taskCount, const std::function<void(size_t)>& task) {
+			runOnThreads(threadCount, taskCount, task);
+			};
+		double clippedSeconds = medianSeconds(1, [&]() { clipped.buildAll(serial); });
+		double analyticSeconds = medianSeconds(1, [&]() { analytic.buildAll(serial); });
+		double parallelSeconds = medianSeconds(1, [&]() { parallel.buildAll(threaded); });
+
+		std::cout << std::endl << "Culling table, " << assets.geometries.entrySize() << " geometries, "
+			<< clipped.getPairCount() << " pairs" << std::endl;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << std::left << std::setw(20) << "clipper only" << clippedSeconds * 1e3 << " ms" << std::endl;
+		std::cout << std::left << std::setw(20) << "analytic" << analyticSeconds * 1e3 << " ms" << std::endl;
+		std::cout << std::left << std::setw(20) << "analytic, threads" << parallelSeconds * 1e3 << " ms on "
+			<< threadCount << " threads" << std::endl;
+		std::cout << std::left << std::setw(20) << "table memory" << analytic.getMemoryUsage() / 1024.0 << " KiB, "
+			<< analytic.getMaskCount() << " distinct masks, " << (analytic.usesWideIds() ? "32" : "16")
+			<< " bit ids" << std::endl;
+
+		bool passed = true;
+		passed &= check("analytic pairs differing from clipper", countTableMismatches(assets, clipped, analytic, false), 0);
+		passed &= check("parallel pairs differing from serial", countTableMismatches(assets, analytic, parallel, true), 0);
+		passed &= checkCullingPersistence(assets, analytic);
+		return passed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t iterations = argc > 1 ? std::stoul(argv[1]) : 20;
+	size_t edge = argc > 2 ? std::stoul(argv[2]) : 4;
+	iterations = std::max<size_t>(1, iterations);
+	edge = std::max<size_t>(1, edge);
+
+	Assets assets;
+	buildAssets(assets);
+	freezeAssets(assets);
+
+	if (!runChecks(assets))
+	{
+		std::cerr << "Mesher checks failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	runBenchmark(assets, iterations, edge);
+	if (!benchmarkCullingBuild())
+	{
+		std::cerr << "Culling table checks failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
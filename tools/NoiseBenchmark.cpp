@@ -0,0 +1,272 @@
+#include "WorldManagement/NoiseBackend.h"
+#include "WorldManagement/NoiseGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//compares noise backends on raw fbm throughput and on the terrain they produce for a noise graph,
+//usage: NoiseBenchmark [graph path] [region width in voxels] [sample count]
+
+namespace
+{
+	const size_t s_batchSize = NoiseProgram::s_batchSize;
+	const size_t s_histogramBins = 32;
+
+	struct RawResult
+	{
+		double samples2dPerSecond = 0.0;
+		double samples3dPerSecond = 0.0;
+	};
+
+	struct TerrainResult
+	{
+		std::vector<float> heights;
+		double voxelsPerSecond = 0.0;
+		double solidFraction = 0.0;
+	};
+
+	struct Statistics
+	{
+		double mean = 0.0;
+		double deviation = 0.0;
+		double roughness = 0.0;		//mean absolute height difference between neighbouring columns
+		std::vector<double> histogram;
+	};
+
+	template<typename Func>
+	double measureSeconds(Func&& func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	RawResult measureRaw(NoiseBackend& backend, size_t sampleCount)
+	{
+		std::vector<float> xs(sampleCount), ys(sampleCount), zs(sampleCount), out(s_batchSize);
+		uint32_t state = 12345;
+		auto next = [&state]() {
+			state = state * 1664525u + 1013904223u;
+			return static_cast<float>(state >> 8) / 16777216.0f * 8192.0f - 4096.0f;
+			};
+		for (size_t i = 0; i < sampleCount; ++i)
+		{
+			xs[i] = next();
+			ys[i] = next();
+			zs[i] = next();
+		}
+
+		//the sink keeps the optimizer from dropping the work
+		volatile float sink = 0.0f;
+		RawResult result;
+		double seconds2d = measureSeconds([&]() {
+			for (size_t i = 0; i < sampleCount; i += s_batchSize)
+			{
+				size_t count = std::min(s_batchSize, sampleCount - i);
+				backend.fbm2d(xs.data() + i, zs.data() + i, out.data(), count, 3, 0.02f);
+				sink = sink + out[0];
+			}
+			});
+		double seconds3d = measureSeconds([&]() {
+			for (size_t i = 0; i < sampleCount; i += s_batchSize)
+			{
+				size_t count = std::min(s_batchSize, sampleCount - i);
+				backend.fbm3d(xs.data() + i, ys.data() + i, zs.data() + i, out.data(), count, 3, 0.04f);
+				sink = sink + out[0];
+			}
+			});
+		result.samples2dPerSecond = sampleCount / seconds2d;
+		result.samples3dPerSecond = sampleCount / seconds3d;
+		return result;
+	}
+
+	//the height of a column is its topmost solid voxel, caves below it only affect the solid fraction
+	TerrainResult evaluateTerrain(NoiseProgram& program, size_t width, int32_t yMin, int32_t yMax)
+	{
+		TerrainResult result;
+		result.heights.assign(width * width, static_cast<float>(yMin - 1));
+
+		NoiseProgram::Workspace workspace;
+		program.prepare(workspace);
+		float xs[s_batchSize], ys[s_batchSize], zs[s_batchSize];
+		size_t solid = 0;
+
+		double seconds = measureSeconds([&]() {
+			for (size_t blockZ = 0; blockZ < width; blockZ += 16)
+				for (size_t blockX = 0; blockX < width; blockX += 16)
+				{
+					for (size_t i = 0; i < s_batchSize; ++i)
+					{
+						xs[i] = static_cast<float>(blockX + i % 16);
+						zs[i] = static_cast<float>(blockZ + i / 16);
+					}
+					program.run(NoiseProgram::Section::Invariant, xs, ys, zs, s_batchSize, workspace);
+
+					for (int32_t y = yMin; y <= yMax; ++y)
+					{
+						std::fill(std::begin(ys), std::end(ys), static_cast<float>(y));
+						program.run(NoiseProgram::Section::Varying, xs, ys, zs, s_batchSize, workspace);
+						const float* output = program.getOutput(workspace);
+						for (size_t i = 0; i < s_batchSize; ++i)
+						{
+							if (std::lround(output[i]) <= 0)
+								continue;
+							++solid;
+							size_t column = (blockZ + i / 16) * width + blockX + i % 16;
+							result.heights[column] = static_cast<float>(y);
+						}
+					}
+				}
+			});
+
+		double voxels = static_cast<double>(width) * width * (yMax - yMin + 1);
+		result.voxelsPerSecond = voxels / seconds;
+		result.solidFraction = solid / voxels;
+		return result;
+	}
+
+	Statistics computeStatistics(const std::vector<float>& heights, size_t width, float minHeight, float maxHeight)
+	{
+		Statistics statistics;
+		statistics.histogram.assign(s_histogramBins, 0.0);
+
+		for (auto height : heights)
+		{
+			statistics.mean += height;
+			size_t bin = static_cast<size_t>((height - minHeight) / (maxHeight - minHeight + 1.0f) * s_histogramBins);
+			statistics.histogram[std::min(bin, s_histogramBins - 1)] += 1.0 / heights.size();
+		}
+		statistics.mean /= heights.size();
+
+		for (auto height : heights)
+			statistics.deviation += (height - statistics.mean) * (height - statistics.mean);
+		statistics.deviation = std::sqrt(statistics.deviation / heights.size());
+
+		size_t pairs = 0;
+		for (size_t z = 0; z < width; ++z)
+			for (size_t x = 0; x + 1 < width; ++x, ++pairs)
+				statistics.roughness += std::abs(heights[z * width + x + 1] - heights[z * width + x]);
+		for (size_t z = 0; z + 1 < width; ++z)
+			for (size_t x = 0; x < width; ++x, ++pairs)
+				statistics.roughness += std::abs(heights[(z + 1) * width + x] - heights[z * width + x]);
+		statistics.roughness /= pairs;
+		return statistics;
+	}
+
+	double histogramIntersection(const Statistics& a, const Statistics& b)
+	{
+		double intersection = 0.0;
+		for (size_t i = 0; i < s_histogramBins; ++i)
+			intersection += std::min(a.histogram[i], b.histogram[i]);
+		return intersection;
+	}
+
+	double correlation(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		double meanA = 0.0, meanB = 0.0;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			meanA += a[i];
+			meanB += b[i];
+		}
+		meanA /= a.size();
+		meanB /= b.size();
+
+		double covariance = 0.0, varianceA = 0.0, varianceB = 0.0;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			covariance += (a[i] - meanA) * (b[i] - meanB);
+			varianceA += (a[i] - meanA) * (a[i] - meanA);
+			varianceB += (b[i] - meanB) * (b[i] - meanB);
+		}
+		if (varianceA == 0.0 || varianceB == 0.0)
+			return 0.0;
+		return covariance / std::sqrt(varianceA * varianceB);
+	}
+
+	//a grayscale heightmap for eyeballing the terrain of each backend
+	void writePgm(const std::string& path, const std::vector<float>& heights, size_t width,
+		float minHeight, float maxHeight)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+			throw std::runtime_error("Failed to open " + path);
+		file << "P5\n" << width << " " << width << "\n255\n";
+		for (auto height : heights)
+		{
+			float normalized = std::clamp((height - minHeight) / (maxHeight - minHeight), 0.0f, 1.0f);
+			file.put(static_cast<char>(static_cast<uint8_t>(normalized * 255.0f)));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string graphPath = argc > 1 ? argv[1] : "res/resourcePack/generators/terrain.json";
+	size_t width = argc > 2 ? std::stoul(argv[2]) : 256;
+	size_t sampleCount = argc > 3 ? std::stoul(argv[3]) : 1 << 22;
+	width = std::max<size_t>(16, width / 16 * 16);
+
+	const int32_t yMin = 160;
+	const int32_t yMax = 240;
+	const NoiseProgram::SeedType seed = 1234;
+
+	NoiseProgram program = NoiseGraph::compileFromFile(graphPath);
+	std::cout << "Graph " << graphPath << ": " << program.getInstructionCount() << " instructions, "
+		<< program.getRegisterCount() << " registers" << std::endl;
+	std::cout << "Region " << width << "x" << width << " columns, y " << yMin << ".." << yMax
+		<< ", raw samples " << sampleCount << std::endl << std::endl;
+
+	std::vector<TerrainResult> terrains;
+	std::vector<Statistics> statistics;
+
+	std::cout << std::left << std::setw(10) << "Backend" << std::setw(16) << "fbm2d Ms/s"
+		<< std::setw(16) << "fbm3d Ms/s" << std::setw(18) << "terrain Mvox/s" << std::setw(10) << "solid"
+		<< std::setw(10) << "mean" << std::setw(10) << "stddev" << "roughness" << std::endl;
+
+	for (size_t type = 0; type < enumCast(NoiseBackend::Type::Num); ++type)
+	{
+		auto backendType = static_cast<NoiseBackend::Type>(type);
+		auto backend = NoiseBackend::create(backendType);
+		backend->setSeed(seed);
+		auto raw = measureRaw(*backend, sampleCount);
+
+		program.setBackend(backendType);
+		program.setSeed(seed);
+		terrains.push_back(evaluateTerrain(program, width, yMin, yMax));
+		statistics.push_back(computeStatistics(terrains.back().heights, width,
+			static_cast<float>(yMin - 1), static_cast<float>(yMax)));
+
+		const auto& terrain = terrains.back();
+		const auto& stats = statistics.back();
+		std::cout << std::left << std::setw(10) << NoiseBackend::typeToString(backendType)
+			<< std::setw(16) << raw.samples2dPerSecond / 1e6 << std::setw(16) << raw.samples3dPerSecond / 1e6
+			<< std::setw(18) << terrain.voxelsPerSecond / 1e6 << std::setw(10) << terrain.solidFraction
+			<< std::setw(10) << stats.mean << std::setw(10) << stats.deviation << stats.roughness << std::endl;
+
+		std::string imagePath = "heightmap_" + std::string(NoiseBackend::typeToString(backendType)) + ".pgm";
+		writePgm(imagePath, terrain.heights, width, static_cast<float>(yMin), static_cast<float>(yMax));
+	}
+
+	//the lattices differ, so per column correlation is expected to be low, the distribution
+	//measures tell whether the terrain has the same character
+	std::cout << std::endl << "Similarity to " << NoiseBackend::typeToString(NoiseBackend::Type::Perlin) << ":" << std::endl;
+	for (size_t type = 1; type < terrains.size(); ++type)
+	{
+		std::cout << "- " << NoiseBackend::typeToString(static_cast<NoiseBackend::Type>(type))
+			<< ": height histogram overlap " << histogramIntersection(statistics[0], statistics[type])
+			<< ", stddev ratio " << statistics[type].deviation / statistics[0].deviation
+			<< ", roughness ratio " << statistics[type].roughness / statistics[0].roughness
+			<< ", solid fraction delta " << terrains[type].solidFraction - terrains[0].solidFraction
+			<< ", column correlation " << correlation(terrains[0].heights, terrains[type].heights) << std::endl;
+	}
+	std::cout << "Heightmaps written to heightmap_<backend>.pgm" << std::endl;
+	return 0;
+}
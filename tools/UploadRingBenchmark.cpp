@@ -0,0 +1,204 @@
+#include "Rendering/StagingRing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//checks the staging ring the renderer uploads chunks through and measures it under the renderer's
+//access pattern, worker threads write regions while a frame loop batches, checks and retires them
+//one frame late as the gpu would, runs headless,
+//usage: UploadRingBenchmark [threads] [uploads per thread] [ring size in KiB]
+
+namespace
+{
+	bool check(const char* name, size_t result, size_t expected)
+	{
+		bool passed = result == expected;
+		std::cout << (passed ? "[pass] " : "[FAIL] ") << name << ": " << result;
+		if (!passed)
+			std::cout << ", expected " << expected;
+		std::cout << std::endl;
+		return passed;
+	}
+
+	bool runChecks()
+	{
+		bool passed = true;
+		std::vector<std::byte> memory(1024);
+		StagingRing ring;
+		ring.init(memory.data(), memory.size());
+
+		StagingRing::Region a, b, c;
+		passed &= check("first region fits", ring.tryAllocate(400, 16, a) ? 1 : 0, 1);
+		passed &= check("second region fits", ring.tryAllocate(400, 16, b) ? 1 : 0, 1);
+		passed &= check("second region offset", b.offset, 400);
+		passed &= check("full ring refuses", ring.tryAllocate(400, 16, c) ? 1 : 0, 0);
+
+		//the second region retires first but the first one still holds the ring's front
+		uint64_t sequence = b.sequence;
+		ring.retire(ring.closeBatch(std::span(&sequence, 1)));
+		passed &= check("space held by an earlier open region", ring.getStats().used, 800);
+		sequence = a.sequence;
+		ring.retire(ring.closeBatch(std::span(&sequence, 1)));
+		passed &= check("space after retiring both", ring.getStats().used, 0);
+
+		//a region that does not fit before the end wraps to the start and charges the skipped end
+		passed &= check("region before the wrap", ring.tryAllocate(700, 16, a) ? 1 : 0, 1);
+		sequence = a.sequence;
+		uint64_t first = ring.closeBatch(std::span(&sequence, 1));
+		passed &= check("region behind the tail", ring.tryAllocate(200, 16, b) ? 1 : 0, 1);
+		passed &= check("region behind the tail offset", b.offset, 704);
+		ring.retire(first);
+		passed &= check("wrapped region", ring.tryAllocate(500, 16, c) ? 1 : 0, 1);
+		passed &= check("wrapped region offset", c.offset, 0);
+		passed &= check("wrapped region charge", ring.getStats().used, 204 + 1024 - 904 + 500);
+		std::array<uint64_t, 2> sequences = { b.sequence, c.sequence };
+		ring.retire(ring.closeBatch(sequences));
+		passed &= check("space after the wrap", ring.getStats().used, 0);
+
+		bool threw = false;
+		try { ring.allocate(2048, 16, a); }
+		catch (const std::runtime_error&) { threw = true; }
+		passed &= check("oversized region throws", threw ? 1 : 0, 1);
+
+		//a writer blocked on a full ring is released by the cancel instead of a retire
+		passed &= check("region filling the ring", ring.tryAllocate(1000, 16, a) ? 1 : 0, 1);
+		size_t waits = ring.getStats().waits;
+		std::atomic<int> blocked = -1;
+		std::thread writer([&]() { blocked = ring.allocate(500, 16, b) ? 1 : 0; });
+		while (ring.getStats().waits == waits)
+			std::this_thread::yield();
+		ring.cancel();
+		writer.join();
+		passed &= check("blocked allocation cancelled", static_cast<size_t>(blocked.load()), 0);
+		passed &= check("allocation after the cancel", ring.tryAllocate(16, 16, c) ? 1 : 0, 0);
+		return passed;
+	}
+
+	struct Written
+	{
+		StagingRing::Region region;
+		size_t size = 0;
+		uint8_t pattern = 0;
+	};
+
+	//workers fill regions with a pattern, the frame loop checks every region of a batch when it
+	//closes it and once more just before retiring it a frame later, an overwrite shows as a mismatch
+	bool runStress(size_t threadCount, size_t uploads, size_t ringSize)
+	{
+		std::vector<std::byte> memory(ringSize);
+		StagingRing ring;
+		ring.init(memory.data(), memory.size());
+
+		std::mutex pendingLock;
+		std::vector<Written> pending;
+		std::atomic<size_t> finished = 0;
+		std::atomic<size_t> bytes = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+			threads.emplace_back([&, t]() {
+				uint32_t seed = static_cast<uint32_t>(t) * 2654435761u + 1;
+				for (size_t i = 0; i < uploads; ++i)
+				{
+					seed = seed * 1664525u + 1013904223u;
+					//records of a chunk, from a few faces to a dense one
+					size_t size = 64 + (seed >> 8) % (ringSize / 8);
+					Written written;
+					written.size = size;
+					written.pattern = static_cast<uint8_t>(seed >> 24);
+					if (!ring.allocate(size, 16, written.region))
+						throw std::runtime_error("Upload ring cancelled");
+					std::memset(written.region.data, written.pattern, size);
+					bytes += size;
+
+					std::lock_guard<std::mutex> lock(pendingLock);
+					pending.push_back(written);
+				}
+				++finished;
+				});
+
+		auto isIntact = [](const Written& written) {
+			for (size_t i = 0; i < written.size; ++i)
+				if (written.region.data[i] != static_cast<std::byte>(written.pattern))
+					return false;
+			return true;
+			};
+
+		size_t mismatches = 0, frames = 0, uploaded = 0;
+		std::vector<Written> batch, inFlight;
+		std::vector<uint64_t> sequences;
+		uint64_t inFlightBatch = 0;
+		while (true)
+		{
+			bool isDone = finished == threadCount;
+			{
+				std::lock_guard<std::mutex> lock(pendingLock);
+				std::swap(batch, pending);
+			}
+
+			//the previous frame's copies finished
+			for (const auto& written : inFlight)
+				mismatches += isIntact(written) ? 0 : 1;
+			if (inFlightBatch != 0)
+				ring.retire(inFlightBatch);
+
+			sequences.clear();
+			for (const auto& written : batch)
+			{
+				mismatches += isIntact(written) ? 0 : 1;
+				sequences.push_back(written.region.sequence);
+			}
+			inFlightBatch = batch.empty() ? 0 : ring.closeBatch(sequences);
+			uploaded += batch.size();
+			std::swap(inFlight, batch);
+			batch.clear();
+			++frames;
+
+			if (isDone && inFlightBatch == 0)
+				break;
+		}
+		for (auto& thread : threads)
+			thread.join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		auto stats = ring.getStats();
+		std::cout << threadCount << " threads, " << uploads << " uploads each, " << ringSize / 1024 << " KiB ring" << std::endl;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "uploaded " << bytes / (1024.0 * 1024.0) / seconds << " MiB/s over " << frames << " frames, peak "
+			<< stats.peak * 100.0 / stats.capacity << "% of the ring, " << stats.waits << " full waits" << std::endl;
+
+		bool passed = true;
+		passed &= check("uploads batched", uploaded, threadCount * uploads);
+		passed &= check("regions overwritten before retiring", mismatches, 0);
+		passed &= check("ring space left in use", stats.used, 0);
+		return passed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t threadCount = argc > 1 ? std::stoul(argv[1]) : std::max<size_t>(1, std::thread::hardware_concurrency());
+	size_t uploads = argc > 2 ? std::stoul(argv[2]) : 2000;
+	size_t ringSize = (argc > 3 ? std::stoul(argv[3]) : 1024) * 1024;
+	threadCount = std::max<size_t>(1, threadCount);
+	ringSize = std::max<size_t>(4096, ringSize);
+
+	if (!runChecks() || !runStress(threadCount, uploads, ringSize))
+	{
+		std::cerr << "Upload ring checks failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,807 @@
+#include "Rendering/StagingRing.h"
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//drives the staging ring through a real vulkan device the way the renderer does, with two frames
+//in flight the records of every frame are written into the ring, copied by an upload submit behind
+//the same barriers the renderer records, read by the vertex shader of the draw submit and checked
+//in the rendered image, batches are retired once their upload fence signaled and have to retire in
+//order, meant for a software driver with the validation layers, for example
+//VK_ICD_FILENAMES=<lavapipe or swiftshader icd json>, any validation message fails the test,
+//usage: UploadRingVulkanTest [frames] [--no-validation]
+
+namespace
+{
+	const uint32_t s_width = 64;
+	const size_t s_framesInFlight = 2;
+	const size_t s_ringSize = 1024;		//small enough to wrap every few frames and to fill up now and then
+	const size_t s_uploadsPerFrame = 3;
+	const uint32_t s_maxRecordsPerUpload = 48;
+	const size_t s_maxRecordsPerFrame = s_uploadsPerFrame * s_maxRecordsPerUpload;
+
+	//#version 450
+	//layout(set = 0, binding = 0) readonly buffer Records { uint records[]; };
+	//void main()
+	//{
+	//	float x = (float(records[gl_InstanceIndex]) + 0.5) * (2.0 / 64.0) - 1.0;
+	//	gl_Position = vec4(x, 0.0, 0.0, 1.0);
+	//	gl_PointSize = 1.0;
+	//}
+	//reads the records at gl_InstanceIndex like Voxel.vert, so firstInstance selects the upload
+	const uint32_t s_vertexShader[] =
+	{
+		0x07230203, 0x00010000, 0x00000000, 0x00000025, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+		0x00000000, 0x00000001, 0x0007000f, 0x00000000, 0x00000001, 0x6e69616d, 0x00000000, 0x00000011,
+		0x0000000e, 0x00040047, 0x0000000e, 0x0000000b, 0x0000002b, 0x00050048, 0x0000000f, 0x00000000,
+		0x0000000b, 0x00000000, 0x00050048, 0x0000000f, 0x00000001, 0x0000000b, 0x00000001, 0x00030047,
+		0x0000000f, 0x00000002, 0x00040047, 0x00000008, 0x00000006, 0x00000004, 0x00040048, 0x00000009,
+		0x00000000, 0x00000018, 0x00050048, 0x00000009, 0x00000000, 0x00000023, 0x00000000, 0x00030047,
+		0x00000009, 0x00000003, 0x00040047, 0x0000000b, 0x00000022, 0x00000000, 0x00040047, 0x0000000b,
+		0x00000021, 0x00000000, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016,
+		0x00000004, 0x00000020, 0x00040015, 0x00000005, 0x00000020, 0x00000000, 0x00040015, 0x00000006,
+		0x00000020, 0x00000001, 0x00040017, 0x00000007, 0x00000004, 0x00000004, 0x0003001d, 0x00000008,
+		0x00000005, 0x0003001e, 0x00000009, 0x00000008, 0x00040020, 0x0000000a, 0x00000002, 0x00000009,
+		0x00040020, 0x0000000c, 0x00000002, 0x00000005, 0x00040020, 0x0000000d, 0x00000001, 0x00000006,
+		0x0004001e, 0x0000000f, 0x00000007, 0x00000004, 0x00040020, 0x00000010, 0x00000003, 0x0000000f,
+		0x00040020, 0x00000012, 0x00000003, 0x00000007, 0x00040020, 0x00000013, 0x00000003, 0x00000004,
+		0x0004002b, 0x00000006, 0x00000014, 0x00000000, 0x0004002b, 0x00000006, 0x00000015, 0x00000001,
+		0x0004002b, 0x00000004, 0x00000016, 0x00000000, 0x0004002b, 0x00000004, 0x00000017, 0x3f800000,
+		0x0004002b, 0x00000004, 0x00000018, 0x3f000000, 0x0004002b, 0x00000004, 0x00000019, 0x3d000000,
+		0x0004003b, 0x0000000a, 0x0000000b, 0x00000002, 0x0004003b, 0x0000000d, 0x0000000e, 0x00000001,
+		0x0004003b, 0x00000010, 0x00000011, 0x00000003, 0x00050036, 0x00000002, 0x00000001, 0x00000000,
+		0x00000003, 0x000200f8, 0x0000001a, 0x0004003d, 0x00000006, 0x0000001b, 0x0000000e, 0x00060041,
+		0x0000000c, 0x0000001c, 0x0000000b, 0x00000014, 0x0000001b, 0x0004003d, 0x00000005, 0x0000001d,
+		0x0000001c, 0x00040070, 0x00000004, 0x0000001e, 0x0000001d, 0x00050081, 0x00000004, 0x0000001f,
+		0x0000001e, 0x00000018, 0x00050085, 0x00000004, 0x00000020, 0x0000001f, 0x00000019, 0x00050083,
+		0x00000004, 0x00000021, 0x00000020, 0x00000017, 0x00070050, 0x00000007, 0x00000022, 0x00000021,
+		0x00000016, 0x00000016, 0x00000017, 0x00050041, 0x00000012, 0x00000023, 0x00000011, 0x00000014,
+		0x0003003e, 0x00000023, 0x00000022, 0x00050041, 0x00000013, 0x00000024, 0x00000011, 0x00000015,
+		0x0003003e, 0x00000024, 0x00000017, 0x000100fd, 0x00010038,
+	};
+
+	//#version 450
+	//layout(location = 0) out vec4 color;
+	//void main() { color = vec4(1.0); }
+	const uint32_t s_fragmentShader[] =
+	{
+		0x07230203, 0x00010000, 0x00000000, 0x0000000b, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+		0x00000000, 0x00000001, 0x0006000f, 0x00000004, 0x00000001, 0x6e69616d, 0x00000000, 0x00000007,
+		0x00030010, 0x00000001, 0x00000007, 0x00040047, 0x00000007, 0x0000001e, 0x00000000, 0x00020013,
+		0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016, 0x00000004, 0x00000020, 0x00040017,
+		0x00000005, 0x00000004, 0x00000004, 0x00040020, 0x00000006, 0x00000003, 0x00000005, 0x0004002b,
+		0x00000004, 0x00000008, 0x3f800000, 0x0007002c, 0x00000005, 0x00000009, 0x00000008, 0x00000008,
+		0x00000008, 0x00000008, 0x0004003b, 0x00000006, 0x00000007, 0x00000003, 0x00050036, 0x00000002,
+		0x00000001, 0x00000000, 0x00000003, 0x000200f8, 0x0000000a, 0x0003003e, 0x00000007, 0x00000009,
+		0x000100fd, 0x00010038,
+	};
+
+	bool check(const char* name, size_t result, size_t expected)
+	{
+		bool passed = result == expected;
+		std::cout << (passed ? "[pass] " : "[FAIL] ") << name << ": " << result;
+		if (!passed)
+			std::cout << ", expected " << expected;
+		std::cout << std::endl;
+		return passed;
+	}
+
+	void vkCheck(VkResult result, const char* call)
+	{
+		if (result != VK_SUCCESS)
+			throw std::runtime_error(std::string(call) + " failed with " + std::to_string(result));
+	}
+
+	size_t s_validationMessages = 0;
+
+	VKAPI_ATTR VkBool32 VKAPI_CALL onValidationMessage(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		VkDebugUtilsMessageTypeFlagsEXT, const VkDebugUtilsMessengerCallbackDataEXT* data, void*)
+	{
+		if (severity & (VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT))
+		{
+			s_validationMessages++;
+			std::cerr << "validation: " << data->pMessage << std::endl;
+		}
+		return VK_FALSE;
+	}
+
+	struct Buffer
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		std::byte* mapping = nullptr;
+	};
+
+	//one per frame in flight, like the renderer's frame data
+	struct Frame
+	{
+		VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer drawCommandBuffer = VK_NULL_HANDLE;
+		VkFence uploadFence = VK_NULL_HANDLE;
+		VkFence inFlightFence = VK_NULL_HANDLE;
+		uint64_t uploadBatch = 0;
+
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		Buffer readback;
+
+		bool isSubmitted = false;
+		std::array<bool, s_width> expected = {};
+	};
+
+	//an upload waiting for ring space, stays queued across frames while the ring is full
+	struct Upload
+	{
+		std::vector<uint32_t> records;
+		StagingRing::Region region;
+	};
+
+	class Test
+	{
+	private:
+		bool m_validate;
+		VkInstance m_instance = VK_NULL_HANDLE;
+		VkDebugUtilsMessengerEXT m_messenger = VK_NULL_HANDLE;
+		VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+		VkDevice m_device = VK_NULL_HANDLE;
+		uint32_t m_queueFamily = 0;
+		VkQueue m_queue = VK_NULL_HANDLE;
+
+		Buffer m_ring;
+		Buffer m_records;
+		StagingRing m_uploadRing;
+
+		VkRenderPass m_renderPass = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+		VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+		VkPipeline m_pipeline = VK_NULL_HANDLE;
+		VkCommandPool m_commandPool = VK_NULL_HANDLE;
+		std::array<Frame, s_framesInFlight> m_frames;
+
+	public:
+		Test(bool validate) : m_validate(validate) {}
+		Test(const Test&) = delete;
+		Test& operator=(const Test&) = delete;
+
+		~Test()
+		{
+			if (m_device != VK_NULL_HANDLE)
+			{
+				vkDeviceWaitIdle(m_device);
+				for (auto& frame : m_frames)
+				{
+					vkDestroyFence(m_device, frame.uploadFence, nullptr);
+					vkDestroyFence(m_device, frame.inFlightFence, nullptr);
+					vkDestroyFramebuffer(m_device, frame.framebuffer, nullptr);
+					vkDestroyImageView(m_device, frame.imageView, nullptr);
+					vkDestroyImage(m_device, frame.image, nullptr);
+					vkFreeMemory(m_device, frame.imageMemory, nullptr);
+					destroyBuffer(frame.readback);
+				}
+				vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+				vkDestroyPipeline(m_device, m_pipeline, nullptr);
+				vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+				vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+				vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+				vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+				destroyBuffer(m_records);
+				destroyBuffer(m_ring);
+				vkDestroyDevice(m_device, nullptr);
+			}
+			if (m_messenger != VK_NULL_HANDLE)
+			{
+				auto destroyMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+					vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT"));
+				destroyMessenger(m_instance, m_messenger, nullptr);
+			}
+			if (m_instance != VK_NULL_HANDLE)
+				vkDestroyInstance(m_instance, nullptr);
+		}
+
+		void init()
+		{
+			createInstance();
+			createDevice();
+
+			m_ring = createBuffer(s_ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_uploadRing.init(m_ring.mapping, s_ringSize);
+			//every frame copies its records to the start, so each upload overwrites what the
+			//previous frame may still be drawing from, as pool regions freed and reused do
+			m_records = createBuffer(s_maxRecordsPerFrame * sizeof(uint32_t),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			createPipeline();
+			createFrames();
+		}
+
+		bool run(size_t frameCount)
+		{
+			std::mt19937 generator(7);
+			std::vector<Upload> pending;
+			size_t deferred = 0, mismatches = 0, checkedFrames = 0;
+			uint64_t lastBatch = 0;
+			bool retiredInOrder = true;
+
+			//the last frames in flight only get waited on and checked
+			for (size_t frameIndex = 0; frameIndex < frameCount + s_framesInFlight; frameIndex++)
+			{
+				Frame& frame = m_frames[frameIndex % s_framesInFlight];
+				vkCheck(vkWaitForFences(m_device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+				if (frame.uploadBatch != 0)
+				{
+					vkCheck(vkWaitForFences(m_device, 1, &frame.uploadFence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+					retiredInOrder &= frame.uploadBatch > lastBatch;
+					lastBatch = frame.uploadBatch;
+					m_uploadRing.retire(frame.uploadBatch);
+					frame.uploadBatch = 0;
+				}
+				if (frame.isSubmitted)
+				{
+					mismatches += compareImage(frame);
+					checkedFrames++;
+					frame.isSubmitted = false;
+				}
+				if (frameIndex >= frameCount)
+					continue;
+
+				while (pending.size() < s_uploadsPerFrame)
+				{
+					Upload upload;
+					upload.records.resize(1 + generator() % s_maxRecordsPerUpload);
+					for (auto& record : upload.records)
+						record = generator() % s_width;
+					pending.push_back(std::move(upload));
+				}
+
+				//takes what fits, the rest waits for the next frame as a worker would wait on allocate
+				std::vector<Upload> uploads;
+				for (auto it = pending.begin(); it != pending.end();)
+				{
+					size_t size = it->records.size() * sizeof(uint32_t);
+					if (!m_uploadRing.tryAllocate(size, 16, it->region))
+					{
+						deferred++;
+						break;
+					}
+					std::memcpy(it->region.data, it->records.data(), size);
+					uploads.push_back(std::move(*it));
+					it = pending.erase(it);
+				}
+
+				vkCheck(vkResetFences(m_device, 1, &frame.inFlightFence), "vkResetFences");
+				submitFrame(frame, uploads);
+			}
+
+			bool passed = true;
+			passed &= check("frames checked", checkedFrames, frameCount);
+			passed &= check("pixels differing from the uploaded records", mismatches, 0);
+			passed &= check("batches retired in order", retiredInOrder ? 1 : 0, 1);
+			passed &= check("ring space still in use", m_uploadRing.getStats().used, 0);
+			passed &= check("uploads deferred on a full ring > 0", deferred > 0 ? 1 : 0, 1);
+			passed &= check("validation messages", s_validationMessages, 0);
+			return passed;
+		}
+
+	private:
+		void createInstance()
+		{
+			std::vector<const char*> layers;
+			std::vector<const char*> extensions;
+			if (m_validate)
+			{
+				uint32_t count = 0;
+				vkEnumerateInstanceLayerProperties(&count, nullptr);
+				std::vector<VkLayerProperties> available(count);
+				vkEnumerateInstanceLayerProperties(&count, available.data());
+				bool found = false;
+				for (const auto& layer : available)
+					found |= std::strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation") == 0;
+				if (!found)
+					throw std::runtime_error("VK_LAYER_KHRONOS_validation is not installed, "
+						"install the validation layers or pass --no-validation");
+				layers.push_back("VK_LAYER_KHRONOS_validation");
+				extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+				extensions.push_back(VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+			}
+
+			VkApplicationInfo appInfo = {};
+			appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+			appInfo.pApplicationName = "UploadRingVulkanTest";
+			appInfo.apiVersion = VK_API_VERSION_1_0;
+
+			//the ring's correctness rests on the barriers, so synchronization validation is on
+			VkValidationFeatureEnableEXT enabledFeature = VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT;
+			VkValidationFeaturesEXT features = {};
+			features.sType = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
+			features.enabledValidationFeatureCount = 1;
+			features.pEnabledValidationFeatures = &enabledFeature;
+
+			VkDebugUtilsMessengerCreateInfoEXT messengerInfo = {};
+			messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+			messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+				VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+			messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+				VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+			messengerInfo.pfnUserCallback = onValidationMessage;
+			//chained so instance creation and destruction are reported as well
+			messengerInfo.pNext = &features;
+
+			VkInstanceCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+			createInfo.pNext = m_validate ? &messengerInfo : nullptr;
+			createInfo.pApplicationInfo = &appInfo;
+			createInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+			createInfo.ppEnabledLayerNames = layers.data();
+			createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+			createInfo.ppEnabledExtensionNames = extensions.data();
+			vkCheck(vkCreateInstance(&createInfo, nullptr, &m_instance), "vkCreateInstance");
+
+			if (m_validate)
+			{
+				auto createMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+					vkGetInstanceProcAddr(m_instance, "vkCreateDebugUtilsMessengerEXT"));
+				messengerInfo.pNext = nullptr;
+				vkCheck(createMessenger(m_instance, &messengerInfo, nullptr, &m_messenger),
+					"vkCreateDebugUtilsMessengerEXT");
+			}
+		}
+
+		void createDevice()
+		{
+			uint32_t count = 0;
+			vkCheck(vkEnumeratePhysicalDevices(m_instance, &count, nullptr), "vkEnumeratePhysicalDevices");
+			if (count == 0)
+				throw std::runtime_error("No vulkan device, point VK_ICD_FILENAMES at lavapipe or swiftshader");
+			std::vector<VkPhysicalDevice> devices(count);
+			vkCheck(vkEnumeratePhysicalDevices(m_instance, &count, devices.data()), "vkEnumeratePhysicalDevices");
+			m_physicalDevice = devices[0];
+
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+			std::cout << "device: " << properties.deviceName
+				<< (m_validate ? ", validation on" : ", validation off") << std::endl;
+
+			vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &count, nullptr);
+			std::vector<VkQueueFamilyProperties> families(count);
+			vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &count, families.data());
+			m_queueFamily = count;
+			for (uint32_t i = 0; i < count && m_queueFamily == count; i++)
+				if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+					m_queueFamily = i;
+			if (m_queueFamily == count)
+				throw std::runtime_error("No graphics queue");
+
+			//uploads and draws share the graphics queue, as in the renderer
+			float priority = 1.0f;
+			VkDeviceQueueCreateInfo queueInfo = {};
+			queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueFamilyIndex = m_queueFamily;
+			queueInfo.queueCount = 1;
+			queueInfo.pQueuePriorities = &priority;
+
+			VkDeviceCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+			createInfo.queueCreateInfoCount = 1;
+			createInfo.pQueueCreateInfos = &queueInfo;
+			vkCheck(vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device), "vkCreateDevice");
+			vkGetDeviceQueue(m_device, m_queueFamily, 0, &m_queue);
+		}
+
+		uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+		{
+			VkPhysicalDeviceMemoryProperties memory;
+			vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memory);
+			for (uint32_t i = 0; i < memory.memoryTypeCount; i++)
+				if ((typeBits & (1u << i)) && (memory.memoryTypes[i].propertyFlags & properties) == properties)
+					return i;
+			throw std::runtime_error("No suitable memory type");
+		}
+
+		Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+		{
+			Buffer buffer;
+			VkBufferCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			createInfo.size = size;
+			createInfo.usage = usage;
+			createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			vkCheck(vkCreateBuffer(m_device, &createInfo, nullptr, &buffer.buffer), "vkCreateBuffer");
+
+			VkMemoryRequirements requirements;
+			vkGetBufferMemoryRequirements(m_device, buffer.buffer, &requirements);
+			VkMemoryAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocateInfo.allocationSize = requirements.size;
+			allocateInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+			vkCheck(vkAllocateMemory(m_device, &allocateInfo, nullptr, &buffer.memory), "vkAllocateMemory");
+			vkCheck(vkBindBufferMemory(m_device, buffer.buffer, buffer.memory, 0), "vkBindBufferMemory");
+
+			if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			{
+				void* mapping = nullptr;
+				vkCheck(vkMapMemory(m_device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &mapping), "vkMapMemory");
+				buffer.mapping = static_cast<std::byte*>(mapping);
+			}
+			return buffer;
+		}
+
+		void destroyBuffer(Buffer& buffer)
+		{
+			vkDestroyBuffer(m_device, buffer.buffer, nullptr);
+			vkFreeMemory(m_device, buffer.memory, nullptr);
+			buffer = Buffer();
+		}
+
+		VkShaderModule createShaderModule(const uint32_t* code, size_t size)
+		{
+			VkShaderModuleCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			createInfo.codeSize = size;
+			createInfo.pCode = code;
+			VkShaderModule module;
+			vkCheck(vkCreateShaderModule(m_device, &createInfo, nullptr, &module), "vkCreateShaderModule");
+			return module;
+		}
+
+		void createPipeline()
+		{
+			VkAttachmentDescription attachment = {};
+			attachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+			VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &colorReference;
+
+			//the image is rendered after the previous readback of it and read back after rendering
+			std::array<VkSubpassDependency, 2> dependencies = {};
+			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependencies[0].dstSubpass = 0;
+			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dependencies[1].srcSubpass = 0;
+			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			VkRenderPassCreateInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = 1;
+			renderPassInfo.pAttachments = &attachment;
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+			renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+			renderPassInfo.pDependencies = dependencies.data();
+			vkCheck(vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass), "vkCreateRenderPass");
+
+			VkDescriptorSetLayoutBinding binding = {};
+			binding.binding = 0;
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			binding.descriptorCount = 1;
+			binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+			setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			setLayoutInfo.bindingCount = 1;
+			setLayoutInfo.pBindings = &binding;
+			vkCheck(vkCreateDescriptorSetLayout(m_device, &setLayoutInfo, nullptr, &m_setLayout),
+				"vkCreateDescriptorSetLayout");
+
+			VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 };
+			VkDescriptorPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.maxSets = 1;
+			poolInfo.poolSizeCount = 1;
+			poolInfo.pPoolSizes = &poolSize;
+			vkCheck(vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool), "vkCreateDescriptorPool");
+
+			VkDescriptorSetAllocateInfo setInfo = {};
+			setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			setInfo.descriptorPool = m_descriptorPool;
+			setInfo.descriptorSetCount = 1;
+			setInfo.pSetLayouts = &m_setLayout;
+			vkCheck(vkAllocateDescriptorSets(m_device, &setInfo, &m_descriptorSet), "vkAllocateDescriptorSets");
+
+			VkDescriptorBufferInfo bufferInfo = { m_records.buffer, 0, VK_WHOLE_SIZE };
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = m_descriptorSet;
+			write.dstBinding = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.pBufferInfo = &bufferInfo;
+			vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+			VkPipelineLayoutCreateInfo layoutInfo = {};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layoutInfo.setLayoutCount = 1;
+			layoutInfo.pSetLayouts = &m_setLayout;
+			vkCheck(vkCreatePipelineLayout(m_device, &layoutInfo, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout");
+
+			VkShaderModule vertexShader = createShaderModule(s_vertexShader, sizeof(s_vertexShader));
+			VkShaderModule fragmentShader = createShaderModule(s_fragmentShader, sizeof(s_fragmentShader));
+			std::array<VkPipelineShaderStageCreateInfo, 2> stages = {};
+			stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+			stages[0].module = vertexShader;
+			stages[0].pName = "main";
+			stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+			stages[1].module = fragmentShader;
+			stages[1].pName = "main";
+
+			VkPipelineVertexInputStateCreateInfo vertexInput = {};
+			vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+			inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+			VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(s_width), 1.0f, 0.0f, 1.0f };
+			VkRect2D scissor = { { 0, 0 }, { s_width, 1 } };
+			VkPipelineViewportStateCreateInfo viewportState = {};
+			viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			viewportState.viewportCount = 1;
+			viewportState.pViewports = &viewport;
+			viewportState.scissorCount = 1;
+			viewportState.pScissors = &scissor;
+
+			VkPipelineRasterizationStateCreateInfo rasterization = {};
+			rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+			rasterization.cullMode = VK_CULL_MODE_NONE;
+			rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			rasterization.lineWidth = 1.0f;
+
+			VkPipelineMultisampleStateCreateInfo multisample = {};
+			multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+			VkPipelineColorBlendAttachmentState blendAttachment = {};
+			blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+				VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+			VkPipelineColorBlendStateCreateInfo blend = {};
+			blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			blend.attachmentCount = 1;
+			blend.pAttachments = &blendAttachment;
+
+			VkGraphicsPipelineCreateInfo pipelineInfo = {};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
+			pipelineInfo.pStages = stages.data();
+			pipelineInfo.pVertexInputState = &vertexInput;
+			pipelineInfo.pInputAssemblyState = &inputAssembly;
+			pipelineInfo.pViewportState = &viewportState;
+			pipelineInfo.pRasterizationState = &rasterization;
+			pipelineInfo.pMultisampleState = &multisample;
+			pipelineInfo.pColorBlendState = &blend;
+			pipelineInfo.layout = m_pipelineLayout;
+			pipelineInfo.renderPass = m_renderPass;
+			VkResult result = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline);
+			vkDestroyShaderModule(m_device, vertexShader, nullptr);
+			vkDestroyShaderModule(m_device, fragmentShader, nullptr);
+			vkCheck(result, "vkCreateGraphicsPipelines");
+		}
+
+		void createFrames()
+		{
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			poolInfo.queueFamilyIndex = m_queueFamily;
+			vkCheck(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool), "vkCreateCommandPool");
+
+			for (auto& frame : m_frames)
+			{
+				std::array<VkCommandBuffer, 2> commandBuffers;
+				VkCommandBufferAllocateInfo allocateInfo = {};
+				allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocateInfo.commandPool = m_commandPool;
+				allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+				vkCheck(vkAllocateCommandBuffers(m_device, &allocateInfo, commandBuffers.data()), "vkAllocateCommandBuffers");
+				frame.uploadCommandBuffer = commandBuffers[0];
+				frame.drawCommandBuffer = commandBuffers[1];
+
+				VkFenceCreateInfo fenceInfo = {};
+				fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+				vkCheck(vkCreateFence(m_device, &fenceInfo, nullptr, &frame.uploadFence), "vkCreateFence");
+				fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+				vkCheck(vkCreateFence(m_device, &fenceInfo, nullptr, &frame.inFlightFence), "vkCreateFence");
+
+				VkImageCreateInfo imageInfo = {};
+				imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+				imageInfo.extent = { s_width, 1, 1 };
+				imageInfo.mipLevels = 1;
+				imageInfo.arrayLayers = 1;
+				imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				vkCheck(vkCreateImage(m_device, &imageInfo, nullptr, &frame.image), "vkCreateImage");
+
+				VkMemoryRequirements requirements;
+				vkGetImageMemoryRequirements(m_device, frame.image, &requirements);
+				VkMemoryAllocateInfo memoryInfo = {};
+				memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				memoryInfo.allocationSize = requirements.size;
+				memoryInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				vkCheck(vkAllocateMemory(m_device, &memoryInfo, nullptr, &frame.imageMemory), "vkAllocateMemory");
+				vkCheck(vkBindImageMemory(m_device, frame.image, frame.imageMemory, 0), "vkBindImageMemory");
+
+				VkImageViewCreateInfo viewInfo = {};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = frame.image;
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+				viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				vkCheck(vkCreateImageView(m_device, &viewInfo, nullptr, &frame.imageView), "vkCreateImageView");
+
+				VkFramebufferCreateInfo framebufferInfo = {};
+				framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				framebufferInfo.renderPass = m_renderPass;
+				framebufferInfo.attachmentCount = 1;
+				framebufferInfo.pAttachments = &frame.imageView;
+				framebufferInfo.width = s_width;
+				framebufferInfo.height = 1;
+				framebufferInfo.layers = 1;
+				vkCheck(vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &frame.framebuffer), "vkCreateFramebuffer");
+
+				frame.readback = createBuffer(s_width * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			}
+		}
+
+		//records and submits the upload and the draw of one frame as Renderer::recordUploads and
+		//Renderer::drawFrame do
+		void submitFrame(Frame& frame, std::vector<Upload>& uploads)
+		{
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			VkCommandBuffer upload = frame.uploadCommandBuffer;
+			vkCheck(vkResetCommandBuffer(upload, 0), "vkResetCommandBuffer");
+			vkCheck(vkBeginCommandBuffer(upload, &beginInfo), "vkBeginCommandBuffer");
+			//the previous frame may still be drawing from the records being overwritten
+			vkCmdPipelineBarrier(upload, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr, 0, nullptr);
+			std::vector<VkBufferCopy> copies;
+			std::vector<uint64_t> sequences;
+			VkDeviceSize offset = 0;
+			for (const auto& entry : uploads)
+			{
+				VkDeviceSize size = entry.records.size() * sizeof(uint32_t);
+				copies.push_back({ entry.region.offset, offset, size });
+				sequences.push_back(entry.region.sequence);
+				offset += size;
+			}
+			if (!copies.empty())
+				vkCmdCopyBuffer(upload, m_ring.buffer, m_records.buffer, static_cast<uint32_t>(copies.size()), copies.data());
+			VkMemoryBarrier uploadBarrier = {};
+			uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			uploadBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(upload, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+				0, 1, &uploadBarrier, 0, nullptr, 0, nullptr);
+			vkCheck(vkEndCommandBuffer(upload), "vkEndCommandBuffer");
+			frame.uploadBatch = m_uploadRing.closeBatch(sequences);
+
+			VkCommandBuffer draw = frame.drawCommandBuffer;
+			vkCheck(vkResetCommandBuffer(draw, 0), "vkResetCommandBuffer");
+			vkCheck(vkBeginCommandBuffer(draw, &beginInfo), "vkBeginCommandBuffer");
+			VkClearValue clear = {};
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = m_renderPass;
+			renderPassInfo.framebuffer = frame.framebuffer;
+			renderPassInfo.renderArea = { { 0, 0 }, { s_width, 1 } };
+			renderPassInfo.clearValueCount = 1;
+			renderPassInfo.pClearValues = &clear;
+			vkCmdBeginRenderPass(draw, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindPipeline(draw, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+			vkCmdBindDescriptorSets(draw, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
+			frame.expected.fill(false);
+			for (size_t i = 0; i < uploads.size(); i++)
+			{
+				//one instance per record, firstInstance points at the upload's records
+				vkCmdDraw(draw, 1, static_cast<uint32_t>(uploads[i].records.size()), 0,
+					static_cast<uint32_t>(copies[i].dstOffset / sizeof(uint32_t)));
+				for (auto record : uploads[i].records)
+					frame.expected[record] = true;
+			}
+			vkCmdEndRenderPass(draw);
+
+			VkBufferImageCopy readback = {};
+			readback.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			readback.imageExtent = { s_width, 1, 1 };
+			vkCmdCopyImageToBuffer(draw, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame.readback.buffer, 1, &readback);
+			VkMemoryBarrier readbackBarrier = {};
+			readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(draw, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+				0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+			vkCheck(vkEndCommandBuffer(draw), "vkEndCommandBuffer");
+
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &upload;
+			vkCheck(vkQueueSubmit(m_queue, 1, &submitInfo, frame.uploadFence), "vkQueueSubmit");
+			submitInfo.pCommandBuffers = &draw;
+			vkCheck(vkQueueSubmit(m_queue, 1, &submitInfo, frame.inFlightFence), "vkQueueSubmit");
+			frame.isSubmitted = true;
+		}
+
+		//counts the pixels whose coverage does not match the records drawn
+		size_t compareImage(const Frame& frame)
+		{
+			size_t mismatches = 0;
+			for (uint32_t x = 0; x < s_width; x++)
+			{
+				bool isLit = frame.readback.mapping[x * 4] != std::byte(0);
+				mismatches += isLit != frame.expected[x];
+			}
+			return mismatches;
+		}
+	};
+}
+
+int main(int argc, char** argv)
+{
+	size_t frames = 64;
+	bool validate = true;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--no-validation")
+			validate = false;
+		else
+			frames = std::max<size_t>(s_framesInFlight, std::stoul(argument));
+	}
+
+	try
+	{
+		Test test(validate);
+		test.init();
+		if (!test.run(frames))
+		{
+			std::cerr << "Upload ring device checks failed" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}